@@ -0,0 +1,444 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_ALLOCATORS_H_
+#define AMLIB_ALLOCATORS_H_
+
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#  include <sys/mman.h>
+#  define AMLIB_HAS_POSIX_MEMALIGN
+#  if defined(__linux__) && defined(MAP_ANONYMOUS)
+#    define AMLIB_HAS_HUGE_PAGES
+#  endif
+#endif
+
+
+namespace am {
+
+
+/*************************************************************************//***
+ *
+ * @brief process-wide allocation counters
+ *
+ *****************************************************************************/
+struct allocation_stats
+{
+    /// currently allocated
+    std::size_t live_bytes = 0;
+    /// maximum of live_bytes since start or last reset_peak()
+    std::size_t peak_bytes = 0;
+    std::uint64_t allocations = 0;
+    std::uint64_t deallocations = 0;
+};
+
+
+
+/*************************************************************************//***
+ *
+ * @brief process-wide, thread-safe allocation counters;
+ *        different Tag types yield independent counter sets
+ *
+ *****************************************************************************/
+template<class Tag = void>
+class allocation_counter
+{
+    struct counters_ {
+        std::atomic<std::size_t> live {0};
+        std::atomic<std::size_t> peak {0};
+        std::atomic<std::uint64_t> allocs {0};
+        std::atomic<std::uint64_t> deallocs {0};
+    };
+
+    static counters_&
+    counters() noexcept {
+        static counters_ c;
+        return c;
+    }
+
+public:
+    //---------------------------------------------------------------
+    static void
+    allocated(std::size_t bytes) noexcept {
+        auto& c = counters();
+        c.allocs.fetch_add(1, std::memory_order_relaxed);
+        const auto live = c.live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        auto peak = c.peak.load(std::memory_order_relaxed);
+        while(peak < live &&
+              !c.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+        {}
+    }
+
+    //-----------------------------------------------------
+    static void
+    deallocated(std::size_t bytes) noexcept {
+        auto& c = counters();
+        c.deallocs.fetch_add(1, std::memory_order_relaxed);
+        c.live.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+
+    //---------------------------------------------------------------
+    static allocation_stats
+    snapshot() noexcept {
+        constexpr auto r = std::memory_order_relaxed;
+        const auto& c = counters();
+        allocation_stats s;
+        s.live_bytes = c.live.load(r);
+        s.peak_bytes = c.peak.load(r);
+        s.allocations = c.allocs.load(r);
+        s.deallocations = c.deallocs.load(r);
+        return s;
+    }
+
+    //-----------------------------------------------------
+    ///@brief sets the peak to the current number of live bytes
+    static void
+    reset_peak() noexcept {
+        auto& c = counters();
+        c.peak.store(c.live.load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+    }
+};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief allocator adapter that reports all allocations to
+ *        allocation_counter<Tag>
+ *
+ * @details Use it as Allocator parameter of maps to aggregate their node
+ *          memory process-wide, e.g. one Tag per subsystem:
+ *            using alloc = tracking_allocator<std::pair<const K,V>,my_tag>;
+ *            interpolating_map<K,V,I,std::less<K>,alloc> m;
+ *            allocation_counter<my_tag>::snapshot().live_bytes
+ *
+ * @tparam T         value type
+ * @tparam Tag       selects the counter set
+ * @tparam Upstream  allocator that provides the memory
+ *
+ *****************************************************************************/
+template<class T, class Tag = void, class Upstream = std::allocator<T>>
+class tracking_allocator
+{
+    using traits_ = std::allocator_traits<Upstream>;
+
+    template<class, class, class> friend class tracking_allocator;
+
+public:
+    //---------------------------------------------------------------
+    using value_type = T;
+    using upstream_type = Upstream;
+    using counter_type = allocation_counter<Tag>;
+
+    using propagate_on_container_copy_assignment =
+        typename traits_::propagate_on_container_copy_assignment;
+    using propagate_on_container_move_assignment =
+        typename traits_::propagate_on_container_move_assignment;
+    using propagate_on_container_swap =
+        typename traits_::propagate_on_container_swap;
+    using is_always_equal = std::is_empty<Upstream>;
+
+    template<class U>
+    struct rebind {
+        using other = tracking_allocator<U,Tag,
+                          typename traits_::template rebind_alloc<U>>;
+    };
+
+
+    //---------------------------------------------------------------
+    tracking_allocator() = default;
+
+    explicit
+    tracking_allocator(const Upstream& up): up_(up) {}
+
+    template<class U, class UpU>
+    tracking_allocator(const tracking_allocator<U,Tag,UpU>& other) noexcept:
+        up_(other.up_)
+    {}
+
+
+    //---------------------------------------------------------------
+    T*
+    allocate(std::size_t n) {
+        T* p = traits_::allocate(up_, n);
+        counter_type::allocated(n * sizeof(T));
+        return p;
+    }
+
+    //-----------------------------------------------------
+    void
+    deallocate(T* p, std::size_t n) noexcept {
+        counter_type::deallocated(n * sizeof(T));
+        traits_::deallocate(up_, p, n);
+    }
+
+
+    //---------------------------------------------------------------
+    const Upstream& upstream() const noexcept { return up_; }
+
+    //-----------------------------------------------------
+    template<class U, class UpU>
+    bool
+    operator == (const tracking_allocator<U,Tag,UpU>& o) const noexcept {
+        return up_ == o.up_;
+    }
+    template<class U, class UpU>
+    bool
+    operator != (const tracking_allocator<U,Tag,UpU>& o) const noexcept {
+        return !(*this == o);
+    }
+
+
+private:
+    Upstream up_;
+};
+
+
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief huge page backing of large allocations (Linux only)
+ *
+ *   none         regular pages
+ *   transparent  huge page aligned mapping + madvise(MADV_HUGEPAGE)
+ *   hugetlb      explicit huge pages (MAP_HUGETLB) if the system has
+ *                reserved some, 'transparent' otherwise
+ *
+ *****************************************************************************/
+enum class huge_pages {
+    none, transparent, hugetlb
+};
+
+/// allocations of at least this size are backed by huge pages
+constexpr std::size_t huge_page_size = std::size_t(1) << 21;
+
+
+
+
+namespace detail {
+
+//-------------------------------------------------------------------
+inline void*
+aligned_allocate(std::size_t bytes, std::size_t alignment)
+{
+#ifdef AMLIB_HAS_POSIX_MEMALIGN
+    //posix_memalign requires multiples of sizeof(void*)
+    if(alignment < sizeof(void*)) alignment = sizeof(void*);
+    void* p = nullptr;
+    if(::posix_memalign(&p, alignment, bytes > 0 ? bytes : 1) != 0) {
+        throw std::bad_alloc{};
+    }
+    return p;
+#else
+    //over-allocate; original pointer is stored in front of the block
+    void* raw = ::operator new(bytes + alignment + sizeof(void*));
+    auto a = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*);
+    a = (a + alignment - 1) & ~std::uintptr_t(alignment - 1);
+    reinterpret_cast<void**>(a)[-1] = raw;
+    return reinterpret_cast<void*>(a);
+#endif
+}
+
+//-----------------------------------------------------
+inline void
+aligned_deallocate(void* p) noexcept
+{
+#ifdef AMLIB_HAS_POSIX_MEMALIGN
+    std::free(p);
+#else
+    if(p) ::operator delete(static_cast<void**>(p)[-1]);
+#endif
+}
+
+
+#ifdef AMLIB_HAS_HUGE_PAGES
+//-------------------------------------------------------------------
+inline std::size_t
+huge_page_round(std::size_t bytes) noexcept {
+    return (bytes + huge_page_size - 1) & ~(huge_page_size - 1);
+}
+
+//-----------------------------------------------------
+inline void*
+huge_page_allocate(std::size_t bytes, bool hugetlb)
+{
+    const auto size = huge_page_round(bytes);
+    constexpr int prot = PROT_READ | PROT_WRITE;
+    constexpr int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+#ifdef MAP_HUGETLB
+    if(hugetlb) {
+        void* p = ::mmap(nullptr, size, prot, flags | MAP_HUGETLB, -1, 0);
+        if(p != MAP_FAILED) return p;
+    }
+#else
+    (void)hugetlb;
+#endif
+
+    //map one huge page more and trim to a huge page aligned range
+    const auto total = size + huge_page_size;
+    void* raw = ::mmap(nullptr, total, prot, flags, -1, 0);
+    if(raw == MAP_FAILED) throw std::bad_alloc{};
+
+    const auto b = reinterpret_cast<std::uintptr_t>(raw);
+    const auto a = (b + huge_page_size - 1) & ~std::uintptr_t(huge_page_size - 1);
+    if(a > b) ::munmap(raw, a - b);
+    const auto tail = (b + total) - (a + size);
+    if(tail > 0) ::munmap(reinterpret_cast<void*>(a + size), tail);
+
+    void* p = reinterpret_cast<void*>(a);
+#ifdef MADV_HUGEPAGE
+    ::madvise(p, size, MADV_HUGEPAGE);
+#endif
+    return p;
+}
+
+//-----------------------------------------------------
+inline void
+huge_page_deallocate(void* p, std::size_t bytes) noexcept {
+    ::munmap(p, huge_page_round(bytes));
+}
+#endif
+
+} // namespace detail
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief allocator with a minimum alignment (default: one cache line)
+ *        and optional huge page backing of large allocations
+ *
+ * @details Use it as Allocator parameter of maps, e.g.
+ *            interpolating_map<K,V,I,std::less<K>,huge_page_allocator<...>>
+ *          Aligned node arrays never split nodes of power-of-two size
+ *          across cache lines; huge pages reduce TLB misses of random
+ *          lookups in large tables. It can also serve as upstream of a
+ *          tracking_allocator.
+ *          Huge pages are only used for allocations of at least
+ *          huge_page_size bytes and only on Linux; everything else
+ *          is plain aligned heap memory.
+ *
+ * @tparam T          value type
+ * @tparam Alignment  minimum alignment in bytes (power of 2)
+ * @tparam Pages      huge page policy
+ *
+ *****************************************************************************/
+template<class T, std::size_t Alignment = 64,
+         huge_pages Pages = huge_pages::none>
+class aligned_allocator
+{
+    static_assert(Alignment > 0 && (Alignment & (Alignment - 1)) == 0,
+                  "alignment must be a power of 2");
+
+public:
+    //---------------------------------------------------------------
+    using value_type = T;
+
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+
+    template<class U>
+    struct rebind {
+        using other = aligned_allocator<U,Alignment,Pages>;
+    };
+
+    static constexpr std::size_t alignment =
+        Alignment > alignof(T) ? Alignment : alignof(T);
+
+    static constexpr huge_pages huge_page_policy = Pages;
+
+
+    //---------------------------------------------------------------
+    aligned_allocator() = default;
+
+    template<class U>
+    aligned_allocator(const aligned_allocator<U,Alignment,Pages>&) noexcept {}
+
+
+    //---------------------------------------------------------------
+    T*
+    allocate(std::size_t n) {
+        if(n > std::size_t(-1) / sizeof(T)) throw std::bad_alloc{};
+        const auto bytes = n * sizeof(T);
+#ifdef AMLIB_HAS_HUGE_PAGES
+        if(uses_huge_pages(bytes)) {
+            return static_cast<T*>(detail::huge_page_allocate(bytes,
+                Pages == huge_pages::hugetlb));
+        }
+#endif
+        return static_cast<T*>(detail::aligned_allocate(bytes, alignment));
+    }
+
+    //-----------------------------------------------------
+    void
+    deallocate(T* p, std::size_t n) noexcept {
+#ifdef AMLIB_HAS_HUGE_PAGES
+        if(uses_huge_pages(n * sizeof(T))) {
+            detail::huge_page_deallocate(p, n * sizeof(T));
+            return;
+        }
+#endif
+        detail::aligned_deallocate(p);
+    }
+
+
+    //---------------------------------------------------------------
+    /// true, if an allocation of 'bytes' is backed by huge pages
+    static constexpr bool
+    uses_huge_pages(std::size_t bytes) noexcept {
+#ifdef AMLIB_HAS_HUGE_PAGES
+        return Pages != huge_pages::none && bytes >= huge_page_size;
+#else
+        return (void)bytes, false;
+#endif
+    }
+
+
+    //---------------------------------------------------------------
+    template<class U>
+    bool
+    operator == (const aligned_allocator<U,Alignment,Pages>&) const noexcept {
+        return true;
+    }
+    template<class U>
+    bool
+    operator != (const aligned_allocator<U,Alignment,Pages>&) const noexcept {
+        return false;
+    }
+};
+
+
+
+//-------------------------------------------------------------------
+/// cache line aligned; large allocations backed by huge pages
+template<class T, huge_pages Pages = huge_pages::transparent>
+using huge_page_allocator = aligned_allocator<T,64,Pages>;
+
+
+} //namespace am
+
+
+#endif
@@ -0,0 +1,363 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_COLOR_MAPPING_H_
+#define AMLIB_COLOR_MAPPING_H_
+
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "quantization.h"
+
+
+namespace am {
+
+
+/*************************************************************************//***
+ *
+ * @brief extracts linear {r,g,b,a} channels (nominally in [0,1]) from
+ *        gradient results
+ *
+ * @details default: members r, g, b and optional a (alpha = 1 otherwise);
+ *          arithmetic types are gray values;
+ *          specialize for other color types
+ *
+ *****************************************************************************/
+namespace detail {
+
+template<class C>
+inline auto
+color_alpha(const C& c, int) -> decltype(float(c.a)) { return float(c.a); }
+
+template<class C>
+inline float
+color_alpha(const C&, long) { return 1.0f; }
+
+} // namespace detail
+
+
+template<class Color, class = void>
+struct color_traits
+{
+    static std::array<float,4>
+    rgba(const Color& c) {
+        return {{float(c.r), float(c.g), float(c.b), detail::color_alpha(c,0)}};
+    }
+};
+
+template<class Color>
+struct color_traits<Color,std::enable_if_t<std::is_arithmetic<Color>::value>>
+{
+    static std::array<float,4>
+    rgba(const Color& c) {
+        const auto v = float(c);
+        return {{v, v, v, 1.0f}};
+    }
+};
+
+
+
+
+/*****************************************************************************
+ *
+ * PIXEL FORMATS
+ *
+ * 4 channels per pixel in memory order R,G,B,A
+ *
+ *****************************************************************************/
+namespace pixel_format {
+
+/*************************************************************************//***
+ *
+ * @brief 8 bit unsigned normalized channels; values are clamped to [0,1]
+ *
+ *****************************************************************************/
+struct rgba8
+{
+    using channel_type = std::uint8_t;
+    using packed_type  = std::uint32_t;
+
+    static channel_type
+    encode(float c) noexcept {
+        c = c > 0.0f ? (c < 1.0f ? c : 1.0f) : 0.0f;
+        return channel_type(c * 255.0f + 0.5f);
+    }
+};
+
+
+
+/*************************************************************************//***
+ *
+ * @brief IEEE 754 binary16 channels (no clamping => HDR values)
+ *
+ *****************************************************************************/
+struct rgba16f
+{
+    using channel_type = std::uint16_t;
+    using packed_type  = std::uint64_t;
+
+    static channel_type
+    encode(float c) noexcept {
+        return quantization::float_to_half(c);
+    }
+};
+
+} //namespace pixel_format
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief sampling of gradients into a color_lut
+ *
+ *****************************************************************************/
+struct color_lut_options
+{
+    /// number of table entries (>= 2)
+    std::size_t size = 4096;
+    /// gradient argument range that is sampled
+    double domain_min = 0.0;
+    double domain_max = 1.0;
+    /// color channels (not alpha) are encoded as c^(1/gamma)
+    double gamma = 1.0;
+    /// color of NaN inputs (default: transparent black)
+    std::array<float,4> nan_color {{0.0f, 0.0f, 0.0f, 0.0f}};
+};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief maps batches of scalars through a gradient to packed pixels
+ *
+ * @details The gradient is sampled once into a table of pre-encoded
+ *          pixels (gamma and channel conversion included). Mapping a
+ *          value is a clamped index computation, one table load and one
+ *          32 bit (rgba8) or 64 bit (rgba16f) store - no virtual calls,
+ *          no branches.
+ *          Table resolution: nearest of 'size' uniformly spaced samples.
+ *
+ * @tparam Format  pixel_format::rgba8, pixel_format::rgba16f
+ *
+ *****************************************************************************/
+template<class Format>
+class color_lut
+{
+public:
+    //---------------------------------------------------------------
+    using format_type  = Format;
+    using channel_type = typename Format::channel_type;
+    using packed_type  = typename Format::packed_type;
+    using size_type    = std::size_t;
+
+    static constexpr int channels = 4;
+
+    static_assert(sizeof(packed_type) == channels * sizeof(channel_type),
+                  "packed type must hold exactly one pixel");
+
+
+    //---------------------------------------------------------------
+    /**
+     * @param gradient  callable (e.g. any am::gradient) returning colors
+     *                  for which color_traits are defined
+     */
+    template<class Gradient>
+    explicit
+    color_lut(const Gradient& gradient,
+              const color_lut_options& opt = color_lut_options{})
+    {
+        if(opt.size < 2) {
+            throw std::invalid_argument{"color_lut: at least 2 entries required"};
+        }
+        //last entry: NaN color
+        lut_.reserve(opt.size + 1);
+
+        const double step = (opt.domain_max - opt.domain_min) / double(opt.size - 1);
+        for(size_type i = 0; i < opt.size; ++i) {
+            const auto x = opt.domain_min + double(i) * step;
+            using color_t = std::decay_t<decltype(gradient(x))>;
+            lut_.push_back(pack(color_traits<color_t>::rgba(gradient(x)), opt.gamma));
+        }
+        lut_.push_back(pack(opt.nan_color, opt.gamma));
+    }
+
+
+    //---------------------------------------------------------------
+    /// number of color entries
+    size_type
+    size() const noexcept {
+        return lut_.size() - 1;
+    }
+
+    //---------------------------------------------------------------
+    /// pre-encoded pixel (index size() => NaN color)
+    std::array<channel_type,channels>
+    entry(size_type i) const noexcept {
+        std::array<channel_type,channels> px;
+        std::memcpy(px.data(), &lut_[i], sizeof(packed_type));
+        return px;
+    }
+
+
+    //---------------------------------------------------------------
+    /**
+     * @brief maps [first,last) linearly from [lo,hi] to the table and
+     *        writes 4 channels per value to out;
+     *        values outside of [lo,hi] are clamped
+     */
+    template<class T>
+    void
+    map(const T* first, const T* last, T lo, T hi, channel_type* out) const
+    {
+        using fp_t = std::common_type_t<float,T>;
+
+        const auto maxIdx = fp_t(size() - 1);
+        const auto range = fp_t(hi) - fp_t(lo);
+        const auto scale = range != fp_t(0) ? maxIdx / range : fp_t(0);
+        const auto offset = fp_t(0.5) - fp_t(lo) * scale;
+        const auto nanIdx = size();
+        const packed_type* lut = lut_.data();
+
+        for(; first != last; ++first, out += channels) {
+            const auto v = fp_t(*first);
+            auto t = v * scale + offset;
+            //NaN => 0
+            t = t > fp_t(0) ? t : fp_t(0);
+            t = t < maxIdx ? t : maxIdx;
+            const auto i = (v == v) ? size_type(t) : nanIdx;
+            std::memcpy(out, lut + i, sizeof(packed_type));
+        }
+    }
+
+    //-----------------------------------------------------
+    template<class T>
+    void
+    map(const std::vector<T>& values, T lo, T hi, channel_type* out) const {
+        map(values.data(), values.data() + values.size(), lo, hi, out);
+    }
+
+
+    //---------------------------------------------------------------
+    /**
+     * @brief maps a 2D field row-parallel
+     *
+     * @param inStride   distance between input rows (in values)
+     * @param outStride  distance between output rows (in channels)
+     * @param threads    0: hardware concurrency;
+     *                   small images are always mapped on the calling thread
+     */
+    template<class T>
+    void
+    map_image(const T* in, size_type width, size_type height,
+              size_type inStride, T lo, T hi,
+              channel_type* out, size_type outStride,
+              unsigned threads = 0) const
+    {
+        const auto rows = [&](size_type r0, size_type r1) {
+            for(size_type r = r0; r < r1; ++r) {
+                const T* row = in + r * inStride;
+                map(row, row + width, lo, hi, out + r * outStride);
+            }
+        };
+
+        //at least 64k pixels per thread
+        constexpr size_type minPixels = size_type(1) << 16;
+        if(threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        const auto n = std::max(size_type(1), std::min({size_type(threads),
+                                height, width * height / minPixels}));
+        if(n < 2) {
+            rows(0, height);
+            return;
+        }
+
+        std::vector<std::thread> workers;
+        workers.reserve(n - 1);
+        for(size_type t = 1; t < n; ++t) {
+            workers.emplace_back(rows, height * t / n, height * (t+1) / n);
+        }
+        rows(0, height / n);
+        for(auto& w : workers) w.join();
+    }
+
+    //-----------------------------------------------------
+    /// contiguous input and output rows
+    template<class T>
+    void
+    map_image(const T* in, size_type width, size_type height, T lo, T hi,
+              channel_type* out, unsigned threads = 0) const
+    {
+        map_image(in, width, height, width, lo, hi,
+                  out, width * channels, threads);
+    }
+
+
+    //---------------------------------------------------------------
+    size_type
+    memory_usage() const noexcept {
+        return lut_.capacity() * sizeof(packed_type);
+    }
+
+
+private:
+    //---------------------------------------------------------------
+    static packed_type
+    pack(const std::array<float,4>& c, double gamma) {
+        std::array<channel_type,channels> px;
+        for(int k = 0; k < 3; ++k) {
+            auto v = c[k];
+            if(gamma != 1.0 && v > 0.0f) v = float(std::pow(double(v), 1.0 / gamma));
+            px[k] = Format::encode(v);
+        }
+        px[3] = Format::encode(c[3]);
+
+        packed_type p;
+        std::memcpy(&p, px.data(), sizeof(p));
+        return p;
+    }
+
+
+    //---------------------------------------------------------------
+    std::vector<packed_type> lut_;
+};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief samples a gradient into a color_lut
+ *
+ *****************************************************************************/
+template<class Format, class Gradient>
+inline color_lut<Format>
+make_color_lut(const Gradient& gradient,
+               const color_lut_options& opt = color_lut_options{})
+{
+    return color_lut<Format>{gradient, opt};
+}
+
+
+} //namespace am
+
+
+#endif
@@ -0,0 +1,382 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_COMPRESSED_MAP_H_
+#define AMLIB_COMPRESSED_MAP_H_
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "interpolating_map.h"
+#include "quantization.h"
+#include "search.h"
+
+
+namespace am {
+
+
+/*************************************************************************//***
+ *
+ * @brief Read-only interpolation function with compact, quantized node
+ *        storage for very large, memory-bound node tables.
+ *
+ * @details Nodes are grouped into blocks of BlockSize nodes.
+ *          Each block header holds the exact first key of the block and the
+ *          codec parameters; keys and values are stored as small integer
+ *          codes in separate arrays. A query first searches the block
+ *          headers, then only the codes of one block.
+ *          Only the 2 nodes that bound the hit segment are decoded and then
+ *          passed to the interpolator.
+ *
+ *          With 16 bit key and value codes a node takes ~4.5 bytes instead
+ *          of 16 bytes for std::pair<double,double>.
+ *
+ *          The maximum decoding errors of all keys and values are measured
+ *          during construction (see key_error() and value_error()).
+ *          Blocks in which distinct keys would decode to the same or to
+ *          reordered keys (e.g. very close keys in a block with a wide key
+ *          range) store their keys exactly, so that queries always find
+ *          the right segment (see exact_key_blocks()).
+ *
+ * @tparam KeyT          domain value type (arithmetic)
+ * @tparam MappedT       co-domain value type (arithmetic)
+ * @tparam Interpolator  function class that interpolates in-between nodes
+ * @tparam KeyCodec      key quantization (must be monotone);
+ *                       see quantization.h
+ * @tparam ValueCodec    value quantization; see quantization.h
+ * @tparam BlockSize     number of nodes per block
+ *
+ *****************************************************************************/
+template<
+    class KeyT,
+    class MappedT,
+    class Interpolator,
+    class KeyCodec = quantization::fixed<std::uint16_t>,
+    class ValueCodec = quantization::fixed<std::uint16_t>,
+    std::size_t BlockSize = 64
+>
+class compressed_map
+{
+    static_assert(std::is_arithmetic<KeyT>::value &&
+                  std::is_arithmetic<MappedT>::value,
+                  "compressed_map requires arithmetic key and value types");
+
+    static_assert(BlockSize > 1, "blocks must hold at least 2 nodes");
+
+    using kcode_t_ = typename KeyCodec::code_type;
+    using vcode_t_ = typename ValueCodec::code_type;
+
+    struct block_header_ {
+        KeyT first;
+        typename KeyCodec::block_params key;
+        typename ValueCodec::block_params value;
+        /// offset of the block's keys in exactKeys_ or no_exact_
+        std::size_t exact;
+    };
+
+    static constexpr std::size_t no_exact_ = std::size_t(-1);
+
+public:
+    //---------------------------------------------------------------
+    // TYPES
+    //---------------------------------------------------------------
+    using key_type     = KeyT;
+    using mapped_type  = MappedT;
+    using value_type   = std::pair<KeyT,MappedT>;
+    using interpolator_type = Interpolator;
+    using key_codec    = KeyCodec;
+    using value_codec  = ValueCodec;
+    using size_type    = std::size_t;
+
+    static constexpr size_type block_size = BlockSize;
+
+
+    //---------------------------------------------------------------
+    // CONSTRUCTION
+    //---------------------------------------------------------------
+    explicit
+    compressed_map(const interpolator_type& ipl = interpolator_type()):
+        ipl_(ipl), n_(0), keyErr_(0), valErr_(0),
+        headers_{}, keys_{}, values_{}, exactKeys_{}
+    {}
+    //-----------------------------------------------------
+    /**
+     * @brief encodes a range of nodes
+     * @pre   [first,last) is sorted in ascending key order
+     */
+    template<class ForwardIterator>
+    compressed_map(sorted_range_t,
+                   ForwardIterator first, ForwardIterator last,
+                   const interpolator_type& ipl = interpolator_type())
+    :
+        compressed_map(ipl)
+    {
+        encode(first, last);
+    }
+    //-----------------------------------------------------
+    ///@brief encodes all nodes of an interpolating_map
+    template<class C, class A, class P>
+    explicit
+    compressed_map(
+        const interpolating_map<KeyT,MappedT,Interpolator,C,A,P>& m)
+    :
+        compressed_map(m.interpolator())
+    {
+        encode(m.begin(), m.end());
+    }
+
+
+    //---------------------------------------------------------------
+    // INTERPOLATION
+    //---------------------------------------------------------------
+    mapped_type
+    operator () (const key_type& x) const {
+        if(n_ < 2) {
+            const value_type nodes[1] = { n_ > 0 ? node(0) : value_type{} };
+            return ipl_(nodes, nodes + n_, x);
+        }
+        size_type lo = lower_bound_index(x);
+        lo = lo > 0 ? lo - 1 : 0;
+        if(lo + 2 > n_) lo = n_ - 2;
+
+        const value_type nodes[2] = { node(lo), node(lo+1) };
+        return ipl_(nodes, nodes + 2, x);
+    }
+
+
+    //---------------------------------------------------------------
+    // ELEMENT ACCESS
+    //---------------------------------------------------------------
+    ///@brief decoded node at position 'index'
+    value_type
+    node(size_type index) const noexcept {
+        const auto& h = headers_[index / BlockSize];
+        return value_type{ key(h, index),
+            mapped_type(ValueCodec::decode(values_[index], h.value)) };
+    }
+    //-----------------------------------------------------
+    value_type
+    operator [] (size_type index) const noexcept {
+        return node(index);
+    }
+
+
+    //---------------------------------------------------------------
+    bool      empty() const noexcept { return n_ == 0; }
+    size_type size() const noexcept  { return n_; }
+
+
+    //---------------------------------------------------------------
+    ///@brief index of the first node with key not smaller than x
+    size_type
+    lower_bound_index(const key_type& x) const {
+        //first block whose first key is not smaller than x
+        const auto hb = search::partition_point(headers_.begin(), headers_.end(),
+            [&](const block_header_& h) { return h.first < x; });
+
+        if(hb == headers_.begin()) return 0;
+
+        //=> candidates are in the preceding block
+        const auto b = size_type(std::distance(headers_.begin(), hb) - 1);
+        const auto& h = headers_[b];
+        const auto n = std::min(n_ - b * BlockSize, BlockSize);
+
+        if(h.exact != no_exact_) {
+            const auto first = exactKeys_.begin() + h.exact;
+            const auto it = search::partition_point_n(first, n,
+                [&](const key_type& k) { return k < x; });
+            return b * BlockSize + size_type(std::distance(first, it));
+        }
+
+        const auto first = keys_.begin() + b * BlockSize;
+        const auto pred = [&](kcode_t_ c) {
+            return key_type(KeyCodec::decode(c, h.key)) < x; };
+
+        //all blocks except the last one have compile-time size
+        const auto it = n == BlockSize
+            ? search::partition_point_fixed<BlockSize>(first, pred)
+            : search::partition_point_n(first, n, pred);
+
+        return size_type(std::distance(keys_.begin(), it));
+    }
+
+
+    //---------------------------------------------------------------
+    ///@brief maximum absolute key decoding error of all nodes
+    double key_error() const noexcept   { return keyErr_; }
+    ///@brief maximum absolute value decoding error of all nodes
+    double value_error() const noexcept { return valErr_; }
+
+    //-----------------------------------------------------
+    ///@brief number of blocks whose keys are stored exactly
+    size_type
+    exact_key_blocks() const noexcept {
+        return size_type(std::count_if(headers_.begin(), headers_.end(),
+            [](const block_header_& h) { return h.exact != no_exact_; }));
+    }
+
+    //-----------------------------------------------------
+    ///@brief bytes occupied by the encoded nodes
+    size_type
+    memory_usage() const noexcept {
+        return headers_.capacity() * sizeof(block_header_) +
+               keys_.capacity() * sizeof(kcode_t_) +
+               values_.capacity() * sizeof(vcode_t_) +
+               exactKeys_.capacity() * sizeof(key_type);
+    }
+
+
+    //---------------------------------------------------------------
+    const interpolator_type&
+    interpolator() const noexcept {
+        return ipl_;
+    }
+
+
+private:
+    //---------------------------------------------------------------
+    key_type
+    key(const block_header_& h, size_type index) const noexcept {
+        return h.exact != no_exact_
+            ? exactKeys_[h.exact + index % BlockSize]
+            : key_type(KeyCodec::decode(keys_[index], h.key));
+    }
+
+
+    //---------------------------------------------------------------
+    template<class ForwardIterator>
+    void encode(ForwardIterator first, ForwardIterator last)
+    {
+        using std::abs;
+        using std::floor;
+
+        const auto nodesBegin = first;
+
+        n_ = size_type(std::distance(first,last));
+        headers_.reserve((n_ + BlockSize - 1) / BlockSize);
+        keys_.reserve(n_);
+        values_.reserve(n_);
+
+        const auto integral = [](double v) { return floor(v) == v; };
+
+        while(first != last) {
+            //gather block statistics
+            auto bend = first;
+            double klo = double(first->first), khi = klo;
+            double vlo = double(first->second), vhi = vlo;
+            bool kint = true, vint = true;
+            for(size_type i = 0; i < BlockSize && bend != last; ++i, ++bend) {
+                const double k = double(bend->first);
+                const double v = double(bend->second);
+                khi = std::max(khi, k);
+                vlo = std::min(vlo, v);
+                vhi = std::max(vhi, v);
+                kint = kint && integral(k);
+                vint = vint && integral(v);
+            }
+
+            headers_.push_back(block_header_{first->first,
+                KeyCodec::fit(klo, khi, kint),
+                ValueCodec::fit(vlo, vhi, vint), no_exact_ });
+            const auto& h = headers_.back();
+
+            for(; first != bend; ++first) {
+                keys_.push_back(KeyCodec::encode(double(first->first), h.key));
+                const auto vc = ValueCodec::encode(double(first->second), h.value);
+                values_.push_back(vc);
+
+                valErr_ = std::max(valErr_, abs(double(first->second) -
+                    double(mapped_type(ValueCodec::decode(vc, h.value)))));
+            }
+        }
+
+        store_colliding_keys_exactly(nodesBegin, last);
+
+        first = nodesBegin;
+        for(size_type i = 0; i < n_; ++i, ++first) {
+            keyErr_ = std::max(keyErr_, abs(double(first->first) -
+                double(key(headers_[i / BlockSize], i))));
+        }
+    }
+
+
+    //---------------------------------------------------------------
+    /**
+     * @brief switches blocks to exact key storage until strictly
+     *        increasing keys also decode to strictly increasing keys
+     *        (also across block boundaries)
+     */
+    template<class ForwardIterator>
+    void store_colliding_keys_exactly(ForwardIterator first,
+                                      ForwardIterator last)
+    {
+        if(n_ < 2) return;
+
+        bool changed = true;
+        while(changed) {
+            changed = false;
+            auto prev = first;
+            auto cur = std::next(first);
+            key_type pk = key(headers_[0], 0);
+            for(size_type i = 1; cur != last; ++i, ++prev, ++cur) {
+                const auto b = i / BlockSize;
+                const key_type k = key(headers_[b], i);
+                if(prev->first < cur->first && !(pk < k)) {
+                    changed = make_block_exact(b, first) || changed;
+                    if(i % BlockSize == 0) {
+                        changed = make_block_exact(b - 1, first) || changed;
+                    }
+                    pk = key(headers_[b], i);
+                } else {
+                    pk = k;
+                }
+            }
+        }
+    }
+
+    //-----------------------------------------------------
+    template<class ForwardIterator>
+    bool make_block_exact(size_type b, ForwardIterator first)
+    {
+        auto& h = headers_[b];
+        if(h.exact != no_exact_) return false;
+
+        h.exact = exactKeys_.size();
+        const auto n = std::min(n_ - b * BlockSize, BlockSize);
+        auto i = std::next(first, b * BlockSize);
+        for(size_type j = 0; j < n; ++j, ++i) {
+            exactKeys_.push_back(i->first);
+        }
+        return true;
+    }
+
+
+    //---------------------------------------------------------------
+    interpolator_type ipl_;
+    size_type n_;
+    double keyErr_;
+    double valErr_;
+    std::vector<block_header_> headers_;
+    std::vector<kcode_t_> keys_;
+    std::vector<vcode_t_> values_;
+    std::vector<key_type> exactKeys_;
+};
+
+
+} //namespace am
+
+
+#endif
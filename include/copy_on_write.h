@@ -0,0 +1,418 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_COPY_ON_WRITE_H_
+#define AMLIB_COPY_ON_WRITE_H_
+
+
+#include <atomic>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "memory_footprint.h"
+
+
+namespace am {
+
+
+/*************************************************************************//***
+ *
+ * @brief map wrapper whose copies share one immutable map (nodes and
+ *        derived node data); a private copy is made by the first
+ *        modifying call on a shared instance
+ *
+ * @details Copying costs one atomic reference count increment.
+ *          Different instances can be copied, read, modified and destroyed
+ *          concurrently; one instance still must not be modified
+ *          concurrently with any other access to the same instance.
+ *
+ * @tparam Map  interpolating_map (or map with the same interface)
+ *
+ *****************************************************************************/
+template<class Map>
+class copy_on_write
+{
+public:
+    //---------------------------------------------------------------
+    // TYPES
+    //---------------------------------------------------------------
+    using map_type     = Map;
+    using key_type     = typename Map::key_type;
+    using mapped_type  = typename Map::mapped_type;
+    using value_type   = typename Map::value_type;
+    using interpolator_type = typename Map::interpolator_type;
+    using key_compare  = typename Map::key_compare;
+    using instrumentation_type = typename Map::instrumentation_type;
+    using size_type    = typename Map::size_type;
+    using difference_type = typename Map::difference_type;
+    using const_reference = typename Map::const_reference;
+    //-----------------------------------------------------
+    using iterator       = typename Map::const_iterator;
+    using const_iterator = typename Map::const_iterator;
+    using reverse_iterator       = typename Map::const_reverse_iterator;
+    using const_reverse_iterator = typename Map::const_reverse_iterator;
+
+
+    //---------------------------------------------------------------
+    // CONSTRUCTION
+    //---------------------------------------------------------------
+    /// no allocation; all empty instances share one empty map
+    copy_on_write() noexcept : map_{}, frozen_{false} {}
+    //-----------------------------------------------------
+    explicit
+    copy_on_write(Map m):
+        map_{std::make_shared<Map>(std::move(m))}, frozen_{false}
+    {}
+    //-----------------------------------------------------
+    copy_on_write(std::initializer_list<value_type> il):
+        map_{std::make_shared<Map>(il)}, frozen_{false}
+    {}
+    //-----------------------------------------------------
+    /// constructs the map from args
+    template<class Arg, class... Args, class = std::enable_if_t<
+        !std::is_same<std::decay_t<Arg>,copy_on_write>::value &&
+        !std::is_same<std::decay_t<Arg>,Map>::value>>
+    explicit
+    copy_on_write(Arg&& arg, Args&&... args):
+        map_{std::make_shared<Map>(std::forward<Arg>(arg),
+                                   std::forward<Args>(args)...)},
+        frozen_{false}
+    {}
+    //-----------------------------------------------------
+    /**
+     * @brief adopts a map that may also be referenced elsewhere
+     *        (e.g. by an interning registry);
+     *        it will never be modified in place
+     */
+    static copy_on_write
+    adopt_shared(std::shared_ptr<Map> m) noexcept {
+        copy_on_write c;
+        c.map_ = std::move(m);
+        c.frozen_ = true;
+        return c;
+    }
+
+    //-----------------------------------------------------
+    copy_on_write(const copy_on_write&) = default;
+    copy_on_write(copy_on_write&&) noexcept = default;
+
+    copy_on_write& operator = (const copy_on_write&) = default;
+    copy_on_write& operator = (copy_on_write&&) noexcept = default;
+
+
+    //---------------------------------------------------------------
+    // INTERPOLATION
+    //---------------------------------------------------------------
+    mapped_type
+    operator () (const key_type& x) const {
+        return get()(x);
+    }
+
+    //-----------------------------------------------------
+    template<class InputIterator, class OutputIterator>
+    OutputIterator
+    evaluate(InputIterator first, InputIterator last, OutputIterator out) const
+    {
+        return get().evaluate(first, last, out);
+    }
+
+
+    //---------------------------------------------------------------
+    // SHARED STATE
+    //---------------------------------------------------------------
+    const map_type&
+    get() const noexcept {
+        return map_ ? *map_ : empty_map();
+    }
+
+    //-----------------------------------------------------
+    ///@brief true, if both instances refer to the same map
+    bool
+    shares_with(const copy_on_write& other) const noexcept {
+        return map_ == other.map_;
+    }
+
+    //-----------------------------------------------------
+    ///@brief see interpolating_map::version()
+    auto
+    version() const noexcept {
+        return get().version();
+    }
+
+    //-----------------------------------------------------
+    ///@brief number of instances that share the map (0 if empty)
+    long
+    use_count() const noexcept {
+        return map_.use_count();
+    }
+
+
+    //---------------------------------------------------------------
+    // ELEMENT ACCESS
+    //---------------------------------------------------------------
+    const value_type&
+    operator [] (size_type index) const {
+        return get()[index];
+    }
+    //-----------------------------------------------------
+    const value_type&
+    at(size_type index) const {
+        return get().at(index);
+    }
+
+    //-----------------------------------------------------
+    bool      empty() const    { return get().empty(); }
+    size_type size() const     { return get().size(); }
+    size_type max_size() const { return get().max_size(); }
+    size_type capacity() const { return get().capacity(); }
+
+    //-----------------------------------------------------
+    ///@brief memory of the (possibly shared) map
+    memory_footprint
+    footprint() const { return get().footprint(); }
+
+    //-----------------------------------------------------
+    const_iterator
+    find(const key_type& k) const { return get().find(k); }
+
+    const_iterator
+    lower_bound(const key_type& k) const { return get().lower_bound(k); }
+
+    const_iterator
+    upper_bound(const key_type& k) const { return get().upper_bound(k); }
+
+    std::pair<const_iterator,const_iterator>
+    equal_range(const key_type& k) const { return get().equal_range(k); }
+
+    size_type
+    count(const key_type& k) const { return get().count(k); }
+
+    //-----------------------------------------------------
+    const interpolator_type&
+    interpolator() const { return get().interpolator(); }
+
+    key_compare
+    key_comp() const { return get().key_comp(); }
+
+
+    //---------------------------------------------------------------
+    // MODIFIERS (=> private copy if shared)
+    //---------------------------------------------------------------
+    template<class... Args>
+    iterator
+    emplace(Args&&... args) {
+        return mutable_map().emplace(std::forward<Args>(args)...);
+    }
+
+    //-----------------------------------------------------
+    iterator
+    insert(const value_type& val) {
+        return mutable_map().insert(val);
+    }
+    //-----------------------------------------------------
+    template<class V>
+    iterator
+    insert(V&& val) {
+        return mutable_map().insert(std::forward<V>(val));
+    }
+    //-----------------------------------------------------
+    template<class InputIterator>
+    iterator
+    insert(InputIterator first, InputIterator last) {
+        return mutable_map().insert(first, last);
+    }
+    //-----------------------------------------------------
+    iterator
+    insert(std::initializer_list<value_type> il) {
+        return mutable_map().insert(il);
+    }
+
+    //-----------------------------------------------------
+    template<class... Args>
+    void
+    assign(Args&&... args) {
+        mutable_map().assign(std::forward<Args>(args)...);
+    }
+    //-----------------------------------------------------
+    void
+    assign(std::initializer_list<value_type> il) {
+        mutable_map().assign(il);
+    }
+
+    //-----------------------------------------------------
+    template<class... Args>
+    void
+    assign_values(Args&&... args) {
+        mutable_map().assign_values(std::forward<Args>(args)...);
+    }
+    //-----------------------------------------------------
+    void
+    assign_values(size_type pos, std::initializer_list<mapped_type> il) {
+        mutable_map().assign_values(pos, il);
+    }
+    //-----------------------------------------------------
+    template<class... Args>
+    void
+    transform_values(Args&&... args) {
+        mutable_map().transform_values(std::forward<Args>(args)...);
+    }
+
+    //-----------------------------------------------------
+    size_type
+    erase(const key_type& key) {
+        return mutable_map().erase(key);
+    }
+    //-----------------------------------------------------
+    iterator
+    erase(const_iterator pos) {
+        //pos may refer to the shared map
+        const auto i = std::distance(begin(), pos);
+        auto& m = mutable_map();
+        return m.erase(std::next(m.begin(), i));
+    }
+    //-----------------------------------------------------
+    iterator
+    erase(const_iterator first, const_iterator last) {
+        const auto i = std::distance(begin(), first);
+        const auto n = std::distance(first, last);
+        auto& m = mutable_map();
+        const auto f = std::next(m.begin(), i);
+        return m.erase(f, std::next(f, n));
+    }
+
+    //-----------------------------------------------------
+    void
+    clear() {
+        if(frozen_ || map_.use_count() > 1) {
+            //no need to copy nodes that would be removed anyway
+            const auto& m = get();
+            map_ = std::make_shared<Map>(m.interpolator(), m.key_comp(),
+                                         m.get_allocator());
+            frozen_ = false;
+        } else if(map_) {
+            map_->clear();
+        }
+    }
+
+    //-----------------------------------------------------
+    void
+    reserve(size_type n) {
+        if(n > capacity()) mutable_map().reserve(n);
+    }
+    //-----------------------------------------------------
+    /// no effect on shared maps (would require a private copy)
+    void
+    shrink_to_fit() {
+        if(map_ && !frozen_ && map_.use_count() == 1) mutable_map().shrink_to_fit();
+    }
+
+    //-----------------------------------------------------
+    void
+    swap(copy_on_write& other) noexcept {
+        map_.swap(other.map_);
+        std::swap(frozen_, other.frozen_);
+    }
+
+
+    //---------------------------------------------------------------
+    // ITERATORS
+    //---------------------------------------------------------------
+    const_iterator begin() const noexcept  { return get().begin(); }
+    const_iterator cbegin() const noexcept { return get().begin(); }
+    const_iterator end() const noexcept    { return get().end(); }
+    const_iterator cend() const noexcept   { return get().end(); }
+    //-----------------------------------------------------
+    const_reverse_iterator rbegin() const noexcept  { return get().rbegin(); }
+    const_reverse_iterator crbegin() const noexcept { return get().rbegin(); }
+    const_reverse_iterator rend() const noexcept    { return get().rend(); }
+    const_reverse_iterator crend() const noexcept   { return get().rend(); }
+
+
+private:
+    //---------------------------------------------------------------
+    static const map_type&
+    empty_map() {
+        static const map_type m{};
+        return m;
+    }
+
+    //---------------------------------------------------------------
+    map_type&
+    mutable_map() {
+        if(!map_) {
+            map_ = std::make_shared<Map>();
+            frozen_ = false;
+        }
+        else if(frozen_ || map_.use_count() != 1) {
+            map_ = std::make_shared<Map>(*map_);
+            frozen_ = false;
+        }
+        else {
+            //synchronizes with the release of the former co-owners
+            //(use_count() is a relaxed load)
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *map_;
+    }
+
+    //---------------------------------------------------------------
+    std::shared_ptr<Map> map_;
+    bool frozen_;
+};
+
+
+
+
+/*****************************************************************************
+ *
+ * @brief node storage policies
+ *
+ *****************************************************************************/
+namespace storage {
+
+/// each copy owns its nodes
+struct unique {
+    template<class Map> using type = Map;
+};
+
+/// copies share their nodes until modified
+struct copy_on_write {
+    template<class Map> using type = am::copy_on_write<Map>;
+};
+
+} // namespace storage
+
+
+
+
+//-------------------------------------------------------------------
+template<class Map>
+inline void
+swap(copy_on_write<Map>& a, copy_on_write<Map>& b) noexcept
+{
+    a.swap(b);
+}
+
+//-------------------------------------------------------------------
+template<class Map>
+inline const Map&
+underlying_map(const copy_on_write<Map>& m) noexcept
+{
+    return m.get();
+}
+
+
+} //namespace am
+
+
+#endif
@@ -0,0 +1,168 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_FAST_MATH_H_
+#define AMLIB_FAST_MATH_H_
+
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+
+namespace am {
+
+
+namespace detail {
+
+//-------------------------------------------------------------------
+inline std::uint64_t
+double_bits(double x) noexcept {
+    std::uint64_t b;
+    std::memcpy(&b, &x, sizeof(b));
+    return b;
+}
+
+//-------------------------------------------------------------------
+inline double
+bits_double(std::uint64_t b) noexcept {
+    double x;
+    std::memcpy(&x, &b, sizeof(x));
+    return x;
+}
+
+} //namespace detail
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief natural logarithm without library calls or data-dependent branches
+ *        (=> loops over arrays can be auto-vectorized)
+ *
+ * @details x = m * 2^e with m in [sqrt(1/2), sqrt(2)),
+ *          log(m) = 2 atanh(s) with s = (m-1)/(m+1), |s| < 0.172;
+ *          the atanh series is truncated after 'Terms' terms.
+ *          Relative error (for |log(x)| > 0.1):
+ *            Terms = 3: ~4e-6,  4: ~1e-7,  5: ~2e-9,  7: ~1e-12
+ *
+ * @pre   x must be a positive, normal number; x == 0 yields -inf,
+ *        x < 0 NaN
+ *
+ *****************************************************************************/
+template<int Terms = 5>
+inline double
+fast_log(double x) noexcept
+{
+    static_assert(Terms > 0, "at least one term required");
+
+    const std::uint64_t b = detail::double_bits(x);
+    //exponent & mantissa in [1,2)
+    double e = double(int((b >> 52) & 0x7ff) - 1023);
+    double m = detail::bits_double((b & 0xfffffffffffffull) |
+                                    0x3ff0000000000000ull);
+    //shift mantissa to [sqrt(1/2), sqrt(2))
+    const bool big = m > 1.4142135623730951;
+    m = big ? 0.5 * m : m;
+    e = big ? e + 1.0 : e;
+
+    const double s = (m - 1.0) / (m + 1.0);
+    const double s2 = s * s;
+
+    //Horner scheme for sum_k s^2k / (2k+1)
+    double p = 1.0 / double(2 * Terms - 1);
+    for(int k = Terms - 2; k >= 0; --k) {
+        p = p * s2 + 1.0 / double(2 * k + 1);
+    }
+    const double r = e * 0.6931471805599453 + 2.0 * s * p;
+
+    return x > 0 ? r : (x == 0 ? -std::numeric_limits<double>::infinity()
+                               :  std::numeric_limits<double>::quiet_NaN());
+}
+
+
+
+/*************************************************************************//***
+ *
+ * @brief exponential function without library calls or data-dependent
+ *        branches (=> loops over arrays can be auto-vectorized)
+ *
+ * @details exp(x) = 2^n * exp(r) with |r| <= log(2)/2;
+ *          the Taylor series of exp(r) is truncated after 'Terms' terms.
+ *          Relative error:
+ *            Terms = 6: ~3e-6,  7: ~2e-7,  9: ~3e-10,  11: ~3e-13
+ *
+ *          Results below the normal range are flushed to zero,
+ *          results above yield inf. NaN propagates.
+ *
+ *****************************************************************************/
+template<int Terms = 9>
+inline double
+fast_exp(double x) noexcept
+{
+    static_assert(Terms > 0, "at least one term required");
+
+    //log(DBL_MAX) and log(DBL_MIN)
+    constexpr double hi =  709.782712893384;
+    constexpr double lo = -708.3964185322641;
+
+    //NaN => lo
+    const double xc = !(x >= lo) ? lo : (x > hi ? hi : x);
+
+    const double n = std::floor(xc * 1.4426950408889634 + 0.5);
+    //log(2) split into exactly representable high part and remainder
+    const double r = (xc - n * 0.693145751953125) - n * 1.4286068203094172e-6;
+
+    double p = 1.0;
+    for(int k = Terms - 1; k > 0; --k) {
+        p = 1.0 + p * r / double(k);
+    }
+
+    //2^n in 2 steps, so that n = 1024 doesn't overflow the exponent field
+    const auto n1 = std::int64_t(n) / 2;
+    const auto n2 = std::int64_t(n) - n1;
+    const double s1 = detail::bits_double(std::uint64_t(n1 + 1023) << 52);
+    const double s2 = detail::bits_double(std::uint64_t(n2 + 1023) << 52);
+    const double v = p * s1 * s2;
+
+    return x > hi ? std::numeric_limits<double>::infinity()
+                  : (x < lo ? 0.0 : (x == x ? v : x));
+}
+
+
+
+
+//-------------------------------------------------------------------
+///@brief writes fast_log<Terms>(x) for all x in [first,last) to out
+template<int Terms = 5, class InputIterator, class OutputIterator>
+inline OutputIterator
+fast_log(InputIterator first, InputIterator last, OutputIterator out)
+{
+    for(; first != last; ++first, ++out) *out = fast_log<Terms>(double(*first));
+    return out;
+}
+
+//-------------------------------------------------------------------
+///@brief writes fast_exp<Terms>(x) for all x in [first,last) to out
+template<int Terms = 9, class InputIterator, class OutputIterator>
+inline OutputIterator
+fast_exp(InputIterator first, InputIterator last, OutputIterator out)
+{
+    for(; first != last; ++first, ++out) *out = fast_exp<Terms>(double(*first));
+    return out;
+}
+
+
+} //namespace am
+
+
+#endif
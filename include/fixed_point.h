@@ -0,0 +1,565 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_FIXED_POINT_H_
+#define AMLIB_FIXED_POINT_H_
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "interpolating_map.h"
+#include "search.h"
+
+
+namespace am {
+namespace interpolator {
+
+
+namespace detail {
+
+/*************************************************************************//***
+ *
+ * @brief integer coordinate of keys/values for fixed-point interpolation;
+ *        std::chrono durations and time points use their tick count
+ *
+ *****************************************************************************/
+template<class T, class = std::enable_if_t<std::is_integral<T>::value>>
+constexpr std::int64_t
+fixed_point_count(T x) noexcept {
+    return std::int64_t(x);
+}
+
+template<class Rep, class Period>
+constexpr std::int64_t
+fixed_point_count(const std::chrono::duration<Rep,Period>& d) noexcept {
+    static_assert(std::is_integral<Rep>::value,
+                  "fixed-point interpolation requires integral tick counts");
+    return std::int64_t(d.count());
+}
+
+template<class Clock, class Duration>
+constexpr std::int64_t
+fixed_point_count(const std::chrono::time_point<Clock,Duration>& t) noexcept {
+    return fixed_point_count(t.time_since_epoch());
+}
+
+
+
+//-------------------------------------------------------------------
+/// value from integer coordinate
+template<class T>
+constexpr std::enable_if_t<std::is_integral<T>::value,T>
+from_fixed_point_count(std::int64_t x, T*) noexcept {
+    return T(x);
+}
+
+template<class Rep, class Period>
+constexpr std::chrono::duration<Rep,Period>
+from_fixed_point_count(std::int64_t x, std::chrono::duration<Rep,Period>*) {
+    return std::chrono::duration<Rep,Period>(Rep(x));
+}
+
+template<class Clock, class Duration>
+constexpr std::chrono::time_point<Clock,Duration>
+from_fixed_point_count(std::int64_t x, std::chrono::time_point<Clock,Duration>*) {
+    return std::chrono::time_point<Clock,Duration>(
+        from_fixed_point_count(x, static_cast<Duration*>(nullptr)));
+}
+
+
+
+#if defined(__SIZEOF_INT128__)
+#  define AMLIB_HAS_INT128
+#endif
+
+
+//-------------------------------------------------------------------
+/// 64x64 => 128 bit product
+inline void
+multiply_wide(std::uint64_t a, std::uint64_t b,
+              std::uint64_t& hi, std::uint64_t& lo) noexcept
+{
+#ifdef AMLIB_HAS_INT128
+    __extension__ typedef unsigned __int128 u128;
+    const auto p = u128(a) * b;
+    hi = std::uint64_t(p >> 64);
+    lo = std::uint64_t(p);
+#else
+    //from 32 bit halves
+    constexpr std::uint64_t mask = 0xffffffffu;
+    const auto p0 = (a & mask) * (b & mask);
+    const auto p1 = (a >> 32)  * (b & mask);
+    const auto p2 = (a & mask) * (b >> 32);
+    const auto p3 = (a >> 32)  * (b >> 32);
+    const auto mid = (p0 >> 32) + (p1 & mask) + (p2 & mask);
+    hi = p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+    lo = (mid << 32) | (p0 & mask);
+#endif
+}
+
+//-------------------------------------------------------------------
+/// floor((hi * 2^64 + lo) / d) modulo 2^64; @pre d > 0
+inline std::uint64_t
+divide_wide(std::uint64_t hi, std::uint64_t lo, std::uint64_t d) noexcept
+{
+#ifdef AMLIB_HAS_INT128
+    __extension__ typedef unsigned __int128 u128;
+    return std::uint64_t(((u128(hi) << 64) | lo) / d);
+#else
+    //long division; quotient bits above 2^64 are dropped
+    //d < 2^63 => r << 1 doesn't overflow
+    auto r = hi % d;
+    std::uint64_t q = 0;
+    for(int i = 63; i >= 0; --i) {
+        r = (r << 1) | ((lo >> i) & 1);
+        q <<= 1;
+        if(r >= d) { r -= d; q |= 1; }
+    }
+    return q;
+#endif
+}
+
+//-------------------------------------------------------------------
+/// floor((2*a*b + c) / (2*d)) modulo 2^64; @pre a < 2^60, 0 < d < 2^60, c <= d
+inline std::uint64_t
+rounded_quotient(std::uint64_t a, std::uint64_t b,
+                 std::uint64_t c, std::uint64_t d) noexcept
+{
+    std::uint64_t hi = 0;
+    std::uint64_t lo = 0;
+    multiply_wide(a, b, hi, lo);
+    hi = (hi << 1) | (lo >> 63);
+    lo <<= 1;
+    lo += c;
+    hi += lo < c ? 1 : 0;
+    return divide_wide(hi, lo, d << 1);
+}
+
+//-------------------------------------------------------------------
+inline int
+bit_width(std::uint64_t x) noexcept {
+    int n = 0;
+    for(; x != 0; x >>= 1) ++n;
+    return n;
+}
+
+
+
+/*************************************************************************//***
+ *
+ * @brief one segment of a fixed-point linear interpolant:
+ *        v(x) = v0 + round(dv * (x - k0) / dk)
+ *        exactly rounded (ties are rounded up)
+ *
+ * @details make() precomputes the slope |dv| / dk as reciprocal
+ *          r = floor(|dv| * 2^shift / dk) with shift >= bit_width(dk).
+ *          A query estimates the rounded quotient with one 64x64 => 128 bit
+ *          multiplication and a shift; the estimate is off by at most one
+ *          for |x - k0| < 2^shift (=> everywhere within the segment) and
+ *          is corrected with one remainder check (64 bit arithmetic).
+ *          Keys farther away (extrapolation) fall back to a division.
+ *          Only integer arithmetic is used for evaluation
+ *          => results are identical on all platforms.
+ *          Results are computed modulo 2^64, so extrapolation far beyond
+ *          the node range wraps around instead of invoking UB.
+ *
+ *****************************************************************************/
+struct fixed_point_segment
+{
+    std::int64_t k0;
+    std::int64_t v0;
+    std::int64_t dv;
+    std::uint64_t dk;
+    std::uint64_t slope;
+    int shift;
+
+
+    //---------------------------------------------------------------
+    /// @throws std::overflow_error if the segment's differences are too large
+    static fixed_point_segment
+    make(std::int64_t k0, std::int64_t v0, std::int64_t k1, std::int64_t v1)
+    {
+        constexpr auto max_diff = std::uint64_t(1) << 60;
+
+        //magnitudes of differences (exact modulo 2^64)
+        const auto dk = std::uint64_t(k1) - std::uint64_t(k0);
+        const auto adv = v1 >= v0 ? std::uint64_t(v1) - std::uint64_t(v0)
+                                  : std::uint64_t(v0) - std::uint64_t(v1);
+
+        if(k1 < k0 || dk >= max_diff || adv >= max_diff) {
+            throw std::overflow_error{
+                "fixed-point interpolation: node differences too large"};
+        }
+
+        const auto dv = v1 >= v0 ? std::int64_t(adv) : -std::int64_t(adv);
+        if(dk == 0) return fixed_point_segment{k0, v0, dv, 0, 0, 0};
+
+        //largest shift with slope < 2^64 (>= bit_width(dk) + 3)
+        const int shift = std::min(63, 63 - bit_width(adv) + bit_width(dk));
+        const auto slope = divide_wide(adv >> (64 - shift), adv << shift, dk);
+
+        return fixed_point_segment{k0, v0, dv, dk, slope, shift};
+    }
+
+
+    //---------------------------------------------------------------
+    std::int64_t
+    operator () (std::int64_t x) const noexcept {
+        if(dk == 0) return v0;
+
+        const auto dx = std::uint64_t(x) - std::uint64_t(k0);
+        const bool negx = std::int64_t(dx) < 0;
+        const bool negv = dv < 0;
+        const auto adx = negx ? 0 - dx : dx;
+        const auto adv = negv ? 0 - std::uint64_t(dv) : std::uint64_t(dv);
+
+        //floor(t + 1/2) = floor((2|t|dk + dk) / 2dk)           for t >= 0
+        //               = -floor((2|t|dk + dk - 1) / 2dk)      for t < 0
+        const auto c = negx == negv ? dk : dk - 1;
+        const auto q = (adx >> shift) == 0 ? quotient(adv, adx, c)
+                                           : rounded_quotient(adv, adx, c, dk);
+
+        return std::int64_t(negx == negv ? std::uint64_t(v0) + q
+                                         : std::uint64_t(v0) - q);
+    }
+
+
+private:
+    //---------------------------------------------------------------
+    /// floor((2*adv*adx + c) / 2dk) modulo 2^64; @pre adx < 2^shift
+    std::uint64_t
+    quotient(std::uint64_t adv, std::uint64_t adx, std::uint64_t c) const noexcept
+    {
+        //estimate: floor(slope * adx / 2^shift + 1/2)
+        std::uint64_t hi = 0;
+        std::uint64_t lo = 0;
+        multiply_wide(slope, adx, hi, lo);
+        const auto half = std::uint64_t(1) << (shift - 1);
+        lo += half;
+        hi += lo < half ? 1 : 0;
+        auto q = (lo >> shift) | (hi << (64 - shift));
+
+        //remainder is in [-2dk, 4dk) => exact in 64 bits
+        const auto d2 = dk << 1;
+        const auto r = std::int64_t(((adv * adx) << 1) + c - q * d2);
+        if(r < 0) --q;
+        else if(std::uint64_t(r) >= d2) ++q;
+        return q;
+    }
+};
+
+} //namespace detail
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief piece-wise linear interpolation with integer-only arithmetic
+ *        for integral (or std::chrono duration / time_point) keys and
+ *        integral values; results are rounded to the nearest integer and
+ *        identical on all platforms
+ *
+ * @details interpolating_map precomputes a reciprocal slope for each
+ *          segment (see node_cache); a query costs one search, one
+ *          64x64 => 128 bit multiplication, one shift and one remainder
+ *          check. Without cache the slope is computed per query
+ *          (one division) with the same result.
+ *
+ *          The result is the exact linear interpolant rounded to the
+ *          nearest integer (ties are rounded up).
+ *          Key and value differences of neighboring nodes must be smaller
+ *          than 2^60 in magnitude (std::overflow_error otherwise).
+ *
+ * @tparam Extrapolation  policy for keys outside of the node key range
+ *
+ *****************************************************************************/
+template<class Extrapolation = extrapolation::clamp>
+class basic_fixed_point_linear :
+    private Extrapolation
+{
+    using segment_t_ = detail::fixed_point_segment;
+
+    template<class Key, class Value>
+    struct cache_ {
+        std::vector<std::int64_t> keys;
+        std::vector<segment_t_> segments;
+        std::pair<Key,Value> lo;
+        std::pair<Key,Value> hi;
+    };
+
+public:
+    using extrapolation_type = Extrapolation;
+
+    ///@brief node keys and per-segment reciprocal slopes
+    template<class Key, class Value>
+    using cache_type = cache_<Key,Value>;
+
+
+    constexpr
+    basic_fixed_point_linear(const Extrapolation& e = Extrapolation{}):
+        Extrapolation(e)
+    {}
+
+    const extrapolation_type&
+    extrapolation() const noexcept { return *this; }
+
+
+    //---------------------------------------------------------------
+    /// @throws std::overflow_error if node differences are too large
+    template<class Iterator, class Key, class Value>
+    void prepare(Iterator begin, Iterator end, cache_<Key,Value>& c) const
+    {
+        c.keys.clear();
+        c.segments.clear();
+        if(begin == end) return;
+
+        const auto n = std::distance(begin,end);
+        c.keys.reserve(n);
+        c.segments.reserve(n > 1 ? n - 1 : 1);
+
+        c.lo = *begin;
+        auto k0 = detail::fixed_point_count(begin->first);
+        auto v0 = detail::fixed_point_count(begin->second);
+        c.keys.push_back(k0);
+        c.hi = *begin;
+
+        for(++begin; begin != end; ++begin) {
+            const auto k1 = detail::fixed_point_count(begin->first);
+            const auto v1 = detail::fixed_point_count(begin->second);
+            c.segments.push_back(segment_t_::make(k0, v0, k1, v1));
+            c.keys.push_back(k1);
+            c.hi = *begin;
+            k0 = k1;
+            v0 = v1;
+        }
+    }
+
+    //-----------------------------------------------------
+    ///@brief heap bytes occupied by keys and segment slopes
+    template<class Key, class Value>
+    std::size_t
+    memory_usage(const cache_<Key,Value>& c) const noexcept {
+        return c.keys.capacity() * sizeof(std::int64_t) +
+               c.segments.capacity() * sizeof(segment_t_);
+    }
+
+    //-----------------------------------------------------
+    /**
+     * @brief recomputes all segments adjacent to
+     *        nodes [first,last) after their values changed (keys unchanged)
+     * @throws std::overflow_error if node differences are too large
+     */
+    template<class Iterator, class Key, class Value>
+    void refresh_values(Iterator begin, Iterator end, cache_<Key,Value>& c,
+                        std::size_t first, std::size_t last) const
+    {
+        const auto n = c.keys.size();
+        last = std::min(last, n);
+        if(first >= last) return;
+
+        if(first == 0) c.lo = *begin;
+        if(last == n)  c.hi = *std::prev(end);
+
+        //segment s connects nodes s and s+1
+        const auto s0 = first > 0 ? first - 1 : 0;
+        const auto s1 = std::min(last, n - 1);
+
+        auto it = std::next(begin, s0);
+        auto v0 = detail::fixed_point_count(it->second);
+        for(auto s = s0; s < s1; ++s) {
+            const auto v1 = detail::fixed_point_count((++it)->second);
+            c.segments[s] = segment_t_::make(c.keys[s], v0, c.keys[s+1], v1);
+            v0 = v1;
+        }
+    }
+
+    //-----------------------------------------------------
+    /**
+     * @brief replaces the keys and segments of 'erased' nodes at index pos
+     *        with those of the nodes [pos,pos+inserted); only the segments
+     *        adjacent to pos are recomputed
+     * @throws std::overflow_error if node differences are too large
+     */
+    template<class Iterator, class Key, class Value>
+    void splice_nodes(Iterator begin, Iterator end, cache_<Key,Value>& c,
+                      std::size_t pos, std::size_t erased,
+                      std::size_t inserted) const
+    {
+        using kdiff_t = typename decltype(c.keys)::difference_type;
+        using sdiff_t = typename decltype(c.segments)::difference_type;
+
+        const auto n0 = c.keys.size();
+        const auto n1 = n0 - erased + inserted;
+        if(n0 < 2 || n1 < 2) {
+            prepare(begin, end, c);
+            return;
+        }
+
+        //segment s connects nodes s and s+1
+        const auto s0 = pos > 0 ? pos - 1 : 0;
+        const auto s1_old = std::min(pos + erased, n0 - 1);
+        const auto s1_new = std::min(pos + inserted, n1 - 1);
+
+        //compute everything that may throw first
+        std::vector<segment_t_> segs;
+        segs.reserve(s1_new - s0);
+        auto it = std::next(begin, s0);
+        auto k0 = detail::fixed_point_count(it->first);
+        auto v0 = detail::fixed_point_count(it->second);
+        for(auto s = s0; s < s1_new; ++s) {
+            ++it;
+            const auto k1 = detail::fixed_point_count(it->first);
+            const auto v1 = detail::fixed_point_count(it->second);
+            segs.push_back(segment_t_::make(k0, v0, k1, v1));
+            k0 = k1;
+            v0 = v1;
+        }
+
+        std::vector<std::int64_t> keys;
+        keys.reserve(inserted);
+        it = std::next(begin, pos);
+        for(std::size_t i = 0; i < inserted; ++i, ++it) {
+            keys.push_back(detail::fixed_point_count(it->first));
+        }
+
+        auto k = c.keys.erase(std::next(c.keys.begin(), kdiff_t(pos)),
+                              std::next(c.keys.begin(), kdiff_t(pos + erased)));
+        c.keys.insert(k, keys.begin(), keys.end());
+
+        auto p = c.segments.erase(std::next(c.segments.begin(), sdiff_t(s0)),
+                                  std::next(c.segments.begin(), sdiff_t(s1_old)));
+        c.segments.insert(p, segs.begin(), segs.end());
+
+        c.lo = *begin;
+        c.hi = *std::prev(end);
+    }
+
+
+    //---------------------------------------------------------------
+    /**
+     * @brief interpolation with precomputed segments
+     * @param probe  instrumentation policy that receives search events
+     */
+    template<class Key, class Value, class Probe = instrumentation::none>
+    Value interpolate(const cache_<Key,Value>& c, const Key& x,
+                      Probe = Probe{}) const
+    {
+        const auto n = std::distance(c.keys.begin(), c.keys.end());
+        if(n < 1) return Value{};
+        if(n == 1) {
+            return extrapolation()(x < c.lo.first, c.lo.first < x,
+                                   c.lo, c.lo, c.lo.second);
+        }
+
+        const auto u = detail::fixed_point_count(x);
+
+        Probe::search();
+        const auto p = search::partition_point_n(c.keys.begin(), std::size_t(n),
+            [u](std::int64_t k) {
+                Probe::comparison();
+                return k < u;
+            });
+        auto i = std::distance(c.keys.begin(), p);
+        i = std::min(std::max(i, decltype(i)(1)), n - 1);
+
+        return extrapolation()(x < c.lo.first, c.hi.first < x, c.lo, c.hi,
+            detail::from_fixed_point_count(c.segments[i-1](u),
+                                           static_cast<Value*>(nullptr)));
+    }
+
+
+    //---------------------------------------------------------------
+    /**
+     * @brief interpolation based on untransformed nodes
+     *
+     * @tparam Iterator  RandomAccessIterator (at least ForwardIterator)
+     *                   to pairs of keys and mapped values (= nodes)
+     *
+     * @param begin  lower bound of node range
+     * @param end    exclusive upper bound of node range
+     * @param x      key for which to return the interpolated value
+     * @param probe  instrumentation policy that receives search events
+     *
+     * @pre keys in range [begin,end) have to be sorted in ascending order
+     */
+    template<class Iterator, class EndSentinel, class Key,
+             class Probe = instrumentation::none>
+    auto operator () (const Iterator begin, const EndSentinel end,
+                      const Key& x, Probe = Probe{}) const
+    {
+        using std::distance;
+        using std::next;
+
+        using res_t = std::decay_t<decltype(begin->second)>;
+
+        const auto n = distance(begin,end);
+        if(n <  1) return res_t{};
+        if(n == 1) {
+            return extrapolation()(x < begin->first, begin->first < x,
+                                   *begin, *begin, res_t(begin->second));
+        }
+
+        const auto i = detail::upper_segment_node<Probe>(begin, end, x, n);
+
+        const auto& p0 = *next(begin, i-1);
+        const auto& p1 = *next(begin, i);
+        const auto s = segment_t_::make(
+            detail::fixed_point_count(p0.first),
+            detail::fixed_point_count(p0.second),
+            detail::fixed_point_count(p1.first),
+            detail::fixed_point_count(p1.second));
+
+        const auto& lo = *begin;
+        const auto& hi = *next(begin, n-1);
+
+        return extrapolation()(x < lo.first, hi.first < x, lo, hi,
+            detail::from_fixed_point_count(s(detail::fixed_point_count(x)),
+                                           static_cast<res_t*>(nullptr)));
+    }
+};
+
+using fixed_point_linear = basic_fixed_point_linear<>;
+
+
+} //namespace interpolator
+
+
+
+
+/*****************************************************************************
+ *
+ *
+ *****************************************************************************/
+template<
+    class Key,
+    class Value,
+    class KeyCompare = std::less<Key>,
+    class Allocator = std::allocator<std::pair<const Key,Value>>,
+    class Instrumentation = instrumentation::none
+>
+using fixed_point_linear_map =
+        interpolating_map<Key,Value,interpolator::fixed_point_linear,
+                          KeyCompare,Allocator,Instrumentation>;
+
+
+} //namespace am
+
+
+#endif
@@ -4,6 +4,7 @@
 #include <type_traits>
 #include <utility>
 
+#include "copy_on_write.h"
 #include "interpolating_map.h"
 
 
@@ -47,12 +48,17 @@ public:
  *
  * @brief augments an interpolating_map with a gradient interface
  *
+ * @tparam Storage  storage::unique: copies own their nodes (default)
+ *                  storage::copy_on_write: copies share their nodes
+ *
  *****************************************************************************/
-template<class Argument, class Result, class Interpolator>
+template<class Argument, class Result, class Interpolator,
+         class Storage = storage::unique>
 class interpolating_gradient :
     public gradient<Argument,Result>
 {
-    using map_t = interpolating_map<Argument,Result,Interpolator>;
+    using map_t = typename Storage::template type<
+                      interpolating_map<Argument,Result,Interpolator>>;
 
 public:
     //---------------------------------------------------------------
@@ -109,6 +115,19 @@ public:
         return map_.size();
     }
 
+    //---------------------------------------------------------------
+    const interpolating_map<Argument,Result,Interpolator>&
+    map() const noexcept {
+        return underlying_map(map_);
+    }
+
+    //-----------------------------------------------------
+    ///@brief true, if both gradients share their nodes
+    bool
+    shares_nodes_with(const interpolating_gradient& other) const noexcept {
+        return &map() == &other.map();
+    }
+
 
 private:
     map_t map_;
@@ -136,6 +155,23 @@ using step_gradient =
     interpolating_gradient<Arg,Res,interpolator::piecewise_constant>;
 
 
+
+/*****************************************************************************
+ *
+ * copies share their nodes
+ *
+ *****************************************************************************/
+template<class Arg, class Res>
+using shared_linear_gradient =
+    interpolating_gradient<Arg,Res,interpolator::piecewise_linear,
+                           storage::copy_on_write>;
+
+template<class Arg, class Res>
+using shared_step_gradient =
+    interpolating_gradient<Arg,Res,interpolator::piecewise_constant,
+                           storage::copy_on_write>;
+
+
 } //namespace am
 
 
@@ -0,0 +1,339 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_INSTRUMENTATION_H_
+#define AMLIB_INSTRUMENTATION_H_
+
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+
+namespace am {
+namespace instrumentation {
+
+
+/*************************************************************************//***
+ *
+ * @brief default instrumentation policy; all hooks are empty and
+ *        will be compiled out entirely
+ *
+ *****************************************************************************/
+struct none
+{
+    static constexpr bool enabled = false;
+
+    static void evaluation() noexcept {}
+    static void search() noexcept {}
+    static void comparison() noexcept {}
+    static void extrapolation_left() noexcept {}
+    static void extrapolation_right() noexcept {}
+    static void cursor_hit() noexcept {}
+    static void cache_hit() noexcept {}
+    static void cache_miss() noexcept {}
+    static void rebuild() noexcept {}
+
+    template<class Key>
+    static void query(const Key&, const Key&, const Key&) noexcept {}
+};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief snapshot of instrumentation counter values
+ *
+ * @tparam HistogramBins  number of query key histogram bins
+ *                        (2 additional bins for keys left/right of the
+ *                        node range are always present if HistogramBins > 0)
+ *
+ *****************************************************************************/
+template<std::size_t HistogramBins = 0>
+struct counter_snapshot
+{
+    using count_type = std::uint64_t;
+
+    static constexpr std::size_t histogram_size =
+        HistogramBins > 0 ? HistogramBins + 2 : 0;
+
+    count_type evaluations = 0;
+    count_type searches = 0;
+    count_type comparisons = 0;
+    count_type extrapolations_left = 0;
+    count_type extrapolations_right = 0;
+    count_type cursor_hits = 0;
+    count_type cache_hits = 0;
+    count_type cache_misses = 0;
+    count_type rebuilds = 0;
+
+    ///@brief [0]: left of first node, [1..HistogramBins]: inside node range,
+    ///       [HistogramBins+1]: right of last node
+    std::array<count_type,histogram_size> histogram {};
+
+
+    //---------------------------------------------------------------
+    ///@brief average number of key comparisons per search
+    double
+    mean_search_depth() const noexcept {
+        return searches > 0 ? double(comparisons) / double(searches) : 0.0;
+    }
+
+
+    //---------------------------------------------------------------
+    counter_snapshot&
+    operator += (const counter_snapshot& o) noexcept {
+        evaluations += o.evaluations;
+        searches += o.searches;
+        comparisons += o.comparisons;
+        extrapolations_left += o.extrapolations_left;
+        extrapolations_right += o.extrapolations_right;
+        cursor_hits += o.cursor_hits;
+        cache_hits += o.cache_hits;
+        cache_misses += o.cache_misses;
+        rebuilds += o.rebuilds;
+        for(std::size_t i = 0; i < histogram_size; ++i) {
+            histogram[i] += o.histogram[i];
+        }
+        return *this;
+    }
+};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief instrumentation policy that counts hot-path events
+ *        in per-thread counters
+ *
+ * @details Each thread updates its own counter block without any
+ *          synchronization (relaxed single-writer atomics). snapshot() sums
+ *          up the blocks of all threads (including those of already
+ *          terminated threads).
+ *          Different Tag types yield completely independent counter sets.
+ *
+ * @tparam Tag            distinguishes independent counter sets
+ * @tparam HistogramBins  number of bins of the optional query key histogram;
+ *                        queries are binned according to their relative
+ *                        position within the node key range of the map;
+ *                        0 disables the histogram
+ *
+ *****************************************************************************/
+template<class Tag = void, std::size_t HistogramBins = 0>
+class counting
+{
+    using count_type = std::uint64_t;
+    using counter_t_ = std::atomic<count_type>;
+
+    static constexpr std::size_t hist_size_ =
+        counter_snapshot<HistogramBins>::histogram_size;
+
+    //---------------------------------------------------------------
+    struct block_
+    {
+        counter_t_ evaluations {0};
+        counter_t_ searches {0};
+        counter_t_ comparisons {0};
+        counter_t_ extrapolations_left {0};
+        counter_t_ extrapolations_right {0};
+        counter_t_ cursor_hits {0};
+        counter_t_ cache_hits {0};
+        counter_t_ cache_misses {0};
+        counter_t_ rebuilds {0};
+        std::array<counter_t_,hist_size_> histogram;
+
+        block_() noexcept {
+            for(auto& h : histogram) h.store(0, std::memory_order_relaxed);
+        }
+
+        counter_snapshot<HistogramBins>
+        read() const noexcept {
+            constexpr auto r = std::memory_order_relaxed;
+            counter_snapshot<HistogramBins> s;
+            s.evaluations = evaluations.load(r);
+            s.searches = searches.load(r);
+            s.comparisons = comparisons.load(r);
+            s.extrapolations_left = extrapolations_left.load(r);
+            s.extrapolations_right = extrapolations_right.load(r);
+            s.cursor_hits = cursor_hits.load(r);
+            s.cache_hits = cache_hits.load(r);
+            s.cache_misses = cache_misses.load(r);
+            s.rebuilds = rebuilds.load(r);
+            for(std::size_t i = 0; i < hist_size_; ++i) {
+                s.histogram[i] = histogram[i].load(r);
+            }
+            return s;
+        }
+
+        void clear() noexcept {
+            constexpr auto r = std::memory_order_relaxed;
+            evaluations.store(0,r);
+            searches.store(0,r);
+            comparisons.store(0,r);
+            extrapolations_left.store(0,r);
+            extrapolations_right.store(0,r);
+            cursor_hits.store(0,r);
+            cache_hits.store(0,r);
+            cache_misses.store(0,r);
+            rebuilds.store(0,r);
+            for(auto& h : histogram) h.store(0,r);
+        }
+    };
+
+    //---------------------------------------------------------------
+    struct registry_
+    {
+        std::mutex mtx;
+        std::vector<const block_*> live;
+        counter_snapshot<HistogramBins> retired;
+    };
+
+    static registry_&
+    registry() {
+        static registry_ reg;
+        return reg;
+    }
+
+    //---------------------------------------------------------------
+    struct thread_block_ : public block_
+    {
+        thread_block_() {
+            auto& reg = registry();
+            std::lock_guard<std::mutex> lock{reg.mtx};
+            reg.live.push_back(this);
+        }
+        ~thread_block_() {
+            auto& reg = registry();
+            std::lock_guard<std::mutex> lock{reg.mtx};
+            reg.retired += this->read();
+            reg.live.erase(std::find(reg.live.begin(), reg.live.end(), this));
+        }
+    };
+
+    static block_&
+    local() {
+        thread_local thread_block_ b;
+        return b;
+    }
+
+    //---------------------------------------------------------------
+    static void
+    bump(counter_t_& c) noexcept {
+        //only the owning thread writes => no read-modify-write needed
+        c.store(c.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+    }
+
+
+public:
+    //---------------------------------------------------------------
+    using snapshot_type = counter_snapshot<HistogramBins>;
+
+    static constexpr bool enabled = true;
+
+
+    //---------------------------------------------------------------
+    // HOOKS
+    //---------------------------------------------------------------
+    static void evaluation()          { bump(local().evaluations); }
+    static void search()              { bump(local().searches); }
+    static void comparison()          { bump(local().comparisons); }
+    static void extrapolation_left()  { bump(local().extrapolations_left); }
+    static void extrapolation_right() { bump(local().extrapolations_right); }
+    static void cursor_hit()          { bump(local().cursor_hits); }
+    static void cache_hit()           { bump(local().cache_hits); }
+    static void cache_miss()          { bump(local().cache_misses); }
+    static void rebuild()             { bump(local().rebuilds); }
+
+    //-----------------------------------------------------
+    /**
+     * @brief records query key x relative to node key range [lo,hi]
+     */
+    template<class Key>
+    static void
+    query(const Key& x, const Key& lo, const Key& hi) {
+        record(x, lo, hi, std::integral_constant<bool,(HistogramBins > 0)>{});
+    }
+
+
+    //---------------------------------------------------------------
+    // COUNTER ACCESS
+    //---------------------------------------------------------------
+    ///@brief counter values of the calling thread
+    static snapshot_type
+    thread_snapshot() {
+        return local().read();
+    }
+
+    //-----------------------------------------------------
+    ///@brief sum of counter values of all threads
+    static snapshot_type
+    snapshot() {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock{reg.mtx};
+        auto s = reg.retired;
+        for(const auto b : reg.live) s += b->read();
+        return s;
+    }
+
+    //-----------------------------------------------------
+    /**
+     * @brief resets the counters of all threads
+     *        (increments that happen concurrently may get lost)
+     */
+    static void
+    reset() {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock{reg.mtx};
+        reg.retired = snapshot_type{};
+        for(const auto b : reg.live) const_cast<block_*>(b)->clear();
+    }
+
+
+private:
+    //---------------------------------------------------------------
+    template<class Key>
+    static void
+    record(const Key&, const Key&, const Key&, std::false_type) {}
+
+    template<class Key>
+    static void
+    record(const Key& x, const Key& lo, const Key& hi, std::true_type) {
+        std::size_t bin = 0;
+        if(x < lo) {
+            bin = 0;
+        }
+        else if(hi < x) {
+            bin = HistogramBins + 1;
+        }
+        else if(lo < hi) {
+            const auto rel = double(x - lo) / double(hi - lo);
+            bin = 1 + std::min(HistogramBins - 1,
+                               std::size_t(rel * double(HistogramBins)));
+        }
+        else {
+            bin = 1;
+        }
+        bump(local().histogram[bin]);
+    }
+
+};
+
+
+} //namespace instrumentation
+} //namespace am
+
+
+#endif
@@ -0,0 +1,220 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_INTERNING_H_
+#define AMLIB_INTERNING_H_
+
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include "copy_on_write.h"
+#include "gradients.h"
+
+
+namespace am {
+
+
+/*************************************************************************//***
+ *
+ * @brief deduplicates maps with identical nodes: all maps interned with
+ *        the same nodes share one canonical, immutable node storage
+ *        (copy_on_write => modifying an interned map makes a private copy)
+ *
+ * @details The registry only holds weak references; a canonical storage
+ *          is destroyed together with the last map that uses it.
+ *          Expired entries are removed by purge() and by intern()
+ *          calls that hash to the same value.
+ *          All members are thread-safe.
+ *
+ *          global() is a process-wide registry; other instances can be
+ *          used for narrower scopes.
+ *
+ * @tparam Map  interpolating_map; std::hash must be defined for its key
+ *              and mapped type; maps are only merged if interpolator and
+ *              key comparison are stateless (empty) classes
+ *
+ *****************************************************************************/
+template<class Map>
+class interning_registry
+{
+    static constexpr bool stateless_ =
+        std::is_empty<typename Map::interpolator_type>::value &&
+        std::is_empty<typename Map::key_compare>::value;
+
+public:
+    //---------------------------------------------------------------
+    using map_type = Map;
+    using value_type = copy_on_write<Map>;
+    using size_type = std::size_t;
+
+    //-----------------------------------------------------
+    struct statistics {
+        /// number of intern() calls
+        size_type requests = 0;
+        /// intern() calls that found an existing storage
+        size_type hits = 0;
+        /// canonical storages in use
+        size_type tables = 0;
+        /// maps that currently refer to a canonical storage
+        size_type references = 0;
+        /// node bytes currently in use / that would be in use without sharing
+        size_type bytes_used = 0;
+        size_type bytes_unshared = 0;
+
+        size_type bytes_saved() const noexcept {
+            return bytes_unshared - bytes_used;
+        }
+    };
+
+
+    //---------------------------------------------------------------
+    interning_registry() = default;
+
+    interning_registry(const interning_registry&) = delete;
+    interning_registry& operator = (const interning_registry&) = delete;
+
+
+    //---------------------------------------------------------------
+    ///@brief process-wide registry
+    static interning_registry&
+    global() {
+        static interning_registry r;
+        return r;
+    }
+
+
+    //---------------------------------------------------------------
+    /**
+     * @return map that refers to the canonical storage for m's nodes
+     */
+    value_type
+    intern(const Map& m) {
+        return intern_impl(m, [&] { return std::make_shared<Map>(m); });
+    }
+    //-----------------------------------------------------
+    value_type
+    intern(Map&& m) {
+        return intern_impl(m, [&] { return std::make_shared<Map>(std::move(m)); });
+    }
+    //-----------------------------------------------------
+    value_type
+    intern(const value_type& m) {
+        return intern(m.get());
+    }
+    //-----------------------------------------------------
+    /// gradient that refers to the canonical storage for g's nodes
+    template<class Arg, class Res, class I, class S>
+    interpolating_gradient<Arg,Res,I,storage::copy_on_write>
+    intern(const interpolating_gradient<Arg,Res,I,S>& g) {
+        static_assert(std::is_same<Map,interpolating_map<Arg,Res,I>>::value,
+                      "gradient has a different map type");
+        return interpolating_gradient<Arg,Res,I,storage::copy_on_write>{
+            intern(g.map())};
+    }
+
+
+    //---------------------------------------------------------------
+    ///@brief removes entries whose storage was destroyed
+    void
+    purge() {
+        std::lock_guard<std::mutex> lock{mutex_};
+        for(auto i = entries_.begin(); i != entries_.end(); ) {
+            if(i->second.expired()) i = entries_.erase(i); else ++i;
+        }
+    }
+
+    //-----------------------------------------------------
+    statistics
+    stats() const {
+        std::lock_guard<std::mutex> lock{mutex_};
+        statistics s = stats_;
+        for(const auto& e : entries_) {
+            if(const auto p = e.second.lock()) {
+                //-1: the local reference
+                const auto refs = size_type(p.use_count() - 1);
+                const auto bytes = p->size() * sizeof(typename Map::value_type);
+                ++s.tables;
+                s.references += refs;
+                s.bytes_used += bytes;
+                s.bytes_unshared += refs * bytes;
+            }
+        }
+        return s;
+    }
+
+
+private:
+    //---------------------------------------------------------------
+    static std::size_t
+    hash(const Map& m) {
+        std::hash<typename Map::key_type> hk;
+        std::hash<typename Map::mapped_type> hv;
+
+        std::size_t h = m.size();
+        const auto combine = [&h](std::size_t x) {
+            h ^= x + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        };
+        for(const auto& n : m) {
+            combine(hk(n.first));
+            combine(hv(n.second));
+        }
+        return h;
+    }
+
+
+    //---------------------------------------------------------------
+    template<class MakeStorage>
+    value_type
+    intern_impl(const Map& m, MakeStorage&& make_storage)
+    {
+        //can't tell if interpolators/comparators are equivalent
+        if(!stateless_) return value_type::adopt_shared(make_storage());
+
+        const auto h = hash(m);
+
+        std::lock_guard<std::mutex> lock{mutex_};
+        ++stats_.requests;
+
+        const auto range = entries_.equal_range(h);
+        for(auto i = range.first; i != range.second; ) {
+            auto p = i->second.lock();
+            if(!p) {
+                i = entries_.erase(i);
+            }
+            else if(p->size() == m.size() && *p == m) {
+                ++stats_.hits;
+                return value_type::adopt_shared(std::move(p));
+            }
+            else ++i;
+        }
+
+        auto p = make_storage();
+        entries_.emplace(h, p);
+        return value_type::adopt_shared(std::move(p));
+    }
+
+
+    //---------------------------------------------------------------
+    mutable std::mutex mutex_;
+    std::unordered_multimap<std::size_t,std::weak_ptr<Map>> entries_;
+    statistics stats_;
+};
+
+
+} //namespace am
+
+
+#endif
@@ -11,15 +11,35 @@
 #ifndef AMLIB_INTERPOLATING_MAP_H_
 #define AMLIB_INTERPOLATING_MAP_H_
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
 #include <numeric>
+#include <stdexcept>
+#include <type_traits>
 
 #include "interpolators.h"
+#include "node_cache.h"
+#include "sampling.h"
 #include "vector_map.h"
 
 
 namespace am {
 
 
+namespace detail {
+
+/// process-wide unique node set version numbers (never 0)
+inline std::uint64_t
+next_map_version() noexcept {
+    static std::atomic<std::uint64_t> v{0};
+    return v.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+} // namespace detail
+
+
 /*************************************************************************//***
  *
  * @brief Interpolation function with a std::map like interface.
@@ -31,6 +51,9 @@ namespace am {
  * @tparam Interpolator  function class that interpolates in-between nodes
  * @tparam KeyCompare    domain value comparison function class
  * @tparam Allocator     node allocator
+ * @tparam Instrumentation  hot-path event counting policy
+ *                          (see instrumentation.h);
+ *                          default: none (compiled out)
  *
  *****************************************************************************/
 template<
@@ -38,11 +61,13 @@ template<
     class MappedT,
     class Interpolator,
     class KeyCompare = std::less<KeyT>,
-    class Allocator = std::allocator<std::pair<const KeyT, MappedT> >
+    class Allocator = std::allocator<std::pair<const KeyT, MappedT> >,
+    class Instrumentation = instrumentation::none
 >
 class interpolating_map
 {
-    using nodes_t_ = vector_map<KeyT,MappedT,KeyCompare,Allocator>;
+    using nodes_t_ = vector_map<KeyT,MappedT,KeyCompare,Allocator,
+                                Instrumentation>;
 
 public:
     //---------------------------------------------------------------
@@ -53,7 +78,9 @@ public:
     //-----------------------------------------------------
     using interpolator_type = Interpolator;
     using key_compare  = KeyCompare;
+    using instrumentation_type = Instrumentation;
     //-----------------------------------------------------
+    using container_type = typename nodes_t_::container_type;
     using value_type   = typename nodes_t_::value_type;
     using allocator_type = typename nodes_t_::allocator_type;
     //-----------------------------------------------------
@@ -65,10 +92,12 @@ public:
     using size_type = typename nodes_t_::size_type;
     using difference_type = typename nodes_t_::difference_type;
     //-----------------------------------------------------
-    using iterator = typename nodes_t_::iterator;
+    //nodes can't be modified through iterators (like std::set)
+    //since keys must stay sorted and derived node data must stay valid
+    using iterator = typename nodes_t_::const_iterator;
     using const_iterator = typename nodes_t_::const_iterator;
     //-----------------------------------------------------
-    using reverse_iterator = typename nodes_t_::reverse_iterator;
+    using reverse_iterator = typename nodes_t_::const_reverse_iterator;
     using const_reverse_iterator = typename nodes_t_::const_reverse_iterator;
 
     //-----------------------------------------------------
@@ -127,7 +156,9 @@ public:
         const allocator_type& alloc = allocator_type())
     :
         ipl_(ipl), nodes_(il,comp,alloc)
-    {}
+    {
+        update_cache();
+    }
     //-----------------------------------------------------
     template <class InputIterator, class =
         std::enable_if_t<!std::is_same<value_type,InputIterator>()> >
@@ -138,41 +169,95 @@ public:
         const allocator_type& alloc = allocator_type())
     :
         ipl_(ipl), nodes_(first,last,comp,alloc)
-    {}
+    {
+        update_cache();
+    }
+    //-----------------------------------------------------
+    /**
+     * @brief adopts nodes that are already sorted by key in O(n)
+     * @pre   [first,last) is sorted in ascending key order
+     */
+    template <class InputIterator>
+    interpolating_map(
+        sorted_range_t,
+        InputIterator first, InputIterator last,
+        const interpolator_type& ipl = interpolator_type(),
+        const key_compare& comp = key_compare(),
+        const allocator_type& alloc = allocator_type())
+    :
+        ipl_(ipl), nodes_(sorted_range,first,last,comp,alloc)
+    {
+        update_cache();
+    }
+    //-----------------------------------------------------
+    /**
+     * @brief takes over a node container that is already sorted by key
+     *        in O(1)
+     * @pre   nodes are sorted in ascending key order
+     */
+    interpolating_map(
+        sorted_range_t,
+        container_type&& nodes,
+        const interpolator_type& ipl = interpolator_type(),
+        const key_compare& comp = key_compare())
+    :
+        ipl_(ipl), nodes_(sorted_range,std::move(nodes),comp)
+    {
+        update_cache();
+    }
 
 
     //---------------------------------------------------------------
     // COPY / MOVE CONSTRUCTION
     //---------------------------------------------------------------
     interpolating_map(const interpolating_map& source):
-        ipl_(source.ipl_), nodes_(source.nodes_)
+        ipl_(source.ipl_), nodes_(source.nodes_), cache_(source.cache_),
+        version_(source.version_)
     {}
     //-----------------------------------------------------
     interpolating_map(
         const interpolating_map& source, const allocator_type& alloc)
     :
-        ipl_(source.ipl_), nodes_(source.nodes_,alloc)
+        ipl_(source.ipl_), nodes_(source.nodes_,alloc), cache_(source.cache_),
+        version_(source.version_)
     {}
     //-----------------------------------------------------
     interpolating_map(interpolating_map&& source) noexcept :
-        ipl_(std::move(source.ipl_)), nodes_(std::move(source.nodes_))
-    {}
+        ipl_(std::move(source.ipl_)), nodes_(std::move(source.nodes_)),
+        cache_(std::move(source.cache_)),
+        version_(source.version_)
+    {
+        source.version_ = detail::next_map_version();
+    }
     //-----------------------------------------------------
     interpolating_map(interpolating_map&& source, const allocator_type& alloc) noexcept :
-        ipl_(std::move(source.ipl_)), nodes_(std::move(source.nodes_), alloc)
-    {}
+        ipl_(std::move(source.ipl_)), nodes_(std::move(source.nodes_), alloc),
+        cache_(std::move(source.cache_)),
+        version_(source.version_)
+    {
+        source.version_ = detail::next_map_version();
+    }
 
 
     //---------------------------------------------------------------
     // ASSIGNMENT
     //---------------------------------------------------------------
     interpolating_map&
-    operator = (const interpolating_map&) = default;
+    operator = (const interpolating_map& source) {
+        ipl_ = source.ipl_;
+        nodes_ = source.nodes_;
+        cache_ = source.cache_;
+        version_ = source.version_;
+        return *this;
+    }
     //-----------------------------------------------------
     interpolating_map&
-    operator = (const interpolating_map&& source) noexcept {
+    operator = (interpolating_map&& source) noexcept {
         ipl_ = std::move(source.ipl_);
         nodes_ = std::move(source.nodes_);
+        cache_ = std::move(source.cache_);
+        version_ = source.version_;
+        source.version_ = detail::next_map_version();
         return *this;
     }
 
@@ -180,10 +265,12 @@ public:
     template<class InputIterator>
     void assign(InputIterator first, InputIterator last) {
         nodes_.assign(first,last);
+        update_cache();
     }
     //-----------------------------------------------------
     void assign(std::initializer_list<value_type> il) {
         nodes_.assign(il.begin(), il.end());
+        update_cache();
     }
 
 
@@ -192,36 +279,107 @@ public:
     //---------------------------------------------------------------
     mapped_type
     operator () (const key_type& x) const {
-        return ipl_(nodes_.begin(), nodes_.end(), x);
+        record(x, instrumented_{});
+        return lookup(x, cached_{}, instrumented_{});
     }
     //-----------------------------------------------------
     template<class Arg1, class Arg2, class... Args>
     mapped_type
     operator () (Arg1&& arg1, Arg2&& arg2, Args... args) const {
-        return ipl_(nodes_.begin(), nodes_.end(),
-                    key_type(std::forward<Arg1>(arg1),
-                             std::forward<Arg2>(arg2),
-                             std::forward<Args>(args)...) );
+        return operator()(key_type(std::forward<Arg1>(arg1),
+                                   std::forward<Arg2>(arg2),
+                                   std::forward<Args>(args)...) );
+    }
+
+
+    //-----------------------------------------------------
+    /**
+     * @brief batch evaluation: writes the interpolated values for all keys
+     *        in [first,last) to out; uses the interpolator's batch kernel
+     *        if it has one
+     *
+     * @tparam Group  number of node searches that the batch kernels of the
+     *                built-in interpolators run interleaved; larger groups
+     *                hide more memory latency for maps beyond the caches
+     */
+    template<std::size_t Group = search::default_group_size,
+             class InputIterator, class OutputIterator>
+    OutputIterator
+    evaluate(InputIterator first, InputIterator last, OutputIterator out) const
+    {
+        using batch = std::integral_constant<bool,
+            !instrumented_::value && !cached_::value &&
+            interpolator::has_batch_evaluation<interpolator_type,
+                const_iterator,InputIterator,OutputIterator>::value>;
+
+        return evaluate<Group>(first, last, out, batch{});
+    }
+
+
+    //-----------------------------------------------------
+    /**
+     * @brief lazy view of the interpolated values at all keys in 'keys';
+     *        values are computed on access, ascending keys need no search
+     * @details C++20: views are held by value, temporary containers
+     *          are moved into the view; C++14: keys must be an lvalue
+     * @pre   the map must not be modified while the view is in use
+     */
+    template<class Range>
+    auto
+    sample(Range&& keys) const {
+        return std::forward<Range>(keys) | sampled(*this);
+    }
+
+    //-----------------------------------------------------
+    /**
+     * @brief lazy view of the interpolated values at n equidistant keys
+     *        in [a,b]
+     * @pre   the map must not be modified while the view is in use
+     */
+    uniform_sample_view<interpolating_map>
+    sample_uniform(const key_type& a, const key_type& b, size_type n) const {
+        return {*this, a, b, n};
     }
 
 
     //---------------------------------------------------------------
-    // ELEMENT ACCESS
+    // DERIVED NODE DATA
     //---------------------------------------------------------------
-    value_type&
-    operator [] (size_type index) {
-        return nodes_[index];
+    /**
+     * @brief selects how node data that is derived by the interpolator
+     *        (see interpolator::node_cache) is rebuilt after modifications;
+     *        interpolators without derived data are not affected
+     */
+    void
+    set_rebuild_mode(rebuild_mode mode) noexcept {
+        set_rebuild_mode(mode, cached_{});
     }
     //-----------------------------------------------------
-    const value_type&
-    operator [] (size_type index) const {
-        return nodes_[index];
+    rebuild_mode
+    get_rebuild_mode() const noexcept {
+        return get_rebuild_mode(cached_{});
     }
 
     //-----------------------------------------------------
-    value_type&
-    at(size_type index) {
-        return nodes_.at(index);
+    /**
+     * @brief future that is ready when the derived node data for the
+     *        current nodes is in use;
+     *        rethrows exceptions from a background rebuild
+     */
+    std::shared_future<void>
+    rebuilt() const {
+        return rebuilt(cached_{});
+    }
+
+
+    //---------------------------------------------------------------
+    // ELEMENT ACCESS
+    //---------------------------------------------------------------
+    //nodes are read-only (see iterator); use assign_values or
+    //transform_values to modify mapped values
+    const value_type&
+    operator [] (size_type index) const {
+        return nodes_[index];
     }
     //-----------------------------------------------------
     const value_type&
@@ -245,56 +403,109 @@ public:
     max_size() const {
         return nodes_.max_size();
     }
+    //-----------------------------------------------------
+    ///@brief number of nodes that fit into the buffer without reallocation
+    size_type
+    capacity() const noexcept {
+        return nodes_.capacity();
+    }
+
+
+    //---------------------------------------------------------------
+    /// allocates node memory in advance (e.g. before inserting many nodes)
+    void
+    reserve(size_type n) {
+        nodes_.reserve(n);
+    }
+    //-----------------------------------------------------
+    /**
+     * @brief releases unused node capacity and unused capacity of
+     *        derived node data (if not shared with copies of the map)
+     */
+    void
+    shrink_to_fit() {
+        nodes_.shrink_to_fit();
+        shrink_cache(cached_{});
+    }
+
+    //-----------------------------------------------------
+    ///@brief heap memory held by nodes and derived node data
+    memory_footprint
+    footprint() const {
+        auto f = nodes_.footprint();
+        f.cache = cache_memory_usage(cached_{});
+        return f;
+    }
 
 
     //---------------------------------------------------------------
     template<class... Args>
     iterator
     emplace(Args&&... args) {
-        return nodes_.emplace(std::forward<Args>(args)...);
+        auto it = nodes_.emplace(std::forward<Args>(args)...);
+        update_nodes(index_of(it), 0, 1);
+        return it;
     }
 
 
     //---------------------------------------------------------------
     iterator
     insert(const value_type& val) {
-        return nodes_.insert(val);
+        auto it = nodes_.insert(val);
+        update_nodes(index_of(it), 0, 1);
+        return it;
     }
 
     //-----------------------------------------------------
     template<class V>
     iterator
     insert(V&& val) {
-        return nodes_.insert(std::forward<V>(val));
+        auto it = nodes_.insert(std::forward<V>(val));
+        update_nodes(index_of(it), 0, 1);
+        return it;
     }
 
     //-----------------------------------------------------
     template <class InputIterator>
     iterator
     insert(InputIterator first, InputIterator last) {
-        return nodes_.insert(first,last);
+        auto it = nodes_.insert(first,last);
+        update_cache();
+        return it;
     }
     //-----------------------------------------------------
     iterator
     insert(std::initializer_list<value_type> il) {
-        return nodes_.insert(il);
+        auto it = nodes_.insert(il);
+        update_cache();
+        return it;
     }
 
 
     //-----------------------------------------------------
     size_type
     erase(const key_type& key) {
-        return nodes_.erase(key);
+        const auto pos = index_of(nodes_.lower_bound(key));
+        const auto n = nodes_.erase(key);
+        update_nodes(pos, n, 0);
+        return n;
     }
     //-----------------------------------------------------
     iterator
     erase(const_iterator pos) {
-        return nodes_.erase(pos);
+        const auto i = index_of(pos);
+        auto it = nodes_.erase(pos);
+        update_nodes(i, 1, 0);
+        return it;
     }
     //-----------------------------------------------------
     iterator
     erase(const_iterator first, const_iterator last) {
-        return nodes_.erase(first,last);
+        const auto i = index_of(first);
+        const auto n = size_type(std::distance(first,last));
+        auto it = nodes_.erase(first,last);
+        update_nodes(i, n, 0);
+        return it;
     }
 
 
@@ -302,6 +513,89 @@ public:
     void
     clear() {
         nodes_.clear();
+        update_cache();
+    }
+
+    //---------------------------------------------------------------
+    // VALUE UPDATES
+    // keys are left untouched => no re-sorting; derived node data
+    // is only refreshed for the affected nodes if the interpolator
+    // supports it (see interpolator::node_cache)
+    //---------------------------------------------------------------
+    /**
+     * @brief replaces the mapped values of the nodes
+     *        [pos, pos + distance(first,last)) with the values in [first,last)
+     *
+     * @tparam ForwardIterator  to values convertible to mapped_type
+     *
+     * @throws std::out_of_range if the range exceeds the last node
+     */
+    template<class ForwardIterator>
+    void
+    assign_values(size_type pos, ForwardIterator first, ForwardIterator last)
+    {
+        const auto n = size_type(std::distance(first,last));
+        if(pos > size() || n > size() - pos) {
+            throw std::out_of_range{"interpolating_map::assign_values"};
+        }
+        for(auto i = pos; first != last; ++first, ++i) {
+            nodes_.mapped(i) = *first;
+        }
+        update_values(pos, pos + n);
+    }
+    //-----------------------------------------------------
+    template<class ForwardIterator, class = std::enable_if_t<
+        !std::is_integral<ForwardIterator>::value>>
+    void
+    assign_values(ForwardIterator first, ForwardIterator last) {
+        assign_values(0, first, last);
+    }
+    //-----------------------------------------------------
+    void
+    assign_values(size_type pos, std::initializer_list<mapped_type> il) {
+        assign_values(pos, il.begin(), il.end());
+    }
+
+
+    //-----------------------------------------------------
+    /**
+     * @brief value = op(key, value) for the nodes [first,last)
+     *
+     * @details If op throws, the values that were already transformed
+     *          keep their new values.
+     */
+    template<class BinaryOp>
+    void
+    transform_values(size_type first, size_type last, BinaryOp op)
+    {
+        last = std::min(last, size());
+        auto i = first;
+        try {
+            for(; i < last; ++i) {
+                nodes_.mapped(i) = op(nodes_[i].first, nodes_[i].second);
+            }
+        }
+        catch(...) {
+            update_values(first, i);
+            throw;
+        }
+        update_values(first, last);
+    }
+    //-----------------------------------------------------
+    template<class BinaryOp>
+    void
+    transform_values(BinaryOp op) {
+        transform_values(0, size(), std::move(op));
+    }
+
+
+    //-----------------------------------------------------
+    ///@brief moves the node container out; leaves the map empty
+    container_type
+    extract() {
+        auto nodes = nodes_.extract();
+        update_cache();
+        return nodes;
     }
 
 
@@ -339,6 +633,26 @@ public:
         return nodes_.upper_bound(k);
     }
 
+    //-----------------------------------------------------
+    /// batch lower_bound/upper_bound; see vector_map::lower_bounds
+    template<std::size_t Group = search::default_group_size,
+             class InputIterator, class OutputIterator>
+    OutputIterator
+    lower_bounds(InputIterator first, InputIterator last,
+                 OutputIterator out) const
+    {
+        return nodes_.template lower_bounds<Group>(first, last, out);
+    }
+    //-----------------------------------------------------
+    template<std::size_t Group = search::default_group_size,
+             class InputIterator, class OutputIterator>
+    OutputIterator
+    upper_bounds(InputIterator first, InputIterator last,
+                 OutputIterator out) const
+    {
+        return nodes_.template upper_bounds<Group>(first, last, out);
+    }
+
     //-----------------------------------------------------
     std::pair<iterator,iterator>
     equal_range(const key_type& k) {
@@ -379,6 +693,16 @@ public:
         return nodes_.get_allocator();
     }
 
+    //-----------------------------------------------------
+    /**
+     * @brief process-wide unique number of the current node set;
+     *        changes with every modification (copies share it)
+     */
+    std::uint64_t
+    version() const noexcept {
+        return version_;
+    }
+
 
     //---------------------------------------------------------------
     void
@@ -387,6 +711,8 @@ public:
 
         swap(ipl_, other.ipl_);
         nodes_.swap(other.nodes_);
+        swap(cache_, other.cache_);
+        swap(version_, other.version_);
     }
 
 
@@ -411,9 +737,225 @@ public:
 
 
 private:
+    //---------------------------------------------------------------
+    using instrumented_ = std::integral_constant<bool,Instrumentation::enabled>;
+    using cache_traits_ = interpolator::node_cache<Interpolator,KeyT,MappedT>;
+    using cached_ = std::integral_constant<bool,cache_traits_::value>;
+    using cache_t_ = std::conditional_t<cached_::value,
+        detail::node_cache_holder<Interpolator,KeyT,MappedT>,
+        interpolator::no_node_cache>;
+
+
+    //---------------------------------------------------------------
+    void
+    record(const key_type&, std::false_type) const {}
+    //-----------------------------------------------------
+    void
+    record(const key_type& x, std::true_type) const {
+        Instrumentation::evaluation();
+        if(!nodes_.empty()) {
+            const auto& lo = nodes_.front().first;
+            const auto& hi = nodes_.back().first;
+            if(x < lo) {
+                Instrumentation::extrapolation_left();
+            } else if(hi < x) {
+                Instrumentation::extrapolation_right();
+            }
+            Instrumentation::query(x, lo, hi);
+        }
+    }
+
+
+    //---------------------------------------------------------------
+    mapped_type
+    lookup(const key_type& x, std::false_type, std::false_type) const {
+        return ipl_(nodes_.begin(), nodes_.end(), x);
+    }
+    //-----------------------------------------------------
+    mapped_type
+    lookup(const key_type& x, std::false_type, std::true_type) const {
+        return ipl_(nodes_.begin(), nodes_.end(), x, Instrumentation{});
+    }
+    //-----------------------------------------------------
+    template<class Instrumented>
+    mapped_type
+    lookup(const key_type& x, std::true_type, Instrumented) const {
+        if(const auto* c = cache_.get()) {
+            return ipl_.interpolate(*c, x, Instrumentation{});
+        }
+        //background rebuild not finished yet
+        return ipl_(nodes_.begin(), nodes_.end(), x, Instrumentation{});
+    }
+
+
+    //---------------------------------------------------------------
+    /// (re-)builds node data that is derived by the interpolator
+    void
+    update_cache() {
+        version_ = detail::next_map_version();
+        update_cache(cached_{});
+    }
+    //-----------------------------------------------------
+    void
+    update_cache(std::false_type) {}
+    //-----------------------------------------------------
+    void
+    update_cache(std::true_type) {
+        Instrumentation::rebuild();
+        cache_.update(ipl_, nodes_);
+    }
+
+
+    //---------------------------------------------------------------
+    size_type
+    index_of(const_iterator it) const noexcept {
+        return size_type(std::distance(nodes_.begin(), it));
+    }
+
+    //-----------------------------------------------------
+    /**
+     * @brief after 'erased' nodes at index pos were replaced by
+     *        'inserted' nodes; derived data is only updated around pos
+     *        if the interpolator supports it (see interpolator::node_cache)
+     */
+    void
+    update_nodes(size_type pos, size_type erased, size_type inserted) {
+        if(erased == 0 && inserted == 0) return;
+        version_ = detail::next_map_version();
+        update_nodes(pos, erased, inserted, cached_{});
+    }
+    //-----------------------------------------------------
+    void
+    update_nodes(size_type, size_type, size_type, std::false_type) {}
+    //-----------------------------------------------------
+    void
+    update_nodes(size_type pos, size_type erased, size_type inserted,
+                 std::true_type)
+    {
+        if(!cache_.update_nodes(ipl_, nodes_, pos, erased, inserted)) {
+            Instrumentation::rebuild();
+        }
+    }
+
+
+    //---------------------------------------------------------------
+    /// after modifying the mapped values of nodes [first,last)
+    void
+    update_values(size_type first, size_type last) {
+        if(first >= last) return;
+        version_ = detail::next_map_version();
+        update_values(first, last, cached_{});
+    }
+    //-----------------------------------------------------
+    void
+    update_values(size_type, size_type, std::false_type) {}
+    //-----------------------------------------------------
+    void
+    update_values(size_type first, size_type last, std::true_type) {
+        if(!cache_.update_values(ipl_, nodes_, first, last)) {
+            Instrumentation::rebuild();
+        }
+    }
+
+
+    //---------------------------------------------------------------
+    void
+    shrink_cache(std::false_type) noexcept {}
+    //-----------------------------------------------------
+    void
+    shrink_cache(std::true_type) {
+        cache_.shrink_to_fit();
+    }
+    //-----------------------------------------------------
+    std::size_t
+    cache_memory_usage(std::false_type) const noexcept {
+        return 0;
+    }
+    //-----------------------------------------------------
+    std::size_t
+    cache_memory_usage(std::true_type) const {
+        return cache_.memory_usage(ipl_);
+    }
+
+
+    //---------------------------------------------------------------
+    void
+    set_rebuild_mode(rebuild_mode, std::false_type) noexcept {}
+    //-----------------------------------------------------
+    void
+    set_rebuild_mode(rebuild_mode mode, std::true_type) noexcept {
+        cache_.mode(mode);
+    }
+    //-----------------------------------------------------
+    rebuild_mode
+    get_rebuild_mode(std::false_type) const noexcept {
+        return rebuild_mode::synchronous;
+    }
+    //-----------------------------------------------------
+    rebuild_mode
+    get_rebuild_mode(std::true_type) const noexcept {
+        return cache_.mode();
+    }
+    //-----------------------------------------------------
+    std::shared_future<void>
+    rebuilt(std::false_type) const {
+        std::promise<void> p;
+        p.set_value();
+        return p.get_future().share();
+    }
+    //-----------------------------------------------------
+    std::shared_future<void>
+    rebuilt(std::true_type) const {
+        return cache_.pending();
+    }
+
+
+    //-----------------------------------------------------
+    template<std::size_t Group, class InputIterator, class OutputIterator>
+    OutputIterator
+    evaluate(InputIterator first, InputIterator last, OutputIterator out,
+             std::true_type) const
+    {
+        using grouped = interpolator::has_grouped_batch_evaluation<
+            interpolator_type,const_iterator,InputIterator,OutputIterator>;
+
+        return evaluate_batch<Group>(first, last, out, grouped{});
+    }
+    //-----------------------------------------------------
+    template<std::size_t, class InputIterator, class OutputIterator>
+    OutputIterator
+    evaluate(InputIterator first, InputIterator last, OutputIterator out,
+             std::false_type) const
+    {
+        for(; first != last; ++first, ++out) {
+            *out = operator()(*first);
+        }
+        return out;
+    }
+    //-----------------------------------------------------
+    template<std::size_t Group, class InputIterator, class OutputIterator>
+    OutputIterator
+    evaluate_batch(InputIterator first, InputIterator last, OutputIterator out,
+                   std::true_type) const
+    {
+        return ipl_.template evaluate<Group>(nodes_.begin(), nodes_.end(),
+                                             first, last, out);
+    }
+    //-----------------------------------------------------
+    template<std::size_t, class InputIterator, class OutputIterator>
+    OutputIterator
+    evaluate_batch(InputIterator first, InputIterator last, OutputIterator out,
+                   std::false_type) const
+    {
+        return ipl_.evaluate(nodes_.begin(), nodes_.end(), first, last, out);
+    }
+
+
     //---------------------------------------------------------------
     interpolator_type ipl_;
     nodes_t_ nodes_;
+    cache_t_ cache_;
+    std::uint64_t version_ = detail::next_map_version();
 
 };
 
@@ -430,11 +972,12 @@ template<
     class Key,
     class Value,
     class KeyCompare = std::less<Key>,
-    class Allocator = std::allocator<std::pair<const Key,Value>>
+    class Allocator = std::allocator<std::pair<const Key,Value>>,
+    class Instrumentation = instrumentation::none
 >
 using piecewise_constant_map =
         interpolating_map<Key,Value,interpolator::piecewise_constant,
-                          KeyCompare,Allocator>;
+                          KeyCompare,Allocator,Instrumentation>;
 
 
 
@@ -446,11 +989,12 @@ template<
     class Key,
     class Value,
     class KeyCompare = std::less<Key>,
-    class Allocator = std::allocator<std::pair<const Key,Value>>
+    class Allocator = std::allocator<std::pair<const Key,Value>>,
+    class Instrumentation = instrumentation::none
 >
 using piecewise_linear_map =
         interpolating_map<Key,Value,interpolator::piecewise_linear,
-                          KeyCompare,Allocator>;
+                          KeyCompare,Allocator,Instrumentation>;
 
 
 
@@ -462,11 +1006,27 @@ template<
     class Key,
     class Value,
     class KeyCompare = std::less<Key>,
-    class Allocator = std::allocator<std::pair<const Key,Value>>
+    class Allocator = std::allocator<std::pair<const Key,Value>>,
+    class Instrumentation = instrumentation::none
 >
 using piecewise_log_linear_map =
         interpolating_map<Key,Value,interpolator::piecewise_log_linear,
-                          KeyCompare,Allocator>;
+                          KeyCompare,Allocator,Instrumentation>;
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief the map itself (see copy_on_write.h)
+ *
+ *****************************************************************************/
+template<class K, class T, class I, class C, class A, class P>
+inline const interpolating_map<K,T,I,C,A,P>&
+underlying_map(const interpolating_map<K,T,I,C,A,P>& m) noexcept
+{
+    return m;
+}
 
 
 
@@ -476,9 +1036,9 @@ using piecewise_log_linear_map =
  * @brief free-standing swap of 2 interpolating maps
  *
  *****************************************************************************/
-template<class K, class T, class I, class C, class A>
+template<class K, class T, class I, class C, class A, class P>
 inline void
-swap(interpolating_map<K,T,I,C,A>& a, interpolating_map<K,T,I,C,A>& b)
+swap(interpolating_map<K,T,I,C,A,P>& a, interpolating_map<K,T,I,C,A,P>& b)
 {
     a.swap(b);
 }
@@ -491,19 +1051,19 @@ swap(interpolating_map<K,T,I,C,A>& a, interpolating_map<K,T,I,C,A>& b)
  * RELATIONAL OPERATORS
  *
  *****************************************************************************/
-template<class K, class T, class I, class C, class A>
+template<class K, class T, class I, class C, class A, class P>
 inline bool
-operator == (const interpolating_map<K,T,I,C,A>& a,
-             const interpolating_map<K,T,I,C,A>& b)
+operator == (const interpolating_map<K,T,I,C,A,P>& a,
+             const interpolating_map<K,T,I,C,A,P>& b)
 {
     return std::equal(a.begin(), a.end(), b.begin());
 }
 
 //---------------------------------------------------------
-template<class K, class T, class I, class C, class A>
+template<class K, class T, class I, class C, class A, class P>
 inline bool
-operator != (const interpolating_map<K,T,I,C,A>& a,
-             const interpolating_map<K,T,I,C,A>& b)
+operator != (const interpolating_map<K,T,I,C,A,P>& a,
+             const interpolating_map<K,T,I,C,A,P>& b)
 {
     return !operator==(a,b);
 }
@@ -511,39 +1071,39 @@ operator != (const interpolating_map<K,T,I,C,A>& a,
 
 
 //-------------------------------------------------------------------
-template<class K, class T, class I, class C, class A>
+template<class K, class T, class I, class C, class A, class P>
 inline bool
-operator < (const interpolating_map<K,T,I,C,A>& a,
-            const interpolating_map<K,T,I,C,A>& b)
+operator < (const interpolating_map<K,T,I,C,A,P>& a,
+            const interpolating_map<K,T,I,C,A,P>& b)
 {
     return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
 }
 
 //-------------------------------------------------------------------
-template<class K, class T, class I, class C, class A>
+template<class K, class T, class I, class C, class A, class P>
 inline bool
-operator <= (const interpolating_map<K,T,I,C,A>& a,
-             const interpolating_map<K,T,I,C,A>& b)
+operator <= (const interpolating_map<K,T,I,C,A,P>& a,
+             const interpolating_map<K,T,I,C,A,P>& b)
 {
 
     return operator==(a,b) || operator<(a,b);
 }
 
 //-------------------------------------------------------------------
-template<class K, class T, class I, class C, class A>
+template<class K, class T, class I, class C, class A, class P>
 inline bool
-operator > (const interpolating_map<K,T,I,C,A>& a,
-            const interpolating_map<K,T,I,C,A>& b)
+operator > (const interpolating_map<K,T,I,C,A,P>& a,
+            const interpolating_map<K,T,I,C,A,P>& b)
 {
 
     return !operator<(a,b);
 }
 
 //-------------------------------------------------------------------
-template<class K, class T, class I, class C, class A>
+template<class K, class T, class I, class C, class A, class P>
 inline bool
-operator >= (const interpolating_map<K,T,I,C,A>& a,
-             const interpolating_map<K,T,I,C,A>& b)
+operator >= (const interpolating_map<K,T,I,C,A,P>& a,
+             const interpolating_map<K,T,I,C,A,P>& b)
 {
 
     return operator==(a,b) || operator>(a,b);
@@ -559,25 +1119,25 @@ operator >= (const interpolating_map<K,T,I,C,A>& a,
  * NON-MEMBER BEGIN/END
  *
  *****************************************************************************/
-template<class K, class T, class I, class C, class A>
+template<class K, class T, class I, class C, class A, class P>
 inline decltype(auto)
-begin(interpolating_map<K,T,I,C,A>& m)
+begin(interpolating_map<K,T,I,C,A,P>& m)
 {
     return m.begin();
 }
 
 //---------------------------------------------------------
-template<class K, class T, class I, class C, class A>
+template<class K, class T, class I, class C, class A, class P>
 inline decltype(auto)
-begin(const interpolating_map<K,T,I,C,A>& m)
+begin(const interpolating_map<K,T,I,C,A,P>& m)
 {
     return m.begin();
 }
 
 //---------------------------------------------------------
-template<class K, class T, class I, class C, class A>
+template<class K, class T, class I, class C, class A, class P>
 inline decltype(auto)
-cbegin(const interpolating_map<K,T,I,C,A>& m)
+cbegin(const interpolating_map<K,T,I,C,A,P>& m)
 {
     return m.cbegin();
 }
@@ -585,25 +1145,25 @@ cbegin(const interpolating_map<K,T,I,C,A>& m)
 
 
 //-------------------------------------------------------------------
-template<class K, class T, class I, class C, class A>
+template<class K, class T, class I, class C, class A, class P>
 inline decltype(auto)
-end(interpolating_map<K,T,I,C,A>& m)
+end(interpolating_map<K,T,I,C,A,P>& m)
 {
     return m.end();
 }
 
 //---------------------------------------------------------
-template<class K, class T, class I, class C, class A>
+template<class K, class T, class I, class C, class A, class P>
 inline decltype(auto)
-end(const interpolating_map<K,T,I,C,A>& m)
+end(const interpolating_map<K,T,I,C,A,P>& m)
 {
     return m.end();
 }
 
 //---------------------------------------------------------
-template<class K, class T, class I, class C, class A>
+template<class K, class T, class I, class C, class A, class P>
 inline decltype(auto)
-cend(const interpolating_map<K,T,I,C,A>& m)
+cend(const interpolating_map<K,T,I,C,A,P>& m)
 {
     return m.cend();
 }
@@ -618,39 +1178,39 @@ cend(const interpolating_map<K,T,I,C,A>& m)
  * STATISTICS
  *
  *****************************************************************************/
-template<class K, class T, class I, class C, class A>
+template<class K, class T, class I, class C, class A, class P>
 inline auto
-min(const interpolating_map<K,T,I,C,A>& in)
+min(const interpolating_map<K,T,I,C,A,P>& in)
 {
     return *std::min_element(in.begin(), in.end(),
         [](const auto& a, const auto& b) { return a.second < b.second; });
 }
 
 //---------------------------------------------------------
-template<class K, class T, class I, class C, class A>
+template<class K, class T, class I, class C, class A, class P>
 inline auto
-max(const interpolating_map<K,T,I,C,A>& in)
+max(const interpolating_map<K,T,I,C,A,P>& in)
 {
     return *std::max_element(in.begin(), in.end(),
         [](const auto& a, const auto& b) { return a.second < b.second; });
 }
 
 //---------------------------------------------------------
-template<class K, class T, class I, class C, class A>
+template<class K, class T, class I, class C, class A, class P>
 inline auto
-total(const interpolating_map<K,T,I,C,A>& in)
+total(const interpolating_map<K,T,I,C,A,P>& in)
 {
     return *std::accumulate(in.begin(), in.end(), T(0),
         [](const auto& a, const auto& b) { return a.second + b.second; });
 }
 
 //---------------------------------------------------------
-template<class K, class T, class I, class C, class A>
+template<class K, class T, class I, class C, class A, class P>
 inline auto
-mean(const interpolating_map<K,T,I,C,A>& in)
+mean(const interpolating_map<K,T,I,C,A,P>& in)
 {
     return total(in) /
-        typename interpolating_map<K,T,I,C,A>::mapped_type(in.size());
+        typename interpolating_map<K,T,I,C,A,P>::mapped_type(in.size());
 }
 
 
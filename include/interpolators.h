@@ -15,9 +15,192 @@
 #include <type_traits>
 #include <algorithm>
 #include <cmath>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+#include "instrumentation.h"
+#include "search.h"
 
 
 namespace am {
+
+
+/*****************************************************************************
+ *
+ * EXTRAPOLATION POLICIES
+ *
+ * decide the result for keys outside of the node key range [lo,hi];
+ * 'below'/'above' flag out-of-range keys, 'v' is the value obtained from
+ * extending the boundary segments
+ *
+ *****************************************************************************/
+namespace extrapolation {
+
+/*************************************************************************//***
+ *
+ * @brief extends the boundary segments (no range checks at all)
+ *
+ *****************************************************************************/
+struct linear
+{
+    template<class Node, class Result>
+    constexpr Result
+    operator () (bool, bool, const Node&, const Node&, Result v) const noexcept {
+        return v;
+    }
+};
+
+
+
+/*************************************************************************//***
+ *
+ * @brief returns the value of the nearest boundary node
+ *
+ *****************************************************************************/
+struct clamp
+{
+    template<class Node, class Result>
+    constexpr Result
+    operator () (bool below, bool above,
+                 const Node& lo, const Node& hi, Result v) const
+    {
+        return below ? Result(lo.second) : (above ? Result(hi.second) : v);
+    }
+};
+
+
+
+/*************************************************************************//***
+ *
+ * @brief returns a constant value
+ *
+ *****************************************************************************/
+template<class T>
+struct constant
+{
+    T value;
+
+    template<class Node, class Result>
+    constexpr Result
+    operator () (bool below, bool above,
+                 const Node&, const Node&, Result v) const
+    {
+        return (below || above) ? Result(value) : v;
+    }
+};
+
+
+
+/*************************************************************************//***
+ *
+ * @brief returns a quiet NaN
+ *
+ *****************************************************************************/
+struct nan
+{
+    template<class Node, class Result>
+    constexpr Result
+    operator () (bool below, bool above,
+                 const Node&, const Node&, Result v) const
+    {
+        static_assert(std::numeric_limits<Result>::has_quiet_NaN,
+                      "result type has no quiet NaN");
+
+        return (below || above) ? std::numeric_limits<Result>::quiet_NaN() : v;
+    }
+};
+
+
+
+/*************************************************************************//***
+ *
+ * @brief throws std::out_of_range
+ *
+ *****************************************************************************/
+struct checked
+{
+    template<class Node, class Result>
+    Result
+    operator () (bool below, bool above,
+                 const Node&, const Node&, Result v) const
+    {
+        if(below || above) {
+            throw std::out_of_range{"interpolation key outside of node range"};
+        }
+        return v;
+    }
+};
+
+} //namespace extrapolation
+
+
+
+
+/*****************************************************************************
+ *
+ * PRECISION POLICIES
+ *
+ * select the type in which interpolators compute from the storage type T
+ * of keys/values:  template<class T> using type = ...;
+ * (non-arithmetic types like colors or vectors are never converted)
+ *
+ *****************************************************************************/
+namespace precision {
+
+/*************************************************************************//***
+ *
+ * @brief computes at least in type Min: std::common_type_t<Min,T>
+ *        (default; float data is computed in double)
+ *
+ *****************************************************************************/
+template<class Min = double>
+struct promote
+{
+    static_assert(std::is_floating_point<Min>::value,
+                  "expects floating point type");
+
+    template<class T>
+    using type = std::common_type_t<Min,T>;
+};
+
+
+
+/*************************************************************************//***
+ *
+ * @brief computes in the storage type if it is a floating point type,
+ *        integral data is computed in double
+ *        (=> float maps stay in float)
+ *
+ *****************************************************************************/
+struct storage
+{
+    template<class T>
+    using type = std::conditional_t<std::is_floating_point<T>::value,T,double>;
+};
+
+
+
+/*************************************************************************//***
+ *
+ * @brief always computes in type T
+ *
+ *****************************************************************************/
+template<class T>
+struct fixed
+{
+    static_assert(std::is_floating_point<T>::value,
+                  "expects floating point type");
+
+    template<class>
+    using type = T;
+};
+
+} //namespace precision
+
+
+
+
 namespace interpolator {
 
 
@@ -46,51 +229,209 @@ make_fp(T&& x) {
     return std::forward<T>(x);
 }
 
+
+///@brief conversion to the compute type selected by a precision policy
+template<class Precision, class T, class =
+    std::enable_if_t<std::is_arithmetic<T>::value>>
+inline auto
+to_compute(T x) {
+    return typename Precision::template type<T>(x);
+}
+
+///@brief forward, since we don't know enough about non-builtin types
+template<class Precision, class T, class =
+    std::enable_if_t<!std::is_arithmetic<std::decay_t<T>>::value>>
+inline auto
+to_compute(T&& x) {
+    return std::forward<T>(x);
+}
+
 } //namespace detail
 
 
+namespace detail {
+
+///@brief clamps a node index to [1,n-1] => always a valid segment
+template<class Index>
+inline Index
+clamp_segment_node(Index i, Index n) noexcept {
+    return std::min(std::max(i, Index(1)), n - 1);
+}
+
 
 /*************************************************************************//***
  *
- * @brief returns the value of a piece-wise constant function at position x
+ * @brief returns the index of the first node with key not smaller than x
+ *        clamped to [1,n-1] => always a valid segment (upper node index);
+ *        out-of-range keys are mapped to the boundary segments
  *
- * @tparam Iterator  RandomAccessIterator (at least ForwardIterator)
- *                   to pairs of keys and mapped values (= nodes)
+ *****************************************************************************/
+template<class Probe, class Iterator, class EndSentinel, class Value>
+inline auto
+upper_segment_node(const Iterator begin, const EndSentinel end,
+                   const Value& x, decltype(std::distance(begin,end)) n)
+{
+    using val_t = std::decay_t<decltype(*begin)>;
+    using std::distance;
+
+    Probe::search();
+    const auto p = search::partition_point_n(begin, std::size_t(n),
+        [&](const val_t& a) {
+            Probe::comparison();
+            return a.first < x;
+        });
+
+    return clamp_segment_node(distance(begin,p), n);
+}
+
+
+
+/*************************************************************************//***
  *
- * @param begin  lower bound of node range
- * @param end    exclusive upper bound of node range
- * @param x      key for which to return the interpolated value
+ * @brief batch evaluation driver: evaluates queries in groups of Lanes;
+ *        the node searches of a group run interleaved
+ *        (search::partition_points with pred(node,x)),
+ *        'index' maps a search result to a segment index,
+ *        'value' computes the result for one query from its segment index;
+ *        the second loop contains no data-dependent branches
  *
- * @pre keys in range [begin,end) have to be sorted in ascending order
+ *****************************************************************************/
+template<std::size_t Lanes, class Iterator, class InputIterator,
+         class OutputIterator, class Pred, class Index, class Value>
+inline OutputIterator
+evaluate_in_lanes(const Iterator begin, std::size_t n,
+                  InputIterator first, InputIterator last, OutputIterator out,
+                  Pred&& pred, Index&& index, Value&& value)
+{
+    using arg_t = std::decay_t<decltype(*first)>;
+
+    arg_t xs[Lanes];
+    Iterator ps[Lanes];
+
+    while(first != last) {
+        std::size_t m = 0;
+        for(; m < Lanes && first != last; ++m, ++first) xs[m] = *first;
+
+        search::partition_points<Lanes>(begin, n, xs, xs + m, ps, pred);
+
+        for(std::size_t j = 0; j < m; ++j, ++out) {
+            *out = value(xs[j], index(ps[j]));
+        }
+    }
+    return out;
+}
+
+} //namespace detail
+
+
+
+/*************************************************************************//***
+ *
+ * @brief returns the value of a piece-wise constant function at position x
+ *
+ * @tparam Extrapolation  policy for keys outside of the node key range;
+ *                        'linear' behaves like 'clamp'
  *
  *****************************************************************************/
-struct piecewise_constant
+template<class Extrapolation = extrapolation::clamp>
+struct basic_piecewise_constant :
+    private Extrapolation
 {
-    template<class Iterator, class EndSentinel, class Value>
+    using extrapolation_type = Extrapolation;
+
+    constexpr
+    basic_piecewise_constant(const Extrapolation& e = Extrapolation{}):
+        Extrapolation(e)
+    {}
+
+    const extrapolation_type&
+    extrapolation() const noexcept { return *this; }
+
+
+    /**
+     * @tparam Iterator  RandomAccessIterator (at least ForwardIterator)
+     *                   to pairs of keys and mapped values (= nodes)
+     *
+     * @param begin  lower bound of node range
+     * @param end    exclusive upper bound of node range
+     * @param x      key for which to return the interpolated value
+     * @param probe  instrumentation policy that receives search events
+     *
+     * @pre keys in range [begin,end) have to be sorted in ascending order
+     */
+    template<class Iterator, class EndSentinel, class Value,
+             class Probe = instrumentation::none>
     auto operator () (const Iterator begin, const EndSentinel end,
-                      const Value& x) const
+                      const Value& x, Probe = Probe{}) const
     {
         using std::distance;
         using std::prev;
         using std::next;
-        using std::lower_bound;
 
-        using val_t = std::decay_t<decltype(*begin)>;
-        using arg_t = std::decay_t<decltype(begin->first)>;
         using res_t = std::decay_t<decltype(begin->second)>;
 
         const auto n = distance(begin,end);
         if(n <  1) return res_t(0);
-        if(n == 1) return begin->second;
 
-        const auto p = lower_bound(begin,end,x,
-            [](const val_t& a, const arg_t& x) {return a.first <= x;} );
+        Probe::search();
+        const auto i = distance(begin, search::partition_point_n(begin,
+            std::size_t(n), [&](const auto& a) {
+                Probe::comparison();
+                return !(x < a.first);
+            }));
+
+        const auto& lo = *begin;
+        const auto& hi = *next(begin, n-1);
+        const auto& p  = *next(begin, std::max(i, decltype(i)(1)) - 1);
 
-        return (p != begin) ? prev(p)->second : p->second;
+        return extrapolation()(x < lo.first, hi.first < x, lo, hi,
+                               res_t(p.second));
     }
 
+
+    /**
+     * @brief batch evaluation: writes the values for all keys
+     *        in [first,last) to out
+     *
+     * @tparam Group  number of interleaved node searches
+     */
+    template<std::size_t Group = search::default_group_size,
+             class Iterator, class EndSentinel,
+             class InputIterator, class OutputIterator>
+    OutputIterator
+    evaluate(const Iterator begin, const EndSentinel end,
+             InputIterator first, InputIterator last, OutputIterator out) const
+    {
+        using std::distance;
+        using std::next;
+
+        using res_t = std::decay_t<decltype(begin->second)>;
+
+        const auto n = distance(begin,end);
+        if(n < 1) {
+            for(; first != last; ++first, ++out) *out = res_t(0);
+            return out;
+        }
+
+        const auto& lo = *begin;
+        const auto& hi = *next(begin, n-1);
+
+        return detail::evaluate_in_lanes<Group>(begin, std::size_t(n),
+            first, last, out,
+            [](const auto& a, const auto& x) { return !(x < a.first); },
+            [&](const Iterator& p) {
+                const auto i = distance(begin, p);
+                return std::max(i, decltype(i)(1)) - 1;
+            },
+            [&](const auto& x, auto i) {
+                return extrapolation()(x < lo.first, hi.first < x, lo, hi,
+                                       res_t(next(begin,i)->second));
+            });
+    }
 };
 
+using piecewise_constant = basic_piecewise_constant<>;
+
 
 
 
@@ -101,57 +442,131 @@ struct piecewise_constant
  * @brief returns the value of a piece-wise linearly interpolating function at
  *        position x
  *
- * @tparam Iterator  RandomAccessIterator (at least ForwardIterator)
- *                   to pairs of keys and mapped values (= nodes)
- *
- * @param begin  lower bound of node range
- * @param end    exclusive upper bound of node range
- * @param x      key for which to return the interpolated value
- *
- * @pre keys in range [begin,end) have to be sorted in ascending order
+ * @tparam Extrapolation  policy for keys outside of the node key range
+ * @tparam Precision      compute type policy (see namespace precision)
  *
  *****************************************************************************/
-struct piecewise_linear
+template<class Extrapolation = extrapolation::linear,
+         class Precision = precision::promote<>>
+struct basic_piecewise_linear :
+    private Extrapolation
 {
-    template<class Iterator, class EndSentinel, class Value>
+    using extrapolation_type = Extrapolation;
+    using precision_type = Precision;
+
+    constexpr
+    basic_piecewise_linear(const Extrapolation& e = Extrapolation{}):
+        Extrapolation(e)
+    {}
+
+    const extrapolation_type&
+    extrapolation() const noexcept { return *this; }
+
+
+    /**
+     * @tparam Iterator  RandomAccessIterator (at least ForwardIterator)
+     *                   to pairs of keys and mapped values (= nodes)
+     *
+     * @param begin  lower bound of node range
+     * @param end    exclusive upper bound of node range
+     * @param x      key for which to return the interpolated value
+     * @param probe  instrumentation policy that receives search events
+     *
+     * @pre keys in range [begin,end) have to be sorted in ascending order
+     */
+    template<class Iterator, class EndSentinel, class Value,
+             class Probe = instrumentation::none>
     auto operator () (const Iterator begin, const EndSentinel end,
-                      const Value& x) const
+                      const Value& x, Probe = Probe{}) const
     {
         using std::distance;
-        using std::prev;
         using std::next;
-        using std::lower_bound;
 
-        using val_t = std::decay_t<decltype(*begin)>;
-        using arg_t = std::decay_t<decltype(begin->first)>;
-        using res_t = std::decay_t<decltype(begin->second)>;
+        using res_t = result_t<Iterator,Value>;
 
         const auto n = distance(begin,end);
-        if(n <  1) return detail::make_fp(res_t{});
-        if(n == 1) return detail::make_fp(begin->second);
+        if(n <  1) return res_t(std::decay_t<decltype(begin->second)>{});
+        if(n == 1) {
+            return extrapolation()(x < begin->first, begin->first < x,
+                                   *begin, *begin, res_t(begin->second));
+        }
 
-        auto p1 = lower_bound(begin,end,x,
-            [](const val_t& a, const arg_t& x) {return a.first < x;} );
+        const auto i = detail::upper_segment_node<Probe>(begin, end, x, n);
 
-        //x smaller than left bound
-        if(p1 == begin) {
-            p1 = next(p1);
-        }
-        //x larger than right bound
-        else if(p1 == end) {
-            p1 = prev(p1);
+        return segment(begin, n, x, i);
+    }
+
+
+    /**
+     * @brief batch evaluation: writes the values for all keys
+     *        in [first,last) to out
+     *
+     * @tparam Group  number of interleaved node searches
+     */
+    template<std::size_t Group = search::default_group_size,
+             class Iterator, class EndSentinel,
+             class InputIterator, class OutputIterator>
+    OutputIterator
+    evaluate(const Iterator begin, const EndSentinel end,
+             InputIterator first, InputIterator last, OutputIterator out) const
+    {
+        using std::distance;
+
+        const auto n = distance(begin,end);
+        if(n < 2) {
+            for(; first != last; ++first, ++out) *out = (*this)(begin,end,*first);
+            return out;
         }
 
-        const auto p0 = prev(p1);
+        return detail::evaluate_in_lanes<Group>(begin, std::size_t(n),
+            first, last, out,
+            [](const auto& a, const auto& x) { return a.first < x; },
+            [&](const Iterator& p) {
+                return detail::clamp_segment_node(distance(begin, p), n); },
+            [&](const auto& x, auto i) {
+                return segment(begin, n, x, i); });
+    }
+
+
+private:
+    //---------------------------------------------------------------
+    /// value on segment [i-1,i] with extrapolation policy applied
+    template<class Iterator, class Size, class Value, class Index>
+    auto segment(const Iterator begin, Size n, const Value& x, Index i) const
+    {
+        using std::next;
+
+        const auto& p0 = *next(begin, i-1);
+        const auto& p1 = *next(begin, i);
+
+        const auto slope = cp(p1.second - p0.second) / cp(p1.first - p0.first);
+
+        const auto v = cp(p0.second) + slope * cp(x - p0.first);
 
-        const auto slope = (p1->second - p0->second) /
-                           detail::make_fp(p1->first - p0->first);
+        const auto& lo = *begin;
+        const auto& hi = *next(begin, n-1);
 
-        return (p0->second + slope * (x - p0->first) );
+        return extrapolation()(x < lo.first, hi.first < x, lo, hi,
+                               result_t<Iterator,Value>(v));
     }
 
+    //---------------------------------------------------------------
+    template<class T>
+    static auto cp(T&& x) {
+        return detail::to_compute<Precision>(std::forward<T>(x));
+    }
+
+    //-----------------------------------------------------
+    template<class Iterator, class Value>
+    using result_t = decltype(
+        cp(std::declval<Iterator>()->second) +
+        cp(std::declval<Iterator>()->second - std::declval<Iterator>()->second) /
+        cp(std::declval<Iterator>()->first - std::declval<Iterator>()->first) *
+        cp(std::declval<const Value&>() - std::declval<Iterator>()->first));
 };
 
+using piecewise_linear = basic_piecewise_linear<>;
+
 
 
 
@@ -162,57 +577,305 @@ struct piecewise_linear
  * @brief returns the value of a piece-wise linearly interpolating function at
  *        position log(x)
  *
- * @tparam Iterator  RandomAccessIterator (at least ForwardIterator)
- *                   to pairs of keys and mapped values (= nodes)
- *
- * @param begin  lower bound of node range
- * @param end    exclusive upper bound of node range
- * @param x      key for which to return the interpolated value
- *
- * @pre keys in range [begin,end) have to be sorted in ascending order
+ * @tparam Extrapolation  policy for keys outside of the node key range;
+ *                        keys x <= 0 are always treated like keys left of
+ *                        the node range that can't be extended linearly
+ *                        (=> 'linear' yields the first node value there)
+ * @tparam Precision      compute type policy (see namespace precision)
  *
  *****************************************************************************/
-struct piecewise_log_linear
+template<class Extrapolation = extrapolation::linear,
+         class Precision = precision::promote<>>
+struct basic_piecewise_log_linear :
+    private Extrapolation
 {
-    template<class Iterator, class EndSentinel, class Value>
+    using extrapolation_type = Extrapolation;
+    using precision_type = Precision;
+
+    constexpr
+    basic_piecewise_log_linear(const Extrapolation& e = Extrapolation{}):
+        Extrapolation(e)
+    {}
+
+    const extrapolation_type&
+    extrapolation() const noexcept { return *this; }
+
+
+    /**
+     * @tparam Iterator  RandomAccessIterator (at least ForwardIterator)
+     *                   to pairs of keys and mapped values (= nodes)
+     *
+     * @param begin  lower bound of node range
+     * @param end    exclusive upper bound of node range
+     * @param x      key for which to return the interpolated value
+     * @param probe  instrumentation policy that receives search events
+     *
+     * @pre keys in range [begin,end) have to be sorted in ascending order
+     */
+    template<class Iterator, class EndSentinel, class Value,
+             class Probe = instrumentation::none>
     auto operator () (const Iterator begin, const EndSentinel end,
-                      const Value& x) const
+                      const Value& x, Probe = Probe{}) const
     {
         using std::distance;
-        using std::prev;
-        using std::next;
-        using std::lower_bound;
 
-        using val_t = std::decay_t<decltype(*begin)>;
-        using arg_t = std::decay_t<decltype(begin->first)>;
-        using res_t = std::decay_t<decltype(begin->second)>;
+        using res_t = result_t<Iterator,Value>;
 
         const auto n = distance(begin,end);
-        if(n <  1) return detail::make_fp(res_t{});
-        if(n == 1 || x <= 0) return detail::make_fp(begin->second);
+        if(n <  1) return res_t(std::decay_t<decltype(begin->second)>{});
+        if(n == 1) {
+            return extrapolation()(x < begin->first, begin->first < x,
+                                   *begin, *begin, res_t(begin->second));
+        }
 
-        auto p1 = lower_bound(begin,end,x,
-            [](const val_t& a, const arg_t& x) {return a.first < x;} );
+        const auto i = detail::upper_segment_node<Probe>(begin, end, x, n);
 
-        //x smaller than left bound
-        if(p1 == begin) {
-            p1 = next(p1);
-        }
-        //x larger than right bound
-        else if(p1 == end) {
-            p1 = prev(p1);
+        return segment(begin, n, x, i);
+    }
+
+
+    /**
+     * @brief batch evaluation: writes the values for all keys
+     *        in [first,last) to out
+     *
+     * @tparam Group  number of interleaved node searches
+     */
+    template<std::size_t Group = search::default_group_size,
+             class Iterator, class EndSentinel,
+             class InputIterator, class OutputIterator>
+    OutputIterator
+    evaluate(const Iterator begin, const EndSentinel end,
+             InputIterator first, InputIterator last, OutputIterator out) const
+    {
+        using std::distance;
+
+        const auto n = distance(begin,end);
+        if(n < 2) {
+            for(; first != last; ++first, ++out) *out = (*this)(begin,end,*first);
+            return out;
         }
 
-        const auto p0 = prev(p1);
+        return detail::evaluate_in_lanes<Group>(begin, std::size_t(n),
+            first, last, out,
+            [](const auto& a, const auto& x) { return a.first < x; },
+            [&](const Iterator& p) {
+                return detail::clamp_segment_node(distance(begin, p), n); },
+            [&](const auto& x, auto i) {
+                return segment(begin, n, x, i); });
+    }
+
+
+private:
+    //---------------------------------------------------------------
+    /// value on segment [i-1,i] with extrapolation policy applied
+    template<class Iterator, class Size, class Value, class Index>
+    auto segment(const Iterator begin, Size n, const Value& x, Index i) const
+    {
+        using std::next;
+        using std::log;
+
+        using res_t = result_t<Iterator,Value>;
+
+        const auto& p0 = *next(begin, i-1);
+        const auto& p1 = *next(begin, i);
+
+        const auto slope = cp(p1.second - p0.second) /
+                           log(cp(p1.first) / cp(p0.first));
 
-        const auto slope = (p1->second - p0->second) /
-                           (log(p1->first / detail::make_fp(p0->first)) );
+        const bool positive = x > 0;
+        const auto& lo = *begin;
+        const auto& hi = *next(begin, n-1);
 
-        return (p0->second + slope * (log(x / detail::make_fp(p0->first))) );
+        const auto v = positive
+            ? res_t(cp(p0.second) + slope * log(cp(x) / cp(p0.first)))
+            : res_t(lo.second);
+
+        return extrapolation()(!positive || x < lo.first, hi.first < x,
+                               lo, hi, v);
+    }
+
+    //---------------------------------------------------------------
+    template<class T>
+    static auto cp(T&& x) {
+        return detail::to_compute<Precision>(std::forward<T>(x));
     }
 
+    //-----------------------------------------------------
+    template<class Iterator, class Value>
+    using result_t = decltype(
+        cp(std::declval<Iterator>()->second) +
+        cp(std::declval<Iterator>()->second - std::declval<Iterator>()->second) /
+        std::log(cp(std::declval<Iterator>()->first)) *
+        std::log(cp(std::declval<const Value&>())));
 };
 
+using piecewise_log_linear = basic_piecewise_log_linear<>;
+
+
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief true, if an interpolator is linear within each segment
+ *        in some key coordinate (see segment_coordinate)
+ *
+ *****************************************************************************/
+template<class Interpolator>
+struct is_segment_linear : std::false_type {};
+
+template<class E, class P>
+struct is_segment_linear<basic_piecewise_linear<E,P>> : std::true_type {};
+
+template<class E, class P>
+struct is_segment_linear<basic_piecewise_log_linear<E,P>> : std::true_type {};
+
+
+
+//-------------------------------------------------------------------
+///@brief key coordinate in which interpolation is linear within a segment
+template<class E, class P, class Key>
+inline auto
+segment_coordinate(const basic_piecewise_linear<E,P>&, const Key& x)
+{
+    return detail::make_fp(x);
+}
+
+template<class E, class P, class Key>
+inline auto
+segment_coordinate(const basic_piecewise_log_linear<E,P>&, const Key& x)
+{
+    using std::log;
+    return log(detail::make_fp(x));
+}
+
+
+
+//-------------------------------------------------------------------
+///@brief key at relative position t within segment [x0,x1]
+template<class E, class P, class Key>
+inline Key
+segment_key(const basic_piecewise_linear<E,P>&,
+            const Key& x0, const Key& x1, double t)
+{
+    return Key(x0 + t * (x1 - x0));
+}
+
+template<class E, class P, class Key>
+inline Key
+segment_key(const basic_piecewise_log_linear<E,P>&,
+            const Key& x0, const Key& x1, double t)
+{
+    using std::pow;
+    return Key(x0 * pow(x1 / detail::make_fp(x0), t));
+}
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief true, if an interpolator is piecewise constant
+ *
+ *****************************************************************************/
+template<class Interpolator>
+struct is_piecewise_constant : std::false_type {};
+
+template<class E>
+struct is_piecewise_constant<basic_piecewise_constant<E>> : std::true_type {};
+
+
+
+
+namespace detail {
+template<class...> using void_t = void;
+}
+
+/*************************************************************************//***
+ *
+ * @brief node data derived by an interpolator
+ *
+ * @details An interpolator can precompute data from the nodes by providing
+ *            template<class Key, class Value> using cache_type = ...;
+ *            void prepare(Iterator begin, Iterator end, cache_type&) const;
+ *            auto interpolate(const cache_type&, const Key& x, Probe) const;
+ *          interpolating_map then keeps such a cache up to date and
+ *          evaluates with it. The interpolator must still be usable
+ *          without the cache (operator()), since interpolating_map falls
+ *          back to it while a cache is rebuilt in the background
+ *          (see rebuild_mode).
+ *          Optionally
+ *            void refresh_values(Iterator begin, Iterator end, cache_type&,
+ *                                std::size_t first, std::size_t last) const;
+ *          updates only the data that depends on the mapped values of
+ *          nodes [first,last) (see interpolating_map::assign_values) and
+ *            void splice_nodes(Iterator begin, Iterator end, cache_type&,
+ *                              std::size_t pos, std::size_t erased,
+ *                              std::size_t inserted) const;
+ *          only the data around single inserted or erased nodes.
+ *
+ *****************************************************************************/
+struct no_node_cache {};
+
+
+template<class Interpolator, class Key, class Value, class = void>
+struct node_cache : std::false_type
+{
+    using type = no_node_cache;
+};
+
+template<class Interpolator, class Key, class Value>
+struct node_cache<Interpolator,Key,Value,
+    detail::void_t<typename Interpolator::template cache_type<Key,Value>>>
+:
+    std::true_type
+{
+    using type = typename Interpolator::template cache_type<Key,Value>;
+};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief true, if an interpolator provides a batch evaluation member
+ *        evaluate(begin, end, first, last, out)
+ *
+ *****************************************************************************/
+template<class Interpolator, class Iterator,
+         class InputIterator, class OutputIterator, class = void>
+struct has_batch_evaluation : std::false_type {};
+
+template<class Interpolator, class Iterator,
+         class InputIterator, class OutputIterator>
+struct has_batch_evaluation<Interpolator,Iterator,InputIterator,OutputIterator,
+    detail::void_t<decltype(std::declval<const Interpolator&>().evaluate(
+        std::declval<Iterator>(), std::declval<Iterator>(),
+        std::declval<InputIterator>(), std::declval<InputIterator>(),
+        std::declval<OutputIterator>()))>>
+:
+    std::true_type
+{};
+
+
+//-------------------------------------------------------------------
+/// true, if the batch evaluation takes the search group size as
+/// first template argument: evaluate<Group>(begin, end, first, last, out)
+template<class Interpolator, class Iterator,
+         class InputIterator, class OutputIterator, class = void>
+struct has_grouped_batch_evaluation : std::false_type {};
+
+template<class Interpolator, class Iterator,
+         class InputIterator, class OutputIterator>
+struct has_grouped_batch_evaluation<Interpolator,Iterator,InputIterator,OutputIterator,
+    detail::void_t<decltype(std::declval<const Interpolator&>().template evaluate<1>(
+        std::declval<Iterator>(), std::declval<Iterator>(),
+        std::declval<InputIterator>(), std::declval<InputIterator>(),
+        std::declval<OutputIterator>()))>>
+:
+    std::true_type
+{};
 
 
 } //namespace interpolator
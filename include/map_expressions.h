@@ -0,0 +1,645 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_MAP_EXPRESSIONS_H_
+#define AMLIB_MAP_EXPRESSIONS_H_
+
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+#include "interpolating_map.h"
+#include "gradients.h"
+#include "sampling.h"
+
+
+namespace am {
+
+
+/*****************************************************************************
+ *
+ * MAP EXPRESSIONS
+ *
+ * Lazily evaluated arithmetic expressions of interpolating maps, other
+ * callables and scalars:
+ *
+ *   const auto e = 0.5 * f + 2.0 * g - lazy(h);
+ *   e(x);                         //one query
+ *   e.evaluate(first, last, out); //one fused pass over a batch of keys
+ *
+ * Operands are referenced, not copied: maps and callables must outlive
+ * the expression.
+ *
+ * Every expression node provides
+ *   operator()(x)                  value at x
+ *   state_type make_state()        per-pass evaluation state
+ *   eval(x, state, window)         value at x within a pass
+ *   for_each_map(f)                calls f(map) for all map operands
+ *   map_count                      number of map operands
+ *   shared_key_axis()              true, if all map operands (at least 2)
+ *                                  have identical node keys
+ *
+ *****************************************************************************/
+
+/*************************************************************************//***
+ *
+ * @brief CRTP base of all expression nodes
+ *
+ *****************************************************************************/
+template<class Derived>
+class map_expression
+{
+public:
+    /**
+     * @brief batch evaluation: writes the values for all keys
+     *        in [first,last) to out in a single pass
+     *
+     * @details Each map operand keeps a segment cursor (=> ascending keys
+     *          need no search). If all map operands have identical node keys
+     *          the segment is searched only once per key and shared by all
+     *          map operands. Whether the keys are identical is decided by the
+     *          first evaluation and only re-checked if one of the maps has
+     *          been modified since (see interpolating_map::version).
+     */
+    template<class InputIterator, class OutputIterator>
+    OutputIterator
+    evaluate(InputIterator first, InputIterator last, OutputIterator out) const;
+
+protected:
+    const Derived& derived() const noexcept {
+        return static_cast<const Derived&>(*this);
+    }
+};
+
+
+
+//-------------------------------------------------------------------
+template<class T>
+struct is_map_expression :
+    std::is_base_of<map_expression<std::decay_t<T>>, std::decay_t<T>>
+{};
+
+
+
+namespace detail {
+
+//-------------------------------------------------------------------
+///@brief node index window shared by all map operands
+struct shared_window {
+    std::size_t first;
+    std::size_t second;
+};
+
+//-------------------------------------------------------------------
+///@brief true, if maps a and b have the same node keys
+template<class MapA, class MapB>
+bool same_node_keys(const MapA& a, const MapB& b)
+{
+    if(static_cast<const void*>(&a) == &b) return true;
+    if(a.size() != b.size()) return false;
+    //equal versions => copies of the same node set
+    if(a.version() == b.version()) return true;
+
+    return std::equal(a.begin(), a.end(), b.begin(),
+        [](const auto& x, const auto& y) {
+            return !(x.first < y.first) && !(y.first < x.first);
+        });
+}
+
+//-------------------------------------------------------------------
+///@brief true, if all (at least 2) map operands have the same node keys
+template<class Expr>
+bool shares_key_axis(const Expr& e)
+{
+    if(Expr::map_count < 2) return false;
+
+    //first map operand = axis
+    bool first = true;
+    bool shared = false;
+    e.for_each_map([&](const auto& axis) {
+        if(!first) return;
+        first = false;
+        shared = axis.size() > 1;
+
+        e.for_each_map([&](const auto& m) {
+            shared = shared && same_node_keys(m, axis);
+        });
+    });
+    return shared;
+}
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief result of shares_key_axis for the map versions it was
+ *        determined for; copies start with the source's result
+ */
+template<std::size_t MapCount>
+class key_axis_cache
+{
+public:
+    key_axis_cache() = default;
+
+    key_axis_cache(const key_axis_cache& src) {
+        std::lock_guard<std::mutex> lock{src.mutex_};
+        valid_ = src.valid_;
+        shared_ = src.shared_;
+        versions_ = src.versions_;
+    }
+
+    key_axis_cache&
+    operator = (const key_axis_cache& src) {
+        if(this == &src) return *this;
+        const key_axis_cache tmp{src};
+        std::lock_guard<std::mutex> lock{mutex_};
+        valid_ = tmp.valid_;
+        shared_ = tmp.shared_;
+        versions_ = tmp.versions_;
+        return *this;
+    }
+
+    //---------------------------------------------------------------
+    /// O(number of maps) unless a map was modified since the last call
+    template<class Expr>
+    bool
+    get(const Expr& e) const {
+        std::array<std::uint64_t,MapCount> versions;
+        std::size_t i = 0;
+        e.for_each_map([&](const auto& m) { versions[i++] = m.version(); });
+
+        std::lock_guard<std::mutex> lock{mutex_};
+        if(!valid_ || versions != versions_) {
+            shared_ = shares_key_axis(e);
+            versions_ = versions;
+            valid_ = true;
+        }
+        return shared_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    mutable bool valid_ = false;
+    mutable bool shared_ = false;
+    /// map versions for which shared_ was determined
+    mutable std::array<std::uint64_t,MapCount> versions_ {};
+};
+
+} //namespace detail
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief map operand
+ *
+ *****************************************************************************/
+template<class Map>
+class map_term :
+    public map_expression<map_term<Map>>
+{
+public:
+    using map_type = Map;
+    using key_type = typename Map::key_type;
+    using mapped_type = typename Map::mapped_type;
+    using state_type = segment_cursor<typename Map::interpolator_type,
+                                      typename Map::const_iterator>;
+
+    static constexpr std::size_t map_count = 1;
+
+    explicit
+    map_term(const Map& m) noexcept: map_(&m) {}
+
+    //---------------------------------------------------------------
+    mapped_type
+    operator () (const key_type& x) const {
+        return (*map_)(x);
+    }
+
+    //---------------------------------------------------------------
+    state_type
+    make_state() const {
+        return state_type{map_->interpolator(), map_->begin(), map_->end()};
+    }
+
+    //-----------------------------------------------------
+    mapped_type
+    eval(const key_type& x, state_type& s,
+         const detail::shared_window* w) const
+    {
+        if(!w) return mapped_type(s(x));
+
+        const auto b = map_->begin();
+        return mapped_type(map_->interpolator()(b + w->first, b + w->second, x));
+    }
+
+    //---------------------------------------------------------------
+    template<class F>
+    void for_each_map(F&& f) const { f(*map_); }
+
+    bool shared_key_axis() const noexcept { return false; }
+
+private:
+    const Map* map_;
+};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief operand that is only available as callable f(x)
+ *        (e.g. polymorphic gradients, compressed_map)
+ *
+ *****************************************************************************/
+template<class F>
+class callable_term :
+    public map_expression<callable_term<F>>
+{
+public:
+    struct state_type {};
+
+    static constexpr std::size_t map_count = 0;
+
+    explicit
+    callable_term(const F& f) noexcept: f_(&f) {}
+
+    //---------------------------------------------------------------
+    template<class Key>
+    auto operator () (const Key& x) const {
+        return (*f_)(x);
+    }
+
+    //---------------------------------------------------------------
+    state_type make_state() const noexcept { return {}; }
+
+    template<class Key>
+    auto eval(const Key& x, state_type&, const detail::shared_window*) const {
+        return (*f_)(x);
+    }
+
+    //---------------------------------------------------------------
+    template<class G>
+    void for_each_map(G&&) const {}
+
+    bool shared_key_axis() const noexcept { return false; }
+
+private:
+    const F* f_;
+};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief scalar operand
+ *
+ *****************************************************************************/
+template<class T>
+class scalar_term :
+    public map_expression<scalar_term<T>>
+{
+public:
+    struct state_type {};
+
+    static constexpr std::size_t map_count = 0;
+
+    explicit constexpr
+    scalar_term(const T& value): value_(value) {}
+
+    //---------------------------------------------------------------
+    template<class Key>
+    const T& operator () (const Key&) const noexcept {
+        return value_;
+    }
+
+    //---------------------------------------------------------------
+    state_type make_state() const noexcept { return {}; }
+
+    template<class Key>
+    const T& eval(const Key&, state_type&,
+                  const detail::shared_window*) const noexcept
+    {
+        return value_;
+    }
+
+    //---------------------------------------------------------------
+    template<class G>
+    void for_each_map(G&&) const {}
+
+    bool shared_key_axis() const noexcept { return false; }
+
+private:
+    T value_;
+};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief unary operation node
+ *
+ *****************************************************************************/
+template<class Op, class E>
+class unary_expression :
+    public map_expression<unary_expression<Op,E>>
+{
+public:
+    using state_type = typename E::state_type;
+
+    static constexpr std::size_t map_count = E::map_count;
+
+    explicit
+    unary_expression(const E& e): e_(e) {}
+
+    //---------------------------------------------------------------
+    template<class Key>
+    auto operator () (const Key& x) const {
+        return Op{}(e_(x));
+    }
+
+    //---------------------------------------------------------------
+    state_type make_state() const { return e_.make_state(); }
+
+    template<class Key>
+    auto eval(const Key& x, state_type& s,
+              const detail::shared_window* w) const
+    {
+        return Op{}(e_.eval(x, s, w));
+    }
+
+    //---------------------------------------------------------------
+    template<class F>
+    void for_each_map(F&& f) const { e_.for_each_map(f); }
+
+    bool shared_key_axis() const { return e_.shared_key_axis(); }
+
+private:
+    E e_;
+};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief binary operation node
+ *
+ *****************************************************************************/
+template<class Op, class L, class R>
+class binary_expression :
+    public map_expression<binary_expression<Op,L,R>>
+{
+public:
+    using state_type = std::pair<typename L::state_type,
+                                 typename R::state_type>;
+
+    static constexpr std::size_t map_count = L::map_count + R::map_count;
+
+    binary_expression(const L& l, const R& r):
+        l_(l), r_(r), shared_{}
+    {}
+
+    //---------------------------------------------------------------
+    template<class Key>
+    auto operator () (const Key& x) const {
+        return Op{}(l_(x), r_(x));
+    }
+
+    //---------------------------------------------------------------
+    state_type make_state() const {
+        return state_type{l_.make_state(), r_.make_state()};
+    }
+
+    template<class Key>
+    auto eval(const Key& x, state_type& s,
+              const detail::shared_window* w) const
+    {
+        return Op{}(l_.eval(x, s.first, w), r_.eval(x, s.second, w));
+    }
+
+    //---------------------------------------------------------------
+    template<class F>
+    void for_each_map(F&& f) const {
+        l_.for_each_map(f);
+        r_.for_each_map(f);
+    }
+
+    //-----------------------------------------------------
+    /// O(number of maps) unless a map was modified since the last call
+    bool shared_key_axis() const {
+        return map_count < 2 ? false : shared_.get(*this);
+    }
+
+private:
+    L l_;
+    R r_;
+    detail::key_axis_cache<map_count> shared_;
+};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief turns maps and callables into expression operands
+ *
+ *****************************************************************************/
+template<class K, class T, class I, class C, class A, class P>
+inline map_term<interpolating_map<K,T,I,C,A,P>>
+lazy(const interpolating_map<K,T,I,C,A,P>& m) noexcept
+{
+    return map_term<interpolating_map<K,T,I,C,A,P>>{m};
+}
+
+//-------------------------------------------------------------------
+template<class Arg, class Res, class I, class S>
+inline auto
+lazy(const interpolating_gradient<Arg,Res,I,S>& g) noexcept
+{
+    return lazy(g.map());
+}
+
+//-------------------------------------------------------------------
+template<class F, class = std::enable_if_t<!is_map_expression<F>::value>>
+inline callable_term<F>
+lazy(const F& f) noexcept
+{
+    return callable_term<F>{f};
+}
+
+//-------------------------------------------------------------------
+template<class E, class = std::enable_if_t<is_map_expression<E>::value>,
+         class = void>
+inline const E&
+lazy(const E& e) noexcept
+{
+    return e;
+}
+
+//-------------------------------------------------------------------
+///@brief operands would be destroyed before the expression is evaluated
+template<class F, class = std::enable_if_t<!is_map_expression<F>::value>>
+void lazy(const F&&) = delete;
+
+
+
+
+namespace detail {
+
+//-------------------------------------------------------------------
+template<class T>
+struct is_expression_operand : is_map_expression<T> {};
+
+template<class K, class T, class I, class C, class A, class P>
+struct is_expression_operand<interpolating_map<K,T,I,C,A,P>> : std::true_type {};
+
+
+//-------------------------------------------------------------------
+template<class T, bool = is_expression_operand<T>::value>
+struct expression_operand
+{
+    using type = std::decay_t<decltype(lazy(std::declval<const T&>()))>;
+    static type make(const T& x) { return lazy(x); }
+};
+
+template<class T>
+struct expression_operand<T,false>
+{
+    using type = scalar_term<T>;
+    static type make(const T& x) { return type{x}; }
+};
+
+
+//-------------------------------------------------------------------
+template<class Op, class L, class R>
+using enable_binary_expression_t = std::enable_if_t<
+    is_expression_operand<std::decay_t<L>>::value ||
+    is_expression_operand<std::decay_t<R>>::value,
+    binary_expression<Op,
+        typename expression_operand<std::decay_t<L>>::type,
+        typename expression_operand<std::decay_t<R>>::type>>;
+
+
+//-------------------------------------------------------------------
+template<class Op, class L, class R>
+inline enable_binary_expression_t<Op,L,R>
+make_binary_expression(const L& l, const R& r)
+{
+    return enable_binary_expression_t<Op,L,R>{
+        expression_operand<L>::make(l), expression_operand<R>::make(r)};
+}
+
+
+} //namespace detail
+
+
+
+
+//-------------------------------------------------------------------
+template<class Derived>
+template<class InputIterator, class OutputIterator>
+OutputIterator
+map_expression<Derived>::evaluate(
+    InputIterator first, InputIterator last, OutputIterator out) const
+{
+    const auto& e = derived();
+    auto state = e.make_state();
+
+    //first map operand = axis of the shared segment search
+    bool hasMap = !e.shared_key_axis();
+    e.for_each_map([&](const auto& axis) {
+        if(hasMap) return;
+        hasMap = true;
+
+        auto cursor = segment_cursor<
+            typename std::decay_t<decltype(axis)>::interpolator_type,
+            typename std::decay_t<decltype(axis)>::const_iterator>{
+                axis.interpolator(), axis.begin(), axis.end()};
+
+        for(; first != last; ++first, ++out) {
+            const auto w = cursor.window(*first);
+            const detail::shared_window sw {w.first, w.second};
+            *out = e.eval(*first, state, &sw);
+        }
+    });
+
+    for(; first != last; ++first, ++out) {
+        *out = e.eval(*first, state, nullptr);
+    }
+    return out;
+}
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief arithmetic operators; enabled if at least one operand is an
+ *        expression or an interpolating_map
+ *
+ *****************************************************************************/
+template<class L, class R>
+inline detail::enable_binary_expression_t<std::plus<>,L,R>
+operator + (const L& l, const R& r)
+{
+    return detail::make_binary_expression<std::plus<>>(l, r);
+}
+
+//-------------------------------------------------------------------
+template<class L, class R>
+inline detail::enable_binary_expression_t<std::minus<>,L,R>
+operator - (const L& l, const R& r)
+{
+    return detail::make_binary_expression<std::minus<>>(l, r);
+}
+
+//-------------------------------------------------------------------
+template<class L, class R>
+inline detail::enable_binary_expression_t<std::multiplies<>,L,R>
+operator * (const L& l, const R& r)
+{
+    return detail::make_binary_expression<std::multiplies<>>(l, r);
+}
+
+//-------------------------------------------------------------------
+template<class L, class R>
+inline detail::enable_binary_expression_t<std::divides<>,L,R>
+operator / (const L& l, const R& r)
+{
+    return detail::make_binary_expression<std::divides<>>(l, r);
+}
+
+//-------------------------------------------------------------------
+template<class E, class = std::enable_if_t<
+    detail::is_expression_operand<std::decay_t<E>>::value>>
+inline unary_expression<std::negate<>,
+                        typename detail::expression_operand<E>::type>
+operator - (const E& e)
+{
+    return unary_expression<std::negate<>,
+        typename detail::expression_operand<E>::type>{
+            detail::expression_operand<E>::make(e)};
+}
+
+
+} //namespace am
+
+
+#endif
@@ -0,0 +1,328 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_MAP_OPERATIONS_H_
+#define AMLIB_MAP_OPERATIONS_H_
+
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "interpolating_map.h"
+
+
+namespace am {
+
+
+namespace detail {
+
+//-------------------------------------------------------------------
+///@brief allocator of maps with Key->Value nodes derived from Alloc
+template<class Alloc, class Key, class Value>
+using rebind_node_alloc_t = typename std::allocator_traits<Alloc>::template
+    rebind_alloc<std::pair<const Key,Value>>;
+
+
+//-------------------------------------------------------------------
+///@brief cursor for evaluations at ascending keys in amortized O(1)
+template<class Map>
+inline segment_cursor<typename Map::interpolator_type,
+                      typename Map::const_iterator>
+make_ascending_evaluator(const Map& m)
+{
+    return {m.interpolator(), m.begin(), m.end()};
+}
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief merges the nodes of two maps in one O(n+m) pass;
+ *        calls emit(key, f_value, g_value) for each key of the union of
+ *        both node key sets in ascending order
+ *
+ * @details node values are passed through unchanged at a map's own nodes,
+ *          so discontinuities (duplicate keys) are preserved
+ *
+ *****************************************************************************/
+template<class MapF, class MapG, class Emit>
+void merge_nodes(const MapF& f, const MapG& g, Emit&& emit)
+{
+    auto fi = f.begin();
+    auto gi = g.begin();
+    const auto fe = f.end();
+    const auto ge = g.end();
+
+    auto fx = make_ascending_evaluator(f);
+    auto gx = make_ascending_evaluator(g);
+
+    while(fi != fe || gi != ge) {
+        if(gi == ge || (fi != fe && fi->first < gi->first)) {
+            emit(fi->first, fi->second, gx(fi->first));
+            ++fi;
+        }
+        else if(fi == fe || gi->first < fi->first) {
+            emit(gi->first, fx(gi->first), gi->second);
+            ++gi;
+        }
+        else {
+            emit(fi->first, fi->second, gi->second);
+            ++fi;
+            ++gi;
+        }
+    }
+}
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief point-wise selection (min/max) with exact crossing points
+ *
+ *****************************************************************************/
+template<class Map, class Select>
+Map select_pointwise(const Map& f, const Map& g, Select select)
+{
+    using key_t = typename Map::key_type;
+    using val_t = typename Map::mapped_type;
+    using ipl_t = typename Map::interpolator_type;
+
+    typename Map::container_type nodes(f.get_allocator());
+    nodes.reserve(f.size() + g.size());
+
+    bool first = true;
+    key_t px {};
+    val_t pf {};
+    val_t pd {};
+
+    merge_nodes(f, g, [&](const key_t& x, const val_t& fv, const val_t& gv) {
+        const val_t d = fv - gv;
+
+        //insert crossing point if sign of f-g changes within segment
+        if(interpolator::is_segment_linear<ipl_t>::value &&
+           !first && px < x && ((pd < 0 && d > 0) || (pd > 0 && d < 0)))
+        {
+            const double t = double(pd) / double(pd - d);
+            nodes.emplace_back(
+                interpolator::segment_key(f.interpolator(), px, x, t),
+                val_t(pf + t * (fv - pf)));
+        }
+        nodes.emplace_back(x, select(fv, gv));
+
+        first = false;
+        px = x;
+        pf = fv;
+        pd = d;
+    });
+
+    return Map{sorted_range, std::move(nodes), f.interpolator(), f.key_comp()};
+}
+
+} //namespace detail
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief point-wise combination h(x) = op(f(x), g(x)) of two maps
+ *        with the union of both node key sets in O(n+m)
+ *
+ * @details The result is exact if op is linear (e.g. a*f + b*g) and both
+ *          maps use the same segment-linear interpolator or if both are
+ *          piecewise constant. Otherwise the result is only exact at
+ *          the nodes.
+ *
+ *****************************************************************************/
+template<class K, class T, class I, class C, class A, class P, class Map,
+         class BinaryOp>
+interpolating_map<K,T,I,C,A,P>
+combine(const interpolating_map<K,T,I,C,A,P>& f, const Map& g, BinaryOp op)
+{
+    using map_t = interpolating_map<K,T,I,C,A,P>;
+
+    typename map_t::container_type nodes(f.get_allocator());
+    nodes.reserve(f.size() + g.size());
+
+    detail::merge_nodes(f, g, [&](const K& x, const auto& fv, const auto& gv) {
+        nodes.emplace_back(x, T(op(fv, gv)));
+    });
+
+    return map_t{sorted_range, std::move(nodes), f.interpolator(), f.key_comp()};
+}
+
+
+
+//-------------------------------------------------------------------
+///@brief h(x) = a*f(x) + b*g(x)
+template<class Scalar, class Map1, class Map2>
+inline Map1
+linear_combination(const Scalar& a, const Map1& f, const Scalar& b, const Map2& g)
+{
+    return combine(f, g, [&](const auto& fv, const auto& gv) {
+        return a * fv + b * gv; });
+}
+
+//---------------------------------------------------------
+///@brief h(x) = f(x) + g(x)
+template<class Map1, class Map2>
+inline Map1
+sum(const Map1& f, const Map2& g)
+{
+    return combine(f, g, [](const auto& fv, const auto& gv) {
+        return fv + gv; });
+}
+
+//---------------------------------------------------------
+///@brief h(x) = f(x) - g(x)
+template<class Map1, class Map2>
+inline Map1
+difference(const Map1& f, const Map2& g)
+{
+    return combine(f, g, [](const auto& fv, const auto& gv) {
+        return fv - gv; });
+}
+
+//---------------------------------------------------------
+/**
+ * @brief h(x) = f(x) * g(x)
+ *        (exact at the nodes; product of 2 linear segments is quadratic)
+ */
+template<class Map1, class Map2>
+inline Map1
+product(const Map1& f, const Map2& g)
+{
+    return combine(f, g, [](const auto& fv, const auto& gv) {
+        return fv * gv; });
+}
+
+
+
+//-------------------------------------------------------------------
+/**
+ * @brief h(x) = min(f(x), g(x)) in O(n+m)
+ *        exact within the union of both node key ranges, since crossing
+ *        points of f and g are inserted as additional nodes
+ */
+template<class K, class T, class I, class C, class A, class P>
+inline interpolating_map<K,T,I,C,A,P>
+pointwise_min(const interpolating_map<K,T,I,C,A,P>& f,
+              const interpolating_map<K,T,I,C,A,P>& g)
+{
+    return detail::select_pointwise(f, g, [](const T& a, const T& b) {
+        return (b < a) ? b : a; });
+}
+
+//---------------------------------------------------------
+/**
+ * @brief h(x) = max(f(x), g(x)) in O(n+m)
+ *        exact within the union of both node key ranges, since crossing
+ *        points of f and g are inserted as additional nodes
+ */
+template<class K, class T, class I, class C, class A, class P>
+inline interpolating_map<K,T,I,C,A,P>
+pointwise_max(const interpolating_map<K,T,I,C,A,P>& f,
+              const interpolating_map<K,T,I,C,A,P>& g)
+{
+    return detail::select_pointwise(f, g, [](const T& a, const T& b) {
+        return (a < b) ? b : a; });
+}
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief composition h(x) = f(g(x))
+ *
+ * @details The result uses f's interpolator and g's key type, key
+ *          comparison, allocator (rebound to the result's nodes) and
+ *          instrumentation policy.
+ *          Nodes of h are g's nodes plus all keys x for which g(x) hits a
+ *          node key of f (if g is segment-linear). The result is exact within
+ *          g's node key range if both f and g are piecewise linear.
+ *          Runs in O((m + k) log(n)) with k = number of additional nodes.
+ *
+ *****************************************************************************/
+template<class KF, class TF, class IF, class CF, class AF, class PF,
+         class KG, class TG, class IG, class CG, class AG, class PG>
+interpolating_map<KG,TF,IF,CG,detail::rebind_node_alloc_t<AG,KG,TF>,PG>
+compose(const interpolating_map<KF,TF,IF,CF,AF,PF>& f,
+        const interpolating_map<KG,TG,IG,CG,AG,PG>& g)
+{
+    using map_t = interpolating_map<KG,TF,IF,CG,
+                                    detail::rebind_node_alloc_t<AG,KG,TF>,PG>;
+
+    using fnode_t = typename interpolating_map<KF,TF,IF,CF,AF,PF>::value_type;
+
+    typename map_t::container_type nodes(
+        typename map_t::container_type::allocator_type(g.get_allocator()));
+    nodes.reserve(2 * g.size());
+
+    const auto fb = f.begin();
+    const auto fe = f.end();
+
+    const auto gb = g.begin();
+    const auto ge = g.end();
+
+    for(auto gi = gb; gi != ge; ++gi) {
+        nodes.emplace_back(gi->first, f(KF(gi->second)));
+
+        const auto gj = std::next(gi);
+        if(!interpolator::is_segment_linear<IG>::value || gj == ge ||
+           !(gi->first < gj->first))
+        {
+            continue;
+        }
+
+        const auto y0 = gi->second;
+        const auto y1 = gj->second;
+        if(!(y0 < y1) && !(y1 < y0)) continue;
+
+        const auto lo = (y0 < y1) ? y0 : y1;
+        const auto hi = (y0 < y1) ? y1 : y0;
+
+        //f's nodes strictly inside (lo,hi)
+        const auto first = std::upper_bound(fb, fe, lo,
+            [](const TG& y, const fnode_t& n) { return y < n.first; });
+        const auto last = std::lower_bound(first, fe, hi,
+            [](const fnode_t& n, const TG& y) { return n.first < y; });
+
+        const auto emit = [&](const fnode_t& n) {
+            const double t = double(n.first - y0) / double(y1 - y0);
+            const auto x = interpolator::segment_key(g.interpolator(),
+                                               gi->first, gj->first, t);
+            if(nodes.back().first < x && x < gj->first) {
+                nodes.emplace_back(x, f(n.first));
+            }
+        };
+
+        if(y0 < y1) {
+            std::for_each(first, last, emit);
+        } else {
+            std::for_each(std::make_reverse_iterator(last),
+                          std::make_reverse_iterator(first), emit);
+        }
+    }
+
+    return map_t{sorted_range, std::move(nodes), f.interpolator(), g.key_comp()};
+}
+
+
+} //namespace am
+
+
+#endif
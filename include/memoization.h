@@ -0,0 +1,237 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_MEMOIZATION_H_
+#define AMLIB_MEMOIZATION_H_
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "instrumentation.h"
+
+
+namespace am {
+
+
+namespace detail {
+
+//-------------------------------------------------------------------
+template<int I> struct priority : priority<I-1> {};
+template<> struct priority<0> {};
+
+
+//-------------------------------------------------------------------
+/// node set version of maps (interpolating_map, copy_on_write)
+template<class F>
+inline auto
+memo_version(const F& f, priority<1>) -> decltype(std::uint64_t(f.version())) {
+    return f.version();
+}
+/// node set version of gradients
+template<class F>
+inline auto
+memo_version(const F& f, priority<0>) -> decltype(std::uint64_t(f.map().version())) {
+    return f.map().version();
+}
+
+
+//-------------------------------------------------------------------
+template<class F, class = void>
+struct memo_types {
+    using key_type = typename F::argument_type;
+    using mapped_type = typename F::result_type;
+    using probe_type = instrumentation::none;
+};
+
+template<class F>
+struct memo_types<F,std::enable_if_t<
+    std::is_same<typename F::key_type,typename F::key_type>::value &&
+    std::is_same<typename F::instrumentation_type,
+                 typename F::instrumentation_type>::value>>
+{
+    using key_type = typename F::key_type;
+    using mapped_type = typename F::mapped_type;
+    using probe_type = typename F::instrumentation_type;
+};
+
+} // namespace detail
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief evaluates a map (or gradient) through a small per-thread,
+ *        direct-mapped cache of results for exact query keys
+ *
+ * @details Entries are tagged with the bit pattern of the key and the
+ *          process-wide unique node set version of the map
+ *          (see interpolating_map::version()), so modifications of the
+ *          map invalidate them without any bookkeeping.
+ *          A hit costs one hash and one compare, a miss one
+ *          evaluation of the map.
+ *          All memoized<F,Slots> instances of a thread share one table;
+ *          nothing is shared between threads.
+ *
+ *          Hits and misses are reported to the map's instrumentation
+ *          policy (cache_hit / cache_miss) and counted per thread
+ *          (thread_stats()).
+ *
+ * @tparam F      interpolating_map, copy_on_write or interpolating_gradient;
+ *                keys must be trivially copyable with at most 8 bytes
+ * @tparam Slots  number of table entries per thread (power of 2)
+ *
+ *****************************************************************************/
+template<class F, std::size_t Slots = 64>
+class memoized
+{
+    static_assert(Slots > 0 && (Slots & (Slots - 1)) == 0,
+                  "number of slots must be a power of 2");
+
+    using types_ = detail::memo_types<F>;
+    using probe_ = typename types_::probe_type;
+
+public:
+    //---------------------------------------------------------------
+    using function_type = F;
+    using key_type = typename types_::key_type;
+    using mapped_type = typename types_::mapped_type;
+
+    static_assert(std::is_trivially_copyable<key_type>::value &&
+                  sizeof(key_type) <= sizeof(std::uint64_t),
+                  "key must be trivially copyable and at most 8 bytes large");
+
+    //-----------------------------------------------------
+    struct statistics {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+    };
+
+
+    //---------------------------------------------------------------
+    /// @pre f must outlive the wrapper
+    explicit
+    memoized(const F& f) noexcept : f_(&f) {}
+
+
+    //---------------------------------------------------------------
+    mapped_type
+    operator () (const key_type& x) const {
+        const auto bits = key_bits(x);
+        const auto version = std::uint64_t(
+            detail::memo_version(*f_, detail::priority<1>{}));
+
+        auto& e = table()[slot(bits, version)];
+
+        if(e.version == version && e.bits == bits) {
+            probe_::cache_hit();
+            ++stats().hits;
+            return e.value;
+        }
+
+        probe_::cache_miss();
+        ++stats().misses;
+        e.value = (*f_)(x);
+        e.bits = bits;
+        e.version = version;
+        return e.value;
+    }
+
+
+    //---------------------------------------------------------------
+    const F& function() const noexcept { return *f_; }
+
+    //-----------------------------------------------------
+    ///@brief hits and misses of all memoized<F,Slots> in the calling thread
+    static statistics
+    thread_stats() noexcept { return stats(); }
+
+    static void
+    reset_thread_stats() noexcept { stats() = statistics{}; }
+
+
+private:
+    //---------------------------------------------------------------
+    struct entry {
+        std::uint64_t version = 0;   //0: unused
+        std::uint64_t bits = 0;
+        mapped_type value{};
+    };
+
+    using table_t_ = std::array<entry,Slots>;
+
+
+    //---------------------------------------------------------------
+    static table_t_&
+    table() {
+        static thread_local table_t_ t;
+        return t;
+    }
+
+    //-----------------------------------------------------
+    static statistics&
+    stats() noexcept {
+        static thread_local statistics s;
+        return s;
+    }
+
+
+    //---------------------------------------------------------------
+    static std::uint64_t
+    key_bits(const key_type& x) noexcept {
+        std::uint64_t bits = 0;
+        std::memcpy(&bits, &x, sizeof(key_type));
+        return bits;
+    }
+
+    //-----------------------------------------------------
+    static std::size_t
+    slot(std::uint64_t bits, std::uint64_t version) noexcept {
+        auto h = bits ^ (version * 0x9e3779b97f4a7c15ull);
+        h ^= h >> 32;
+        h *= 0xd6e8feb86659fd93ull;
+        h ^= h >> 32;
+        return std::size_t(h & (Slots - 1));
+    }
+
+
+    //---------------------------------------------------------------
+    const F* f_;
+};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief memoizing wrapper for a map or gradient
+ *
+ *****************************************************************************/
+template<std::size_t Slots = 64, class F>
+inline memoized<F,Slots>
+memoize(const F& f) noexcept
+{
+    return memoized<F,Slots>{f};
+}
+
+/// the wrapper would refer to a destroyed map
+template<std::size_t Slots = 64, class F>
+void memoize(const F&&) = delete;
+
+
+} //namespace am
+
+
+#endif
@@ -0,0 +1,112 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_MEMORY_FOOTPRINT_H_
+#define AMLIB_MEMORY_FOOTPRINT_H_
+
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+
+namespace am {
+
+
+/*************************************************************************//***
+ *
+ * @brief heap memory held by a map (in bytes)
+ *
+ * @details Reports can be summed up over any number of maps.
+ *          Data shared between maps (copy_on_write, copies of derived
+ *          node data) is reported by each map that refers to it.
+ *
+ *****************************************************************************/
+struct memory_footprint
+{
+    using size_type = std::size_t;
+
+    /// occupied by stored nodes
+    size_type nodes = 0;
+    /// reserved, but unused node capacity
+    size_type slack = 0;
+    /// search indices, block headers, ...
+    size_type index = 0;
+    /// node data derived by the interpolator
+    size_type cache = 0;
+
+    //---------------------------------------------------------------
+    size_type
+    total() const noexcept {
+        return nodes + slack + index + cache;
+    }
+
+    //---------------------------------------------------------------
+    memory_footprint&
+    operator += (const memory_footprint& o) noexcept {
+        nodes += o.nodes;
+        slack += o.slack;
+        index += o.index;
+        cache += o.cache;
+        return *this;
+    }
+
+    friend memory_footprint
+    operator + (memory_footprint a, const memory_footprint& b) noexcept {
+        return a += b;
+    }
+};
+
+
+
+
+namespace detail {
+
+//-------------------------------------------------------------------
+template<class Interpolator, class Cache, class = void>
+struct has_cache_memory_usage : std::false_type {};
+
+template<class Interpolator, class Cache>
+struct has_cache_memory_usage<Interpolator,Cache,
+    decltype(void(std::declval<const Interpolator&>().memory_usage(
+        std::declval<const Cache&>())))>
+:
+    std::true_type
+{};
+
+
+//-------------------------------------------------------------------
+/// heap bytes of derived node data (as reported by the interpolator)
+template<class Interpolator, class Cache>
+inline std::size_t
+cache_memory_usage(const Interpolator& ipl, const Cache& c, std::true_type) {
+    return ipl.memory_usage(c);
+}
+
+template<class Interpolator, class Cache>
+inline std::size_t
+cache_memory_usage(const Interpolator&, const Cache&, std::false_type) {
+    return sizeof(Cache);
+}
+
+template<class Interpolator, class Cache>
+inline std::size_t
+cache_memory_usage(const Interpolator& ipl, const Cache& c) {
+    return cache_memory_usage(ipl, c,
+        has_cache_memory_usage<Interpolator,Cache>{});
+}
+
+} // namespace detail
+
+
+} //namespace am
+
+
+#endif
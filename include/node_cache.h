@@ -0,0 +1,563 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_NODE_CACHE_H_
+#define AMLIB_NODE_CACHE_H_
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "memory_footprint.h"
+
+
+namespace am {
+
+
+/*************************************************************************//***
+ *
+ * @brief how node data derived by an interpolator is rebuilt after
+ *        a map was modified
+ *
+ * synchronous: rebuilt by the modifying call
+ * background:  the modifying call only copies the nodes and rebuilds
+ *              on a worker thread; until the new data is published,
+ *              queries use a plain search over the nodes;
+ *              modifications never wait for a running rebuild, rebuilds
+ *              of superseded node versions are skipped; local updates
+ *              (single node insert/erase, value changes) are still
+ *              applied in place if no rebuild is in flight
+ *
+ *****************************************************************************/
+enum class rebuild_mode {
+    synchronous, background
+};
+
+
+
+
+namespace detail {
+
+
+/*************************************************************************//***
+ *
+ * @brief latest published version of derived node data;
+ *        shared by a node_cache_holder and its rebuild worker
+ *
+ * @details Readers only load a raw pointer (acquire).
+ *          Replaced entries are kept alive until the next modification
+ *          of the owning map (=> no reader can use them anymore).
+ *
+ *          Background rebuilds are queued with schedule(): at most one
+ *          detached worker thread per slot runs at a time and always
+ *          builds the newest queued version; older queued versions are
+ *          dropped. The worker owns a reference to the slot, so neither
+ *          the writer nor the destruction of the map waits for it.
+ *
+ *****************************************************************************/
+template<class Cache>
+class node_cache_slot :
+    public std::enable_shared_from_this<node_cache_slot<Cache>>
+{
+public:
+    struct entry {
+        explicit entry(std::uint64_t v): version(v), cache{} {}
+        std::uint64_t version;
+        Cache cache;
+    };
+
+    using entry_ptr = std::shared_ptr<const entry>;
+    using build_function = std::function<void(Cache&)>;
+
+
+    //---------------------------------------------------------------
+    node_cache_slot():
+        current_{nullptr}, build_{}, buildVersion_(0), busy_(false)
+    {}
+
+    node_cache_slot(const node_cache_slot&) = delete;
+    node_cache_slot& operator = (const node_cache_slot&) = delete;
+
+
+    //---------------------------------------------------------------
+    const entry*
+    current() const noexcept {
+        return current_.load(std::memory_order_acquire);
+    }
+
+    //-----------------------------------------------------
+    entry_ptr
+    latest() const {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return latest_;
+    }
+
+
+    //---------------------------------------------------------------
+    /// ignores entries that are older than the current one
+    void
+    publish(entry_ptr e) {
+        if(!e) return;
+        std::lock_guard<std::mutex> lock{mutex_};
+        publish_locked(std::move(e));
+    }
+
+
+    //---------------------------------------------------------------
+    /**
+     * @brief queues a rebuild of version 'version' on the worker thread
+     * @return ready, when 'version' or a newer one was published
+     *         (or its rebuild failed)
+     */
+    std::shared_future<void>
+    schedule(std::uint64_t version, build_function build)
+    {
+        std::promise<void> p;
+        auto f = p.get_future().share();
+
+        //superseded job is destroyed outside of the lock
+        build_function superseded;
+        bool start = false;
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            superseded = std::move(build_);
+            build_ = std::move(build);
+            buildVersion_ = version;
+            waiting_.emplace_back(version, std::move(p));
+            start = !busy_;
+            busy_ = true;
+        }
+        if(start) {
+            try {
+                auto self = this->shared_from_this();
+                std::thread{[self] { self->work(); }}.detach();
+            }
+            catch(...) {
+                std::lock_guard<std::mutex> lock{mutex_};
+                busy_ = false;
+                build_ = nullptr;
+                waiting_.pop_back();
+                throw;
+            }
+        }
+        return f;
+    }
+
+    //-----------------------------------------------------
+    /// true, if a rebuild is queued or running
+    bool
+    rebuilding() const {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return busy_;
+    }
+
+    //-----------------------------------------------------
+    /**
+     * @return latest entry for in-place modification or nullptr,
+     *         if it is also used by other slots
+     * @pre no concurrent readers
+     */
+    entry*
+    exclusive() {
+        std::lock_guard<std::mutex> lock{mutex_};
+        //entries are created non-const (see node_cache_holder)
+        return latest_.use_count() == 1
+               ? const_cast<entry*>(latest_.get()) : nullptr;
+    }
+
+    //-----------------------------------------------------
+    /// @pre no concurrent readers
+    void
+    release_retired() {
+        std::lock_guard<std::mutex> lock{mutex_};
+        retired_.clear();
+    }
+
+
+private:
+    //---------------------------------------------------------------
+    void
+    publish_locked(entry_ptr e) {
+        if(latest_) {
+            if(e->version < latest_->version) return;
+            retired_.push_back(std::move(latest_));
+        }
+        latest_ = std::move(e);
+        current_.store(latest_.get(), std::memory_order_release);
+    }
+
+    //---------------------------------------------------------------
+    /// worker loop: builds the newest queued version until none is left
+    void
+    work() {
+        std::unique_lock<std::mutex> lock{mutex_};
+        while(build_) {
+            const auto version = buildVersion_;
+            std::exception_ptr error;
+            entry_ptr e;
+            {
+                auto build = std::move(build_);
+                build_ = nullptr;
+                lock.unlock();
+                try {
+                    auto ne = std::make_shared<entry>(version);
+                    build(ne->cache);
+                    e = std::move(ne);
+                }
+                catch(...) {
+                    error = std::current_exception();
+                }
+            }
+            lock.lock();
+            if(e) publish_locked(std::move(e));
+
+            auto w = std::partition(waiting_.begin(), waiting_.end(),
+                [&](const auto& p) { return p.first > version; });
+            for(auto i = w; i != waiting_.end(); ++i) {
+                if(error) i->second.set_exception(error);
+                else      i->second.set_value();
+            }
+            waiting_.erase(w, waiting_.end());
+        }
+        busy_ = false;
+    }
+
+
+    //---------------------------------------------------------------
+    mutable std::mutex mutex_;
+    entry_ptr latest_;
+    std::vector<entry_ptr> retired_;
+    std::atomic<const entry*> current_;
+    //rebuild queue (newest version only)
+    build_function build_;
+    std::uint64_t buildVersion_;
+    bool busy_;
+    std::vector<std::pair<std::uint64_t,std::promise<void>>> waiting_;
+};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief true, if an interpolator can refresh derived data after
+ *        the mapped values of nodes [first,last) changed (keys unchanged):
+ *          void refresh_values(Iterator begin, Iterator end, cache_type&,
+ *                              std::size_t first, std::size_t last) const;
+ *
+ *****************************************************************************/
+template<class Interpolator, class Iterator, class Cache, class = void>
+struct has_value_refresh : std::false_type {};
+
+template<class Interpolator, class Iterator, class Cache>
+struct has_value_refresh<Interpolator,Iterator,Cache,
+    decltype(void(std::declval<const Interpolator&>().refresh_values(
+        std::declval<Iterator>(), std::declval<Iterator>(),
+        std::declval<Cache&>(), std::size_t(0), std::size_t(0))))>
+:
+    std::true_type
+{};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief true, if an interpolator can update derived data after
+ *        'erased' nodes at index pos were replaced by 'inserted' nodes:
+ *          void splice_nodes(Iterator begin, Iterator end, cache_type&,
+ *                            std::size_t pos, std::size_t erased,
+ *                            std::size_t inserted) const;
+ *
+ *****************************************************************************/
+template<class Interpolator, class Iterator, class Cache, class = void>
+struct has_node_splice : std::false_type {};
+
+template<class Interpolator, class Iterator, class Cache>
+struct has_node_splice<Interpolator,Iterator,Cache,
+    decltype(void(std::declval<const Interpolator&>().splice_nodes(
+        std::declval<Iterator>(), std::declval<Iterator>(),
+        std::declval<Cache&>(), std::size_t(0), std::size_t(0),
+        std::size_t(0))))>
+:
+    std::true_type
+{};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief keeps node data derived by an interpolator consistent with
+ *        a node container
+ *
+ * @details Each modification increments a version number; derived data
+ *          is only used if it was built from the current version.
+ *
+ *****************************************************************************/
+template<class Interpolator, class Key, class Value>
+class node_cache_holder
+{
+public:
+    using cache_type = typename Interpolator::template cache_type<Key,Value>;
+
+private:
+    using slot_t_ = node_cache_slot<cache_type>;
+    using entry_t_ = typename slot_t_::entry;
+    using build_t_ = typename slot_t_::build_function;
+
+public:
+    //---------------------------------------------------------------
+    node_cache_holder():
+        slot_{std::make_shared<slot_t_>()},
+        version_(0), mode_(rebuild_mode::synchronous), pending_{},
+        rebuild_{}
+    {}
+
+    //-----------------------------------------------------
+    /**
+     * @brief shares the source's latest derived data (immutable);
+     *        if the source's current version is still being rebuilt,
+     *        the copy queues the same rebuild on its own slot
+     */
+    node_cache_holder(const node_cache_holder& src):
+        slot_{std::make_shared<slot_t_>()},
+        version_(src.version_), mode_(src.mode_), pending_{},
+        rebuild_{src.rebuild_}
+    {
+        if(!src.slot_) return;
+        const auto latest = src.slot_->latest();
+        slot_->publish(latest);
+        if((!latest || latest->version != version_) && rebuild_) {
+            pending_ = slot_->schedule(version_, *rebuild_);
+        }
+    }
+
+    //-----------------------------------------------------
+    node_cache_holder(node_cache_holder&&) noexcept = default;
+
+
+    //---------------------------------------------------------------
+    node_cache_holder&
+    operator = (const node_cache_holder& src) {
+        node_cache_holder tmp{src};
+        std::swap(*this, tmp);
+        return *this;
+    }
+
+    //-----------------------------------------------------
+    node_cache_holder&
+    operator = (node_cache_holder&&) noexcept = default;
+
+
+    //---------------------------------------------------------------
+    rebuild_mode mode() const noexcept { return mode_; }
+
+    void mode(rebuild_mode m) noexcept { mode_ = m; }
+
+
+    //---------------------------------------------------------------
+    /// @return derived data for the current nodes or nullptr
+    const cache_type*
+    get() const noexcept {
+        const auto* e = slot_ ? slot_->current() : nullptr;
+        return (e && e->version == version_) ? &e->cache : nullptr;
+    }
+
+    //-----------------------------------------------------
+    /**
+     * @brief ready, when the derived data for the current nodes
+     *        is in use (or its rebuild failed)
+     */
+    std::shared_future<void>
+    pending() const {
+        if(pending_.valid()) return pending_;
+        std::promise<void> p;
+        p.set_value();
+        return p.get_future().share();
+    }
+
+
+    //---------------------------------------------------------------
+    /// has to be called after each modification of the nodes
+    template<class Container>
+    void
+    update(const Interpolator& ipl, const Container& nodes)
+    {
+        ++version_;
+        if(!slot_) slot_ = std::make_shared<slot_t_>();
+        slot_->release_retired();
+
+        if(mode_ == rebuild_mode::synchronous) {
+            rebuild_ = nullptr;
+            auto e = std::make_shared<entry_t_>(version_);
+            ipl.prepare(nodes.begin(), nodes.end(), e->cache);
+            slot_->publish(std::move(e));
+            return;
+        }
+
+        //the worker must not refer to the nodes: they may be modified
+        //or destroyed before the rebuild is finished
+        auto snapshot = std::make_shared<const std::vector<std::pair<Key,Value>>>(
+                            nodes.begin(), nodes.end());
+
+        rebuild_ = std::make_shared<const build_t_>(
+            [ipl, snapshot = std::move(snapshot)](cache_type& c) {
+                ipl.prepare(snapshot->begin(), snapshot->end(), c);
+            });
+        pending_ = slot_->schedule(version_, *rebuild_);
+    }
+
+
+    //---------------------------------------------------------------
+    ///@brief heap bytes of the derived data in use (0 if there is none)
+    std::size_t
+    memory_usage(const Interpolator& ipl) const {
+        const auto* c = get();
+        return c ? cache_memory_usage(ipl, *c) : 0;
+    }
+
+    //-----------------------------------------------------
+    ///@brief releases unused capacity of derived data that isn't shared
+    void
+    shrink_to_fit() {
+        if(!current()) return;
+        if(auto* e = slot_->exclusive()) {
+            //copies only allocate what they need
+            auto tmp = e->cache;
+            e->cache = std::move(tmp);
+        }
+    }
+
+
+    //---------------------------------------------------------------
+    /**
+     * @brief has to be called after the mapped values of nodes [first,last)
+     *        were changed (keys unchanged)
+     * @return false, if all derived data had to be rebuilt
+     */
+    template<class Container>
+    bool
+    update_values(const Interpolator& ipl, const Container& nodes,
+                  std::size_t first, std::size_t last)
+    {
+        using refresh_t = has_value_refresh<Interpolator,
+                              typename Container::const_iterator,cache_type>;
+
+        return patch(ipl, nodes, refresh_t{}, [&](auto& c) {
+            ipl.refresh_values(nodes.begin(), nodes.end(), c, first, last);
+        });
+    }
+
+    //-----------------------------------------------------
+    /**
+     * @brief has to be called after 'erased' nodes at index pos were
+     *        replaced by 'inserted' nodes (now at [pos,pos+inserted))
+     * @return false, if all derived data had to be rebuilt
+     */
+    template<class Container>
+    bool
+    update_nodes(const Interpolator& ipl, const Container& nodes,
+                 std::size_t pos, std::size_t erased, std::size_t inserted)
+    {
+        using splice_t = has_node_splice<Interpolator,
+                             typename Container::const_iterator,cache_type>;
+
+        return patch(ipl, nodes, splice_t{}, [&](auto& c) {
+            ipl.splice_nodes(nodes.begin(), nodes.end(), c,
+                             pos, erased, inserted);
+        });
+    }
+
+
+private:
+    //---------------------------------------------------------------
+    /**
+     * @brief true, if the latest derived data is up to date and in use
+     *        and no rebuild is in flight (=> can be updated locally)
+     */
+    bool
+    current() const {
+        if(!slot_ || slot_->rebuilding()) return false;
+        const auto e = slot_->latest();
+        return e && e->version == version_;
+    }
+
+
+    //---------------------------------------------------------------
+    /// interpolator can't update locally => full rebuild
+    template<class Container, class Patch>
+    bool
+    patch(const Interpolator& ipl, const Container& nodes,
+          std::false_type, Patch&&)
+    {
+        update(ipl, nodes);
+        return false;
+    }
+    //-----------------------------------------------------
+    /// applies a local update to the latest derived data
+    template<class Container, class Patch>
+    bool
+    patch(const Interpolator& ipl, const Container& nodes,
+          std::true_type, Patch&& patch)
+    {
+        if(!current()) {
+            update(ipl, nodes);
+            return false;
+        }
+
+        ++version_;
+        rebuild_ = nullptr;
+        slot_->release_retired();
+
+        //not shared with copies of the map => modify in place
+        if(auto* e = slot_->exclusive()) {
+            e->version = 0;  //stays invalid if the patch throws
+            patch(e->cache);
+            e->version = version_;
+            return true;
+        }
+
+        auto e = std::make_shared<entry_t_>(version_);
+        e->cache = slot_->latest()->cache;
+        patch(e->cache);
+        slot_->publish(std::move(e));
+        return true;
+    }
+
+
+    //---------------------------------------------------------------
+    std::shared_ptr<slot_t_> slot_;
+    std::uint64_t version_;
+    rebuild_mode mode_;
+    std::shared_future<void> pending_;
+    /// background rebuild of the current version (kept for copies)
+    std::shared_ptr<const build_t_> rebuild_;
+};
+
+
+} // namespace detail
+
+
+} //namespace am
+
+
+#endif
@@ -0,0 +1,639 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_NODE_TABLE_IO_H_
+#define AMLIB_NODE_TABLE_IO_H_
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#  if __has_include(<charconv>)
+#    include <charconv>
+#    define AMLIB_HAS_CHARCONV
+#  endif
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  define AMLIB_HAS_MMAP
+#endif
+
+#include "vector_map.h"
+
+
+namespace am {
+
+
+/*************************************************************************//***
+ *
+ * @brief what happens with lines that can't be parsed
+ *
+ * fail: throw parse_error for the first one
+ * skip: ignore them (they are counted / reported in parse_report)
+ *
+ *****************************************************************************/
+enum class on_parse_error {
+    fail, skip
+};
+
+
+
+/*************************************************************************//***
+ *
+ * @brief layout of node tables in text form (CSV, TSV, whitespace)
+ *
+ *****************************************************************************/
+struct text_format
+{
+    /// field separator; ' ' => runs of spaces and tabs
+    char delimiter = ',';
+    /// field indices (0-based) of keys and values
+    std::size_t key_column = 0;
+    std::size_t value_column = 1;
+    /// number of lines at the beginning (e.g. headers) that are ignored
+    std::size_t header_lines = 0;
+    /// lines starting with this character are ignored ('\0': none)
+    char comment = '#';
+    on_parse_error errors = on_parse_error::fail;
+    /// parser threads; 0: hardware concurrency
+    unsigned threads = 1;
+    /// number of issues that are kept in a parse_report
+    std::size_t max_reported = 16;
+};
+
+
+
+//-------------------------------------------------------------------
+struct parse_issue
+{
+    /// 1-based line number
+    std::size_t line = 0;
+    /// 0-based field index
+    std::size_t field = 0;
+    std::string message;
+};
+
+
+
+//-------------------------------------------------------------------
+class parse_error :
+    public std::runtime_error
+{
+public:
+    explicit
+    parse_error(parse_issue issue):
+        std::runtime_error{"line " + std::to_string(issue.line) +
+                           ", field " + std::to_string(issue.field) +
+                           ": " + issue.message},
+        issue_(std::move(issue))
+    {}
+
+    const parse_issue& issue() const noexcept { return issue_; }
+
+private:
+    parse_issue issue_;
+};
+
+
+
+//-------------------------------------------------------------------
+struct parse_report
+{
+    /// all lines including headers, comments and empty lines
+    std::size_t lines = 0;
+    std::size_t nodes = 0;
+    /// lines that couldn't be parsed (on_parse_error::skip)
+    std::size_t rejected = 0;
+    /// true, if the nodes were already in ascending key order
+    bool sorted = true;
+    /// the first text_format::max_reported issues
+    std::vector<parse_issue> issues;
+};
+
+
+
+
+namespace detail {
+
+
+/*************************************************************************//***
+ *
+ * @brief converts a complete field to a number
+ *
+ *****************************************************************************/
+template<class T>
+inline std::enable_if_t<std::is_integral<T>::value,bool>
+parse_number(const char* b, const char* e, T& x)
+{
+    if(b != e && *b == '+') ++b;
+    if(b == e) return false;
+#ifdef AMLIB_HAS_CHARCONV
+    const auto r = std::from_chars(b, e, x);
+    return r.ec == std::errc{} && r.ptr == e;
+#else
+    char buf[32];
+    const auto n = std::size_t(e - b);
+    if(n >= sizeof(buf)) return false;
+    std::memcpy(buf, b, n);
+    buf[n] = '\0';
+    char* end = nullptr;
+    errno = 0;
+    const auto v = std::is_signed<T>::value
+                 ? (long long)std::strtoll(buf, &end, 10)
+                 : (long long)std::strtoull(buf, &end, 10);
+    if(end != buf + n || errno == ERANGE) return false;
+    x = T(v);
+    return (long long)(x) == v;
+#endif
+}
+
+//-------------------------------------------------------------------
+template<class T>
+inline std::enable_if_t<std::is_floating_point<T>::value,bool>
+parse_number(const char* b, const char* e, T& x)
+{
+    if(b != e && *b == '+') ++b;
+    if(b == e) return false;
+#if defined(AMLIB_HAS_CHARCONV) && defined(__cpp_lib_to_chars)
+    const auto r = std::from_chars(b, e, x);
+    return r.ec == std::errc{} && r.ptr == e;
+#else
+    char buf[64];
+    const auto n = std::size_t(e - b);
+    if(n >= sizeof(buf)) return false;
+    std::memcpy(buf, b, n);
+    buf[n] = '\0';
+    char* end = nullptr;
+    errno = 0;
+    x = T(std::strtold(buf, &end));
+    return end == buf + n && errno != ERANGE;
+#endif
+}
+
+
+
+/*************************************************************************//***
+ *
+ * @brief result of parsing one chunk of lines
+ *
+ *****************************************************************************/
+template<class Container>
+struct parsed_chunk
+{
+    Container nodes;
+    parse_report report;
+    /// first issue (=> chunk was aborted with on_parse_error::fail)
+    bool failed = false;
+    parse_issue error;
+};
+
+
+
+//-------------------------------------------------------------------
+inline bool
+is_blank(char c) noexcept {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+//-------------------------------------------------------------------
+/// start of the line after the one that contains p
+inline const char*
+next_line(const char* p, const char* last) noexcept {
+    const auto nl = static_cast<const char*>(
+        std::memchr(p, '\n', std::size_t(last - p)));
+    return nl ? nl + 1 : last;
+}
+
+
+
+/*************************************************************************//***
+ *
+ * @brief parses all lines in [first,last)
+ *
+ *****************************************************************************/
+template<class Container>
+void
+parse_lines(const char* first, const char* last, const text_format& fmt,
+            parsed_chunk<Container>& out)
+{
+    using key_t = std::remove_const_t<typename Container::value_type::first_type>;
+    using val_t = typename Container::value_type::second_type;
+
+    const auto lastField = std::max(fmt.key_column, fmt.value_column);
+    auto& rep = out.report;
+
+    const auto issue = [&](std::size_t field, const char* msg) {
+        ++rep.rejected;
+        parse_issue i;
+        i.line = rep.lines;
+        i.field = field;
+        i.message = msg;
+        if(fmt.errors == on_parse_error::fail) {
+            out.failed = true;
+            out.error = std::move(i);
+        }
+        else if(rep.issues.size() < fmt.max_reported) {
+            rep.issues.push_back(std::move(i));
+        }
+    };
+
+    while(first < last) {
+        const char* eol = static_cast<const char*>(
+            std::memchr(first, '\n', std::size_t(last - first)));
+        if(!eol) eol = last;
+        ++rep.lines;
+
+        const char* p = first;
+        first = eol < last ? eol + 1 : last;
+
+        //empty and comment lines
+        while(p < eol && is_blank(*p)) ++p;
+        if(p == eol || (fmt.comment != '\0' && *p == fmt.comment)) continue;
+
+        key_t k{};
+        val_t v{};
+        bool haveKey = false;
+        bool haveVal = false;
+        bool bad = false;
+
+        for(std::size_t f = 0; f <= lastField; ++f) {
+            if(fmt.delimiter == ' ') {
+                while(p < eol && is_blank(*p)) ++p;
+            }
+            if(p >= eol && (fmt.delimiter == ' ' || f > 0)) {
+                issue(f, "missing field");
+                bad = true;
+                break;
+            }
+            const char* b = p;
+            const char* e = p;
+            if(fmt.delimiter == ' ') {
+                while(e < eol && !is_blank(*e)) ++e;
+                p = e;
+            } else {
+                while(e < eol && *e != fmt.delimiter) ++e;
+                p = e < eol ? e + 1 : eol + 1;
+                while(b < e && is_blank(*b)) ++b;
+                while(e > b && is_blank(e[-1])) --e;
+            }
+
+            if(f == fmt.key_column) {
+                if(!parse_number(b, e, k)) {
+                    issue(f, "invalid key");
+                    bad = true;
+                    break;
+                }
+                haveKey = true;
+            }
+            if(f == fmt.value_column) {
+                if(!parse_number(b, e, v)) {
+                    issue(f, "invalid value");
+                    bad = true;
+                    break;
+                }
+                haveVal = true;
+            }
+        }
+        if(out.failed) return;
+        if(bad || !haveKey || !haveVal) continue;
+
+        if(!out.nodes.empty() && k < out.nodes.back().first) rep.sorted = false;
+        out.nodes.emplace_back(k, v);
+        ++rep.nodes;
+    }
+}
+
+
+
+/*************************************************************************//***
+ *
+ * @brief parses [first,last) in parallel chunks that are split at line
+ *        boundaries and appends the nodes to 'nodes' (in input order)
+ *
+ *****************************************************************************/
+template<class Container>
+void
+parse_text(const char* first, const char* last, const text_format& fmt,
+           Container& nodes, parse_report& report)
+{
+    //headers
+    for(std::size_t i = 0; i < fmt.header_lines && first < last; ++i) {
+        first = next_line(first, last);
+        ++report.lines;
+    }
+    if(first >= last) return;
+
+    //chunks of at least 1 MiB
+    constexpr std::size_t minChunk = std::size_t(1) << 20;
+    const auto size = std::size_t(last - first);
+    auto threads = fmt.threads > 0 ? fmt.threads
+                                   : std::max(1u, std::thread::hardware_concurrency());
+    threads = unsigned(std::max(std::size_t(1),
+                       std::min(std::size_t(threads), size / minChunk)));
+
+    std::vector<const char*> bounds {first};
+    for(unsigned t = 1; t < threads; ++t) {
+        const char* p = first + size * t / threads;
+        if(p > bounds.back()) {
+            //no line in multiple chunks
+            bounds.push_back(next_line(p - 1, last));
+        }
+    }
+    bounds.push_back(last);
+
+    const auto n = bounds.size() - 1;
+    std::vector<parsed_chunk<Container>> chunks(n,
+        parsed_chunk<Container>{Container(nodes.get_allocator()), {}, false, {}});
+
+    if(n == 1) {
+        parse_lines(bounds[0], bounds[1], fmt, chunks[0]);
+    } else {
+        //estimated number of nodes
+        const auto avgLine = std::max(std::size_t(1), std::size_t(
+            next_line(first, last) - first));
+        std::vector<std::thread> workers;
+        workers.reserve(n - 1);
+        for(std::size_t i = 1; i < n; ++i) {
+            workers.emplace_back([&,i] {
+                chunks[i].nodes.reserve(std::size_t(bounds[i+1] - bounds[i]) / avgLine);
+                parse_lines(bounds[i], bounds[i+1], fmt, chunks[i]);
+            });
+        }
+        chunks[0].nodes.reserve(std::size_t(bounds[1] - bounds[0]) / avgLine);
+        parse_lines(bounds[0], bounds[1], fmt, chunks[0]);
+        for(auto& w : workers) w.join();
+    }
+
+    //merge
+    std::size_t total = nodes.size();
+    for(const auto& c : chunks) total += c.nodes.size();
+    nodes.reserve(total);
+
+    for(auto& c : chunks) {
+        const auto lineOffset = report.lines;
+        if(c.failed) {
+            c.error.line += lineOffset;
+            throw parse_error{std::move(c.error)};
+        }
+        if(c.report.nodes > 0) {
+            if(!c.report.sorted || (!nodes.empty() &&
+               c.nodes.front().first < nodes.back().first))
+            {
+                report.sorted = false;
+            }
+            nodes.insert(nodes.end(), std::make_move_iterator(c.nodes.begin()),
+                                      std::make_move_iterator(c.nodes.end()));
+        }
+        for(auto& i : c.report.issues) {
+            if(report.issues.size() >= fmt.max_reported) break;
+            i.line += lineOffset;
+            report.issues.push_back(std::move(i));
+        }
+        report.lines += c.report.lines;
+        report.nodes += c.report.nodes;
+        report.rejected += c.report.rejected;
+    }
+}
+
+
+
+/*************************************************************************//***
+ *
+ * @brief read-only memory mapping of a whole file
+ *
+ *****************************************************************************/
+#ifdef AMLIB_HAS_MMAP
+class mapped_file
+{
+public:
+    explicit
+    mapped_file(const std::string& filename)
+    {
+        fd_ = ::open(filename.c_str(), O_RDONLY);
+        if(fd_ < 0) throw std::runtime_error{"can't open file " + filename};
+
+        struct stat st;
+        if(::fstat(fd_, &st) != 0) {
+            ::close(fd_);
+            throw std::runtime_error{"can't read file " + filename};
+        }
+        size_ = std::size_t(st.st_size);
+        if(size_ == 0) return;
+
+        void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if(p == MAP_FAILED) {
+            ::close(fd_);
+            throw std::runtime_error{"can't map file " + filename};
+        }
+        ::madvise(p, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(p);
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator = (const mapped_file&) = delete;
+
+    ~mapped_file() {
+        if(data_) ::munmap(const_cast<char*>(data_), size_);
+        ::close(fd_);
+    }
+
+    const char* begin() const noexcept { return data_; }
+    const char* end() const noexcept   { return data_ + size_; }
+
+private:
+    int fd_ = -1;
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+#endif
+
+
+
+//-------------------------------------------------------------------
+/// chunk-wise; only complete lines are handed to the parser
+template<class Container>
+void
+read_text(std::istream& is, const text_format& fmt,
+          Container& nodes, parse_report& report)
+{
+    constexpr std::size_t chunkSize = std::size_t(1) << 20;
+
+    auto f = fmt;
+    std::vector<char> buf;
+    std::size_t carry = 0;
+
+    while(is) {
+        buf.resize(carry + chunkSize);
+        is.read(buf.data() + carry, std::streamsize(chunkSize));
+        const auto n = carry + std::size_t(is.gcount());
+        if(n == 0) break;
+
+        const char* b = buf.data();
+        const char* e = b + n;
+        //last complete line
+        const char* cut = e;
+        if(is) {
+            while(cut > b && cut[-1] != '\n') --cut;
+            //line longer than a chunk => read more
+            if(cut == b) { carry = n; continue; }
+        }
+
+        const auto linesBefore = report.lines;
+        parse_text(b, cut, f, nodes, report);
+        if(report.lines > linesBefore) {
+            f.header_lines -= std::min(f.header_lines, report.lines - linesBefore);
+        }
+
+        carry = std::size_t(e - cut);
+        std::memmove(buf.data(), cut, carry);
+    }
+}
+
+
+//-------------------------------------------------------------------
+template<class Container>
+void
+read_text(const std::string& filename, const text_format& fmt,
+          Container& nodes, parse_report& report)
+{
+#ifdef AMLIB_HAS_MMAP
+    const mapped_file file{filename};
+    parse_text(file.begin(), file.end(), fmt, nodes, report);
+#else
+    std::ifstream is{filename, std::ios::binary};
+    if(!is) throw std::runtime_error{"can't open file " + filename};
+    read_text(is, fmt, nodes, report);
+#endif
+}
+
+
+//-------------------------------------------------------------------
+/// stable => nodes with equal keys keep their input order
+template<class Container>
+void
+sort_nodes(Container& nodes, const parse_report& report)
+{
+    if(report.sorted) return;
+    std::stable_sort(nodes.begin(), nodes.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+}
+
+
+} // namespace detail
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief parses a node table from a character range
+ *        (e.g. "key,value" lines); nodes are returned in input order
+ *
+ * @details Numbers are parsed with std::from_chars if available
+ *          (C++17 library support), otherwise with strtod/strtoll.
+ *          With fmt.threads != 1 large inputs are parsed in parallel
+ *          chunks that are split at line boundaries.
+ *
+ * @throws parse_error  for the first invalid line (on_parse_error::fail)
+ *
+ *****************************************************************************/
+template<class Key, class Value>
+std::vector<std::pair<Key,Value>>
+parse_nodes(const char* first, const char* last,
+            const text_format& fmt = text_format{},
+            parse_report* report = nullptr)
+{
+    std::vector<std::pair<Key,Value>> nodes;
+    parse_report r;
+    detail::parse_text(first, last, fmt, nodes, r);
+    if(report) *report = std::move(r);
+    return nodes;
+}
+
+//-------------------------------------------------------------------
+/// reads chunk-wise from a stream
+template<class Key, class Value>
+std::vector<std::pair<Key,Value>>
+read_nodes(std::istream& is,
+           const text_format& fmt = text_format{},
+           parse_report* report = nullptr)
+{
+    std::vector<std::pair<Key,Value>> nodes;
+    parse_report r;
+    detail::read_text(is, fmt, nodes, r);
+    if(report) *report = std::move(r);
+    return nodes;
+}
+
+//-------------------------------------------------------------------
+/// memory-maps the file if possible (POSIX), reads chunk-wise otherwise
+template<class Key, class Value>
+std::vector<std::pair<Key,Value>>
+read_nodes(const std::string& filename,
+           const text_format& fmt = text_format{},
+           parse_report* report = nullptr)
+{
+    std::vector<std::pair<Key,Value>> nodes;
+    parse_report r;
+    detail::read_text(filename, fmt, nodes, r);
+    if(report) *report = std::move(r);
+    return nodes;
+}
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief builds a map (vector_map, interpolating_map, ...) from a node
+ *        table file or stream
+ *
+ * @details Nodes are parsed directly into the map's node container,
+ *          which is (stable-)sorted only if the input wasn't sorted and
+ *          then adopted by the map without further copies or searches.
+ *
+ * @tparam Map  must be constructible from (sorted_range, container_type&&)
+ *
+ *****************************************************************************/
+template<class Map, class Source>
+Map
+read_map(Source&& source,
+         const text_format& fmt = text_format{},
+         parse_report* report = nullptr)
+{
+    typename Map::container_type nodes;
+    parse_report r;
+    detail::read_text(std::forward<Source>(source), fmt, nodes, r);
+    detail::sort_nodes(nodes, r);
+    if(report) *report = std::move(r);
+    return Map(sorted_range, std::move(nodes));
+}
+
+
+} //namespace am
+
+
+#endif
@@ -0,0 +1,366 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_POLYNOMIAL_APPROXIMATION_H_
+#define AMLIB_POLYNOMIAL_APPROXIMATION_H_
+
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#include "interpolating_map.h"
+#include "simplification.h"
+
+
+namespace am {
+
+
+/*************************************************************************//***
+ *
+ * @brief Read-only piece-wise polynomial approximation of a function
+ *        on [lo,hi] with uniformly sized segments.
+ *
+ * @details Each segment holds the Degree+1 monomial coefficients of the
+ *          Chebyshev interpolant (near-minimax) of the function in the
+ *          local coordinate t in [-1,1].
+ *          The number of segments is doubled until the requested
+ *          tolerance is met at all sample points (or 'maxSegments' is
+ *          reached; see max_error() and within_tolerance()).
+ *
+ *          Evaluation: segment index = (x - lo) * scale (no search),
+ *          followed by a Horner scheme of Degree multiply-adds.
+ *
+ *          Approximations of interpolating_maps treat keys outside of
+ *          the node key range like the map does: the map's interpolator
+ *          and extrapolation policy are applied to copies of the two
+ *          boundary segments. Approximations of other callables clamp
+ *          keys to [lo,hi].
+ *
+ * @tparam KeyT     domain value type (arithmetic)
+ * @tparam MappedT  co-domain value type (floating point)
+ * @tparam Degree   polynomial degree per segment
+ *
+ *****************************************************************************/
+template<class KeyT, class MappedT, int Degree = 5>
+class polynomial_approximation
+{
+    static_assert(std::is_arithmetic<KeyT>::value,
+                  "key type must be arithmetic");
+    static_assert(std::is_floating_point<MappedT>::value,
+                  "mapped type must be a floating point type");
+    static_assert(Degree >= 0, "degree must be non-negative");
+
+    using coeffs_t_ = std::array<double,Degree+1>;
+
+public:
+    //---------------------------------------------------------------
+    // TYPES
+    //---------------------------------------------------------------
+    using key_type    = KeyT;
+    using mapped_type = MappedT;
+    using size_type   = std::size_t;
+
+    static constexpr int degree = Degree;
+
+
+    //---------------------------------------------------------------
+    // CONSTRUCTION
+    //---------------------------------------------------------------
+    /**
+     * @brief approximates a callable f(key) on [lo,hi]
+     *
+     * @param samplesPerSegment  number of equidistant error sample points
+     *                           per segment
+     */
+    template<class Function>
+    polynomial_approximation(const Function& f, key_type lo, key_type hi,
+                             const tolerance& tol,
+                             size_type maxSegments = 4096,
+                             size_type samplesPerSegment = 8 * (Degree + 1))
+    :
+        lo_(double(lo)), hi_(double(hi)), scale_(0), err_(0), ok_(false),
+        coeffs_{}
+    {
+        const key_type* none = nullptr;
+        compile(f, tol, maxSegments, samplesPerSegment, none, none);
+    }
+    //-----------------------------------------------------
+    /**
+     * @brief approximates an interpolating_map within its node key range;
+     *        the error is also sampled at all node keys
+     */
+    template<class I, class C, class A, class P>
+    polynomial_approximation(
+        const interpolating_map<KeyT,MappedT,I,C,A,P>& m,
+        const tolerance& tol,
+        size_type maxSegments = 4096,
+        size_type samplesPerSegment = 8 * (Degree + 1))
+    :
+        lo_(m.empty() ? 0.0 : double(m.begin()->first)),
+        hi_(m.empty() ? 0.0 : double(std::prev(m.end())->first)),
+        scale_(0), err_(0), ok_(false),
+        coeffs_{}
+    {
+        compile([&](key_type x) { return m(x); }, tol,
+                maxSegments, samplesPerSegment,
+                key_iterator<decltype(m.begin())>{m.begin()},
+                key_iterator<decltype(m.begin())>{m.end()});
+
+        extrapolate_like(m);
+    }
+
+
+    //---------------------------------------------------------------
+    // EVALUATION
+    //---------------------------------------------------------------
+    mapped_type
+    operator () (const key_type& x) const {
+        //negated => NaN is handled like the source map does
+        if(outside_ && !(double(x) >= lo_ && double(x) <= hi_)) {
+            return outside_(x);
+        }
+
+        const double u = (double(x) - lo_) * scale_;
+        const double maxu = double(coeffs_.size());
+        const double uc = u > 0 ? (u < maxu ? u : maxu) : 0.0;
+
+        auto i = size_type(uc);
+        i = i < coeffs_.size() ? i : coeffs_.size() - 1;
+
+        return mapped_type(horner(coeffs_[i], 2.0 * (uc - double(i)) - 1.0));
+    }
+
+    //-----------------------------------------------------
+    /**
+     * @brief batch evaluation: writes the values for all keys
+     *        in [first,last) to out
+     */
+    template<class InputIterator, class OutputIterator>
+    OutputIterator
+    evaluate(InputIterator first, InputIterator last, OutputIterator out) const
+    {
+        for(; first != last; ++first, ++out) {
+            *out = (*this)(*first);
+        }
+        return out;
+    }
+
+
+    //---------------------------------------------------------------
+    // PROPERTIES
+    //---------------------------------------------------------------
+    key_type domain_min() const noexcept { return key_type(lo_); }
+    key_type domain_max() const noexcept { return key_type(hi_); }
+
+    size_type segments() const noexcept { return coeffs_.size(); }
+
+    ///@brief maximum absolute error at all sample points
+    double max_error() const noexcept { return err_; }
+
+    ///@brief true, if the tolerance was met at all sample points
+    bool within_tolerance() const noexcept { return ok_; }
+
+    //-----------------------------------------------------
+    ///@brief bytes occupied by the segment coefficients
+    size_type
+    memory_usage() const noexcept {
+        return coeffs_.capacity() * sizeof(coeffs_t_);
+    }
+
+
+private:
+    //---------------------------------------------------------------
+    template<class Iterator>
+    struct key_iterator {
+        Iterator it;
+        bool operator != (const key_iterator& o) const { return it != o.it; }
+        key_iterator& operator ++ () { ++it; return *this; }
+        key_type operator * () const { return it->first; }
+    };
+
+
+    //---------------------------------------------------------------
+    /// keeps the boundary segments of m for keys outside of [lo,hi]
+    template<class I, class C, class A, class P>
+    void extrapolate_like(const interpolating_map<KeyT,MappedT,I,C,A,P>& m)
+    {
+        using node_t = std::pair<key_type,mapped_type>;
+
+        const auto n = std::min(m.size(), size_type(2));
+        std::array<node_t,2> below {};
+        std::array<node_t,2> above {};
+        std::copy(m.begin(), std::next(m.begin(), n), below.begin());
+        std::copy(std::prev(m.end(), n), m.end(), above.begin());
+
+        const double lo = lo_;
+        outside_ = [=, ipl = m.interpolator()](const key_type& x) {
+            const auto& b = double(x) < lo ? below : above;
+            return mapped_type(ipl(b.begin(), b.begin() + n, x));
+        };
+    }
+
+
+    //---------------------------------------------------------------
+    static double
+    horner(const coeffs_t_& c, double t) noexcept {
+        double v = c[Degree];
+        for(int k = Degree - 1; k >= 0; --k) v = v * t + c[k];
+        return v;
+    }
+
+    //---------------------------------------------------------------
+    double
+    key_at(size_type segment, double t) const noexcept {
+        const double w = (hi_ - lo_) / double(coeffs_.size());
+        return lo_ + w * (double(segment) + 0.5 * (t + 1.0));
+    }
+
+
+    //---------------------------------------------------------------
+    template<class Function, class KeyIterator>
+    void compile(const Function& f, const tolerance& tol,
+                 size_type maxSegments, size_type samplesPerSegment,
+                 KeyIterator kfirst, KeyIterator klast)
+    {
+        if(maxSegments < 1) maxSegments = 1;
+        if(!(lo_ < hi_)) maxSegments = 1;
+
+        for(size_type n = 1; ; n *= 2) {
+            if(n > maxSegments) n = maxSegments;
+
+            coeffs_.assign(n, coeffs_t_{});
+            scale_ = lo_ < hi_ ? double(n) / (hi_ - lo_) : 0.0;
+
+            for(size_type s = 0; s < n; ++s) fit(f, s);
+
+            measure(f, tol, samplesPerSegment, kfirst, klast);
+
+            if(ok_ || n >= maxSegments) break;
+        }
+        coeffs_.shrink_to_fit();
+    }
+
+
+    //---------------------------------------------------------------
+    /// Chebyshev interpolation of f on one segment => monomials in t
+    template<class Function>
+    void fit(const Function& f, size_type segment)
+    {
+        using std::cos;
+
+        constexpr int n = Degree + 1;
+        const double pi = 3.14159265358979323846;
+
+        std::array<double,n> fk;
+        std::array<double,n> tk;
+        for(int k = 0; k < n; ++k) {
+            tk[k] = cos(pi * (k + 0.5) / n);
+            fk[k] = double(f(key_type(key_at(segment, tk[k]))));
+        }
+
+        //Chebyshev coefficients
+        std::array<double,n> cheb;
+        for(int j = 0; j < n; ++j) {
+            double s = 0;
+            for(int k = 0; k < n; ++k) {
+                s += fk[k] * cos(pi * j * (k + 0.5) / n);
+            }
+            cheb[j] = (j == 0 ? 1.0 : 2.0) * s / n;
+        }
+
+        //sum_j cheb_j T_j(t) => monomial coefficients;
+        //T_{j+1} = 2t T_j - T_{j-1}
+        coeffs_t_ tm1{}; //T_{j-1}
+        coeffs_t_ tj{};  //T_j
+        tj[0] = 1;
+        auto& c = coeffs_[segment];
+        c = coeffs_t_{};
+        for(int j = 0; j < n; ++j) {
+            for(int k = 0; k < n; ++k) c[k] += cheb[j] * tj[k];
+
+            //T_1 = t T_0
+            const double a = j == 0 ? 1.0 : 2.0;
+            coeffs_t_ next{};
+            for(int k = 0; k + 1 < n; ++k) next[k+1] += a * tj[k];
+            for(int k = 0; k < n; ++k) next[k] -= tm1[k];
+            tm1 = tj;
+            tj = next;
+        }
+    }
+
+
+    //---------------------------------------------------------------
+    template<class Function, class KeyIterator>
+    void measure(const Function& f, const tolerance& tol,
+                 size_type samplesPerSegment,
+                 KeyIterator kfirst, KeyIterator klast)
+    {
+        using std::abs;
+
+        err_ = 0;
+        ok_ = true;
+
+        const auto check = [&](key_type x) {
+            const double y = double(f(x));
+            const double e = abs(double((*this)(x)) - y);
+            err_ = std::max(err_, e);
+            //negated => NaN fails
+            if(!(e <= tol(y))) ok_ = false;
+        };
+
+        const size_type m = std::max(samplesPerSegment, size_type(2));
+        for(size_type s = 0; s < coeffs_.size(); ++s) {
+            for(size_type i = 0; i < m; ++i) {
+                check(key_type(key_at(s, 2.0 * double(i) / double(m-1) - 1.0)));
+            }
+        }
+        for(; kfirst != klast; ++kfirst) check(*kfirst);
+    }
+
+
+    //---------------------------------------------------------------
+    double lo_;
+    double hi_;
+    double scale_;
+    double err_;
+    bool ok_;
+    std::vector<coeffs_t_> coeffs_;
+    /// evaluation outside of [lo,hi]; empty => clamping
+    std::function<mapped_type(const key_type&)> outside_;
+};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief compiles an interpolating_map into a piece-wise polynomial
+ *        approximation of degree 'Degree' within tolerance 'tol'
+ *
+ *****************************************************************************/
+template<int Degree = 5, class K, class T, class I, class C, class A, class P>
+inline polynomial_approximation<K,T,Degree>
+approximate(const interpolating_map<K,T,I,C,A,P>& m, const tolerance& tol,
+            std::size_t maxSegments = 4096)
+{
+    return polynomial_approximation<K,T,Degree>{m, tol, maxSegments};
+}
+
+
+} //namespace am
+
+
+#endif
@@ -0,0 +1,196 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_QUANTIZATION_H_
+#define AMLIB_QUANTIZATION_H_
+
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+
+namespace am {
+namespace quantization {
+
+
+/*************************************************************************//***
+ *
+ * @brief float -> IEEE 754 binary16 (round to nearest even)
+ *
+ *****************************************************************************/
+inline std::uint16_t
+float_to_half(float f) noexcept
+{
+    std::uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+
+    const std::uint32_t sign = (x >> 16) & 0x8000u;
+    const std::uint32_t absx = x & 0x7fffffffu;
+
+    //NaN / Inf
+    if(absx >= 0x7f800000u) {
+        const std::uint32_t nan = (absx > 0x7f800000u) ? 0x200u : 0u;
+        return std::uint16_t(sign | 0x7c00u | nan);
+    }
+    //overflow => Inf
+    if(absx >= 0x477ff000u) {
+        return std::uint16_t(sign | 0x7c00u);
+    }
+    //normal half
+    if(absx >= 0x38800000u) {
+        const std::uint32_t mant = absx & 0x7fffffu;
+        std::uint32_t h = ((absx >> 23) - 112u) << 10 | (mant >> 13);
+        const std::uint32_t rest = mant & 0x1fffu;
+        if(rest > 0x1000u || (rest == 0x1000u && (h & 1u))) ++h;
+        return std::uint16_t(sign | h);
+    }
+    //subnormal half or zero
+    if(absx < 0x33000000u) return std::uint16_t(sign);
+
+    const std::uint32_t e = absx >> 23;
+    const std::uint32_t mant = (absx & 0x7fffffu) | 0x800000u;
+    const std::uint32_t shift = 126u - e;
+    std::uint32_t h = mant >> shift;
+    const std::uint32_t rest = mant & ((1u << shift) - 1u);
+    const std::uint32_t half = 1u << (shift - 1u);
+    if(rest > half || (rest == half && (h & 1u))) ++h;
+    return std::uint16_t(sign | h);
+}
+
+
+
+/*************************************************************************//***
+ *
+ * @brief IEEE 754 binary16 -> float (exact)
+ *
+ *****************************************************************************/
+inline float
+half_to_float(std::uint16_t h) noexcept
+{
+    const std::uint32_t sign = std::uint32_t(h & 0x8000u) << 16;
+    std::uint32_t e = (h >> 10) & 0x1fu;
+    std::uint32_t mant = h & 0x3ffu;
+
+    std::uint32_t x = 0;
+    if(e == 0x1fu) {
+        x = sign | 0x7f800000u | (mant << 13);
+    }
+    else if(e != 0) {
+        x = sign | ((e + 112u) << 23) | (mant << 13);
+    }
+    else if(mant != 0) {
+        //subnormal => normalize
+        e = 113u;
+        while(!(mant & 0x400u)) { mant <<= 1; --e; }
+        x = sign | (e << 23) | ((mant & 0x3ffu) << 13);
+    }
+    else {
+        x = sign;
+    }
+
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief value codec: IEEE 754 binary16;
+ *        relative error <= 2^-11 within the normal half range
+ *
+ *****************************************************************************/
+struct half
+{
+    using code_type = std::uint16_t;
+
+    struct block_params {};
+
+    static block_params
+    fit(double, double, bool) noexcept { return {}; }
+
+    static code_type
+    encode(double v, const block_params&) noexcept {
+        return float_to_half(float(v));
+    }
+
+    static double
+    decode(code_type c, const block_params&) noexcept {
+        return double(half_to_float(c));
+    }
+};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief frame-of-reference fixed point codec:
+ *        v = base + code * scale with one {base,scale} per block;
+ *        absolute error <= scale/2; exact for integer-valued data whose
+ *        range within a block fits into the code type
+ *
+ * @tparam UInt  unsigned integer code type
+ *
+ *****************************************************************************/
+template<class UInt = std::uint16_t>
+struct fixed
+{
+    static_assert(std::is_unsigned<UInt>::value,
+                  "code type must be an unsigned integer type");
+
+    using code_type = UInt;
+
+    struct block_params {
+        double base;
+        double scale;
+    };
+
+    static constexpr double
+    max_code() noexcept {
+        return double(std::numeric_limits<code_type>::max());
+    }
+
+    /**
+     * @param lo          smallest value in block
+     * @param hi          largest value in block
+     * @param integral    true, if all values are integers
+     */
+    static block_params
+    fit(double lo, double hi, bool integral) noexcept {
+        const double range = hi - lo;
+        if(integral && range <= max_code()) return {lo, 1.0};
+        return {lo, range > 0 ? range / max_code() : 1.0};
+    }
+
+    static code_type
+    encode(double v, const block_params& p) noexcept {
+        using std::floor;
+        const double c = floor((v - p.base) / p.scale + 0.5);
+        return code_type(c < 0 ? 0 : (c > max_code() ? max_code() : c));
+    }
+
+    static double
+    decode(code_type c, const block_params& p) noexcept {
+        return p.base + double(c) * p.scale;
+    }
+};
+
+
+} //namespace quantization
+} //namespace am
+
+
+#endif
@@ -0,0 +1,514 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_SAMPLING_H_
+#define AMLIB_SAMPLING_H_
+
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#if __cplusplus > 201703L && defined(__has_include)
+#  if __has_include(<ranges>)
+#    include <ranges>
+#    define AMLIB_HAS_RANGES
+#  endif
+#endif
+
+#include "instrumentation.h"
+#include "search.h"
+
+
+namespace am {
+
+
+/*************************************************************************//***
+ *
+ * @brief evaluates an interpolator over a node range and remembers the
+ *        last segment; ascending query keys cost amortized O(1),
+ *        other keys fall back to a binary search
+ *
+ * @details Only the nodes from the last node with a key smaller than x
+ *          up to the first node with a key greater than x (at least 2) are
+ *          handed to the interpolator, so this requires an interpolator
+ *          whose value only depends on the nodes that bound x and on whether
+ *          x is left/right of all nodes
+ *          (true for all interpolators in interpolators.h).
+ *
+ * @tparam Probe  instrumentation policy; receives cursor_hit() for each
+ *                query that didn't need a binary search
+ *
+ *****************************************************************************/
+template<class Interpolator, class Iterator,
+         class Probe = instrumentation::none>
+class segment_cursor
+{
+public:
+    using size_type = std::size_t;
+
+
+    //---------------------------------------------------------------
+    segment_cursor(): ipl_(nullptr), first_{}, n_(0), next_(0) {}
+
+    //-----------------------------------------------------
+    segment_cursor(const Interpolator& ipl, Iterator first, Iterator last):
+        ipl_(&ipl), first_(first), n_(size_type(std::distance(first,last))),
+        next_(0)
+    {}
+
+
+    //---------------------------------------------------------------
+    template<class Key>
+    auto operator () (const Key& x) {
+        if(n_ < 2) return (*ipl_)(first_, first_ + n_, x);
+
+        const auto w = window(x);
+        return (*ipl_)(first_ + w.first, first_ + w.second, x);
+    }
+
+
+    //---------------------------------------------------------------
+    /**
+     * @brief index range [first,second) of the nodes that have to be handed
+     *        to the interpolator for key x
+     * @pre   node range has at least 2 nodes
+     */
+    template<class Key>
+    std::pair<size_type,size_type>
+    window(const Key& x) {
+        seek(x);
+
+        //nodes with keys equal to x
+        size_type up = next_;
+        while(up < n_ && !(x < first_[up].first)) ++up;
+
+        size_type lo = next_ > 0 ? next_ - 1 : 0;
+        size_type hi = up < n_ ? up + 1 : n_;
+        if(hi - lo < 2) {
+            if(lo == 0) hi = 2; else lo = hi - 2;
+        }
+        return {lo, hi};
+    }
+
+    //-----------------------------------------------------
+    size_type size() const noexcept { return n_; }
+
+
+private:
+    //---------------------------------------------------------------
+    /// next_ = index of first node with key not smaller than x
+    template<class Key>
+    void seek(const Key& x)
+    {
+        //at most this many linear steps before switching to binary search
+        constexpr size_type max_steps = 8;
+
+        if(next_ > 0 && !(first_[next_-1].first < x)) {
+            //moved backwards
+            next_ = search(0, next_, x);
+            return;
+        }
+        for(size_type s = 0; next_ < n_ && first_[next_].first < x; ++s) {
+            if(s == max_steps) {
+                next_ = search(next_, n_, x);
+                return;
+            }
+            ++next_;
+        }
+        Probe::cursor_hit();
+    }
+
+    //---------------------------------------------------------------
+    template<class Key>
+    size_type search(size_type lo, size_type hi, const Key& x) const {
+        Probe::search();
+        const auto p = search::partition_point_n(first_ + lo, hi - lo,
+            [&](const auto& node) {
+                Probe::comparison();
+                return node.first < x;
+            });
+        return size_type(std::distance(first_, p));
+    }
+
+    //---------------------------------------------------------------
+    const Interpolator* ipl_;
+    Iterator first_;
+    size_type n_;
+    size_type next_;
+};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief segment_cursor for an interpolating_map
+ *
+ *****************************************************************************/
+template<class Map>
+class map_cursor :
+    private segment_cursor<typename Map::interpolator_type,
+                           typename Map::const_iterator,
+                           typename Map::instrumentation_type>
+{
+    using base_t_ = segment_cursor<typename Map::interpolator_type,
+                                   typename Map::const_iterator,
+                                   typename Map::instrumentation_type>;
+public:
+    using key_type = typename Map::key_type;
+    using mapped_type = typename Map::mapped_type;
+
+    map_cursor() = default;
+
+    explicit
+    map_cursor(const Map& m):
+        base_t_(m.interpolator(), m.begin(), m.end())
+    {}
+
+    mapped_type operator () (const key_type& x) {
+        Map::instrumentation_type::evaluation();
+        return mapped_type(base_t_::operator()(x));
+    }
+};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief lazy view of the values of a map at the keys of [first,last)
+ *
+ * @details Values are computed on dereferencing through a map_cursor
+ *          (=> ascending keys need no search); nothing is allocated.
+ *          The map and the key range must outlive the view.
+ *
+ * @tparam Sentinel  type of the end of the key range
+ *                   (may differ from Iterator)
+ *
+ *****************************************************************************/
+template<class Map, class Iterator, class Sentinel = Iterator>
+class sample_view
+#ifdef AMLIB_HAS_RANGES
+    : public std::ranges::view_base
+#endif
+{
+public:
+    //---------------------------------------------------------------
+    class iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = typename Map::mapped_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type;
+        using pointer = void;
+
+        iterator() = default;
+
+        iterator(const Map& m, Iterator it): cursor_(m), it_(std::move(it)) {}
+
+        value_type operator * () const { return cursor_(*it_); }
+
+        iterator& operator ++ () { ++it_; return *this; }
+        iterator  operator ++ (int) { auto i = *this; ++it_; return i; }
+
+        friend bool operator == (const iterator& a, const iterator& b) {
+            return a.it_ == b.it_;
+        }
+        friend bool operator != (const iterator& a, const iterator& b) {
+            return !(a == b);
+        }
+
+        /// current key position
+        const Iterator& base() const noexcept { return it_; }
+
+    private:
+        mutable map_cursor<Map> cursor_;
+        Iterator it_;
+    };
+
+    //-----------------------------------------------------
+    /// end of a key range whose end type differs from its iterator type
+    class sentinel
+    {
+    public:
+        sentinel() = default;
+
+        explicit
+        sentinel(Sentinel s): s_(std::move(s)) {}
+
+        friend bool operator == (const iterator& i, const sentinel& s) {
+            return i.base() == s.s_;
+        }
+        friend bool operator == (const sentinel& s, const iterator& i) {
+            return i == s;
+        }
+        friend bool operator != (const iterator& i, const sentinel& s) {
+            return !(i == s);
+        }
+        friend bool operator != (const sentinel& s, const iterator& i) {
+            return !(i == s);
+        }
+
+    private:
+        Sentinel s_;
+    };
+
+    using sentinel_type = std::conditional_t<
+        std::is_same<Iterator,Sentinel>::value, iterator, sentinel>;
+
+
+    //---------------------------------------------------------------
+    sample_view() = default;
+
+    sample_view(const Map& m, Iterator first, Sentinel last):
+        map_(&m), first_(std::move(first)), last_(std::move(last))
+    {}
+
+    //---------------------------------------------------------------
+    iterator begin() const { return iterator{*map_, first_}; }
+    sentinel_type end() const { return make_end(std::is_same<Iterator,Sentinel>{}); }
+
+private:
+    iterator make_end(std::true_type) const  { return iterator{*map_, last_}; }
+    sentinel make_end(std::false_type) const { return sentinel{last_}; }
+
+    const Map* map_ = nullptr;
+    Iterator first_;
+    Sentinel last_;
+};
+
+
+
+#ifdef AMLIB_HAS_RANGES
+/*************************************************************************//***
+ *
+ * @brief lazy view of the values of a map at the keys of a view;
+ *        holds the key view by value (see operator | (keys, sampled(map)))
+ *
+ * @details Key views without const iteration (e.g. filter_view) can only
+ *          be sampled through a non-const sampled_keys_view.
+ *          The map must outlive the view.
+ *
+ *****************************************************************************/
+template<class Map, std::ranges::view Keys>
+class sampled_keys_view :
+    public std::ranges::view_interface<sampled_keys_view<Map,Keys>>
+{
+    template<class K>
+    using view_t_ = sample_view<Map, std::ranges::iterator_t<K>,
+                                std::ranges::sentinel_t<K>>;
+
+public:
+    //---------------------------------------------------------------
+    sampled_keys_view() = default;
+
+    sampled_keys_view(const Map& m, Keys keys):
+        map_(&m), keys_(std::move(keys))
+    {}
+
+    //---------------------------------------------------------------
+    auto begin() {
+        return typename view_t_<Keys>::iterator{*map_, std::ranges::begin(keys_)};
+    }
+    auto end() {
+        return end_of<Keys>(keys_);
+    }
+
+    //-----------------------------------------------------
+    auto begin() const requires std::ranges::range<const Keys> {
+        return typename view_t_<const Keys>::iterator{*map_, std::ranges::begin(keys_)};
+    }
+    auto end() const requires std::ranges::range<const Keys> {
+        return end_of<const Keys>(keys_);
+    }
+
+    //-----------------------------------------------------
+    auto size() requires std::ranges::sized_range<Keys> {
+        return std::ranges::size(keys_);
+    }
+    auto size() const requires std::ranges::sized_range<const Keys> {
+        return std::ranges::size(keys_);
+    }
+
+private:
+    //---------------------------------------------------------------
+    template<class K>
+    auto end_of(K& keys) const {
+        using view_t = view_t_<K>;
+        if constexpr(std::ranges::common_range<K>) {
+            return typename view_t::iterator{*map_, std::ranges::end(keys)};
+        } else {
+            return typename view_t::sentinel{std::ranges::end(keys)};
+        }
+    }
+
+    //---------------------------------------------------------------
+    const Map* map_ = nullptr;
+    Keys keys_;
+};
+#endif
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief lazy view of the values of a map at n equidistant keys in [a,b]
+ *        (a and b included)
+ *
+ *****************************************************************************/
+template<class Map>
+class uniform_sample_view
+#ifdef AMLIB_HAS_RANGES
+    : public std::ranges::view_base
+#endif
+{
+public:
+    using key_type = typename Map::key_type;
+    using size_type = std::size_t;
+
+    //---------------------------------------------------------------
+    class iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = typename Map::mapped_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type;
+        using pointer = void;
+
+        iterator() = default;
+
+        iterator(const uniform_sample_view& v, size_type i):
+            cursor_(*v.map_), a_(v.a_), b_(v.b_), n_(v.n_), i_(i)
+        {}
+
+        value_type operator * () const {
+            return cursor_(uniform_sample_view::key(a_, b_, n_, i_));
+        }
+
+        iterator& operator ++ () { ++i_; return *this; }
+        iterator  operator ++ (int) { auto i = *this; ++i_; return i; }
+
+        friend bool operator == (const iterator& a, const iterator& b) {
+            return a.i_ == b.i_;
+        }
+        friend bool operator != (const iterator& a, const iterator& b) {
+            return !(a == b);
+        }
+
+    private:
+        mutable map_cursor<Map> cursor_;
+        key_type a_ = key_type{};
+        key_type b_ = key_type{};
+        size_type n_ = 0;
+        size_type i_ = 0;
+    };
+
+
+    //---------------------------------------------------------------
+    uniform_sample_view() = default;
+
+    uniform_sample_view(const Map& m, key_type a, key_type b, size_type n):
+        map_(&m), a_(a), b_(b), n_(n)
+    {}
+
+    //---------------------------------------------------------------
+    iterator begin() const { return iterator{*this, 0}; }
+    iterator end() const   { return iterator{*this, n_}; }
+
+    size_type size() const noexcept { return n_; }
+    bool empty() const noexcept { return n_ == 0; }
+
+    //---------------------------------------------------------------
+    ///@brief i-th sample key
+    key_type key(size_type i) const {
+        return key(a_, b_, n_, i);
+    }
+
+private:
+    //---------------------------------------------------------------
+    static key_type
+    key(const key_type& a, const key_type& b, size_type n, size_type i) {
+        if(n < 2) return a;
+        if(i + 1 == n) return b;
+        return key_type(a + (b - a) * (double(i) / double(n - 1)));
+    }
+
+    //---------------------------------------------------------------
+    const Map* map_ = nullptr;
+    key_type a_ = key_type{};
+    key_type b_ = key_type{};
+    size_type n_ = 0;
+};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief range adaptor: keys | sampled(map)  =>  sample_view
+ *
+ *****************************************************************************/
+template<class Map>
+struct sampled_adaptor
+{
+    const Map* map;
+};
+
+//-------------------------------------------------------------------
+template<class Map>
+inline sampled_adaptor<Map>
+sampled(const Map& m) noexcept
+{
+    return sampled_adaptor<Map>{&m};
+}
+
+#ifdef AMLIB_HAS_RANGES
+//-------------------------------------------------------------------
+/**
+ * @brief views (e.g. keys | std::views::filter(p)) are held by value,
+ *        containers by reference (lvalues) or moved into the view (rvalues)
+ */
+template<std::ranges::viewable_range Range, class Map>
+inline auto
+operator | (Range&& keys, sampled_adaptor<Map> a)
+{
+    return sampled_keys_view<Map,std::views::all_t<Range>>{
+        *a.map, std::views::all(std::forward<Range>(keys))};
+}
+
+#else
+//-------------------------------------------------------------------
+template<class Range, class Map>
+inline auto
+operator | (const Range& keys, sampled_adaptor<Map> a)
+{
+    using std::begin;
+    using std::end;
+    return sample_view<Map,decltype(begin(keys)),decltype(end(keys))>{
+        *a.map, begin(keys), end(keys)};
+}
+
+//-------------------------------------------------------------------
+///@brief the view would refer to a destroyed range
+template<class Range, class Map>
+void operator | (const Range&&, sampled_adaptor<Map>) = delete;
+#endif
+
+
+} //namespace am
+
+
+#endif
@@ -0,0 +1,356 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_SEARCH_H_
+#define AMLIB_SEARCH_H_
+
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+
+namespace am {
+namespace search {
+
+
+/*****************************************************************************
+ *
+ * BRANCHLESS SEARCH KERNELS
+ *
+ * All kernels return the partition point of [first,first+n) with respect
+ * to 'pred', i.e. the first element for which pred is false
+ * (pred must be true for a prefix and false for the rest of the range).
+ *   lower_bound(x):  pred(e) = e.first < x
+ *   upper_bound(x):  pred(e) = !(x < e.first)
+ * => identical results to the std:: algorithms, also for duplicate keys.
+ *
+ * The number of evaluations of 'pred' only depends on n, not on the
+ * result, so there are no data-dependent branches that can be mispredicted.
+ *
+ *****************************************************************************/
+
+
+/// ranges up to this size are scanned linearly
+constexpr std::size_t linear_scan_max = 4;
+
+/// ranges of at least this size prefetch both possible next probes
+constexpr std::size_t prefetch_min = std::size_t(1) << 14;
+
+
+#if defined(__GNUC__) || defined(__clang__)
+#  define AMLIB_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#  define AMLIB_PREFETCH(addr)
+#endif
+
+
+
+
+namespace detail {
+
+//-------------------------------------------------------------------
+constexpr unsigned
+floor_log2(std::size_t n) noexcept {
+    return n > 1 ? 1 + floor_log2(n / 2) : 0;
+}
+
+//-------------------------------------------------------------------
+/// fully unrolled halving steps Step, Step/2, ..., 1
+template<std::size_t Step>
+struct halving_steps
+{
+    template<class RandomAccessIter, class Pred>
+    static RandomAccessIter
+    apply(RandomAccessIter i, Pred& pred) {
+        i += pred(i[Step-1]) ? Step : 0;
+        return halving_steps<Step/2>::apply(i, pred);
+    }
+};
+
+template<>
+struct halving_steps<0>
+{
+    template<class RandomAccessIter, class Pred>
+    static RandomAccessIter
+    apply(RandomAccessIter i, Pred&) { return i; }
+};
+
+} // namespace detail
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief counts the elements for which pred is true; no early exit
+ *        => vectorizable for simple predicates over contiguous keys
+ *
+ *****************************************************************************/
+template<class RandomAccessIter, class Pred>
+inline RandomAccessIter
+linear_partition_point(RandomAccessIter first, std::size_t n, Pred pred)
+{
+    std::size_t k = 0;
+    for(std::size_t i = 0; i < n; ++i) {
+        k += pred(first[i]) ? 1 : 0;
+    }
+    return first + k;
+}
+
+
+
+/*************************************************************************//***
+ *
+ * @brief binary search with conditional moves instead of branches;
+ *        ceil(log2(n)) + 1 probes for any n > 0
+ *
+ * @details Without branches the CPU can't speculate on the next probe,
+ *          so for ranges that exceed the caches both candidates
+ *          of the next step are prefetched (Prefetch = true).
+ *
+ *****************************************************************************/
+template<bool Prefetch = false, class RandomAccessIter, class Pred>
+inline RandomAccessIter
+halving_partition_point(RandomAccessIter first, std::size_t n, Pred pred)
+{
+    if(n == 0) return first;
+    while(n > 1) {
+        const auto half = n / 2;
+        if(Prefetch) {
+            const auto next = (n - half) / 2;
+            AMLIB_PREFETCH(std::addressof(first[next]));
+            AMLIB_PREFETCH(std::addressof(first[half + next]));
+        }
+        first += pred(first[half]) ? half : 0;
+        n -= half;
+    }
+    return first + (pred(*first) ? 1 : 0);
+}
+
+
+
+/*************************************************************************//***
+ *
+ * @brief fully unrolled branchless search over a compile-time size N
+ *
+ * @details The first probe at 2^K-1 (2^K <= N < 2^(K+1)) reduces
+ *          the range to a window of exactly 2^K+1 possible results;
+ *          the remaining K+1 probes use compile-time offsets.
+ *
+ *****************************************************************************/
+template<std::size_t N, class RandomAccessIter, class Pred>
+inline RandomAccessIter
+partition_point_fixed(RandomAccessIter first, Pred pred)
+{
+    constexpr std::size_t m = std::size_t(1) << detail::floor_log2(N);
+
+    if(N == 0) return first;
+    if(N <= linear_scan_max) return linear_partition_point(first, N, pred);
+
+    first += pred(first[m-1]) ? N - m : 0;
+    first = detail::halving_steps<m/2>::apply(first, pred);
+    return first + (pred(*first) ? 1 : 0);
+}
+
+
+
+namespace detail {
+
+template<class Iter, class Pred>
+inline Iter
+partition_point_n(Iter first, std::size_t n, Pred& pred,
+                  std::random_access_iterator_tag)
+{
+    if(n <= linear_scan_max) return linear_partition_point(first, n, pred);
+    if(n < prefetch_min) return halving_partition_point(first, n, pred);
+    return halving_partition_point<true>(first, n, pred);
+}
+
+template<class Iter, class Pred>
+inline Iter
+partition_point_n(Iter first, std::size_t n, Pred& pred,
+                  std::forward_iterator_tag)
+{
+    return std::partition_point(first, std::next(first, n), pred);
+}
+
+} // namespace detail
+
+
+
+/*************************************************************************//***
+ *
+ * @brief partition point of [first,first+n); selects a kernel by
+ *        size class for random access iterators:
+ *          n <= linear_scan_max   linear counting scan
+ *          n <  prefetch_min      conditional-move halving
+ *          larger                 conditional-move halving with prefetching
+ *        std::partition_point for other iterators
+ *
+ *****************************************************************************/
+template<class ForwardIter, class Pred>
+inline ForwardIter
+partition_point_n(ForwardIter first, std::size_t n, Pred pred)
+{
+    return detail::partition_point_n(first, n, pred,
+        typename std::iterator_traits<ForwardIter>::iterator_category{});
+}
+
+//-----------------------------------------------------
+template<class ForwardIter, class Pred>
+inline ForwardIter
+partition_point(ForwardIter first, ForwardIter last, Pred pred)
+{
+    using std::distance;
+    return search::partition_point_n(first,
+        static_cast<std::size_t>(distance(first, last)), pred);
+}
+
+
+
+/*************************************************************************//***
+ *
+ * @brief partition points of [first,first+n) for many queries;
+ *        writes one iterator per query in [qfirst,qlast) to out
+ *
+ * @details Queries are searched in groups of Group independent searches
+ *          that run in lockstep: the halving steps only depend on n, so
+ *          all searches of a group probe at the same time. For ranges
+ *          beyond the caches the next probe candidates of all group
+ *          members are prefetched before any of them is compared, so up
+ *          to 2*Group memory accesses are in flight instead of 2.
+ *
+ * @param pred  pred(element, query): true, if element is before the
+ *              partition point of query
+ *
+ *****************************************************************************/
+constexpr std::size_t default_group_size = 16;
+
+
+namespace detail {
+
+template<std::size_t Group, bool Prefetch,
+         class Iter, class Query, class Pred>
+inline void
+partition_points_group(Iter first, std::size_t n, const Query* qs,
+                       std::size_t m, Iter* res, Pred& pred)
+{
+    for(std::size_t j = 0; j < m; ++j) res[j] = first;
+    if(n == 0) return;
+
+    while(n > 1) {
+        const auto half = n / 2;
+        if(Prefetch) {
+            const auto next = (n - half) / 2;
+            for(std::size_t j = 0; j < m; ++j) {
+                AMLIB_PREFETCH(std::addressof(res[j][next]));
+                AMLIB_PREFETCH(std::addressof(res[j][half + next]));
+            }
+        }
+        for(std::size_t j = 0; j < m; ++j) {
+            res[j] += pred(res[j][half], qs[j]) ? half : 0;
+        }
+        n -= half;
+    }
+    for(std::size_t j = 0; j < m; ++j) {
+        res[j] += pred(*res[j], qs[j]) ? 1 : 0;
+    }
+}
+
+//-------------------------------------------------------------------
+template<std::size_t Group, class Iter,
+         class InputIter, class OutputIter, class Pred>
+inline OutputIter
+partition_points(Iter first, std::size_t n,
+                 InputIter qfirst, InputIter qlast, OutputIter out,
+                 Pred& pred, std::random_access_iterator_tag)
+{
+    using query_t = std::decay_t<decltype(*qfirst)>;
+
+    query_t qs[Group];
+    Iter res[Group];
+
+    while(qfirst != qlast) {
+        std::size_t m = 0;
+        for(; m < Group && qfirst != qlast; ++m, ++qfirst) qs[m] = *qfirst;
+
+        if(n < prefetch_min) {
+            partition_points_group<Group,false>(first, n, qs, m, res, pred);
+        } else {
+            partition_points_group<Group,true>(first, n, qs, m, res, pred);
+        }
+        for(std::size_t j = 0; j < m; ++j, ++out) *out = res[j];
+    }
+    return out;
+}
+
+//-------------------------------------------------------------------
+template<std::size_t Group, class Iter,
+         class InputIter, class OutputIter, class Pred>
+inline OutputIter
+partition_points(Iter first, std::size_t n,
+                 InputIter qfirst, InputIter qlast, OutputIter out,
+                 Pred& pred, std::forward_iterator_tag)
+{
+    const auto last = std::next(first, n);
+    for(; qfirst != qlast; ++qfirst, ++out) {
+        const auto& q = *qfirst;
+        *out = std::partition_point(first, last,
+                   [&](const auto& e) { return pred(e, q); });
+    }
+    return out;
+}
+
+} // namespace detail
+
+
+template<std::size_t Group = default_group_size,
+         class ForwardIter, class InputIter, class OutputIter, class Pred>
+inline OutputIter
+partition_points(ForwardIter first, std::size_t n,
+                 InputIter qfirst, InputIter qlast, OutputIter out, Pred pred)
+{
+    static_assert(Group > 0, "group size must be positive");
+
+    return detail::partition_points<Group>(first, n, qfirst, qlast, out, pred,
+        typename std::iterator_traits<ForwardIter>::iterator_category{});
+}
+
+
+
+//-------------------------------------------------------------------
+/// first node with key not smaller than x
+template<class ForwardIter, class Key>
+inline ForwardIter
+lower_bound(ForwardIter first, ForwardIter last, const Key& x)
+{
+    return search::partition_point(first, last,
+        [&](const auto& node) { return node.first < x; });
+}
+
+//-------------------------------------------------------------------
+/// first node with key greater than x
+template<class ForwardIter, class Key>
+inline ForwardIter
+upper_bound(ForwardIter first, ForwardIter last, const Key& x)
+{
+    return search::partition_point(first, last,
+        [&](const auto& node) { return !(x < node.first); });
+}
+
+
+} //namespace search
+} //namespace am
+
+
+#endif
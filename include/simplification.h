@@ -0,0 +1,317 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_SIMPLIFICATION_H_
+#define AMLIB_SIMPLIFICATION_H_
+
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "interpolating_map.h"
+
+
+namespace am {
+
+
+/*************************************************************************//***
+ *
+ * @brief maximum allowed deviation of a simplified map from the original
+ *        at value y: max(absolute, relative * |y|)
+ *
+ *****************************************************************************/
+struct tolerance
+{
+    double absolute = 0;
+    double relative = 0;
+
+    constexpr tolerance() = default;
+
+    constexpr explicit
+    tolerance(double abs, double rel = 0): absolute{abs}, relative{rel} {}
+
+    template<class Value>
+    double operator () (const Value& y) const {
+        using std::abs;
+        return std::max(absolute, relative * abs(double(y)));
+    }
+};
+
+
+
+namespace detail {
+
+/*************************************************************************//***
+ *
+ * @brief greedy cone intersection for segment-linear interpolators;
+ *        keeps a subset of the original nodes
+ *
+ * @details For each anchor node the interval of admissible slopes is
+ *          narrowed down node by node; a node is dropped as long as the
+ *          line from the anchor to the following node stays within
+ *          the tolerance of all dropped nodes. O(1) per node.
+ *
+ *****************************************************************************/
+template<class Interpolator, class Key, class Value, class Sink>
+class segment_linear_simplifier
+{
+public:
+    //---------------------------------------------------------------
+    segment_linear_simplifier(const Interpolator& ipl,
+                              const tolerance& tol, Sink sink)
+    :
+        ipl_(ipl), tol_(tol), sink_(std::move(sink)),
+        hasAnchor_{false}, hasLast_{false},
+        anchor_{}, last_{}, anchorU_{0}, lo_{0}, hi_{0}
+    {}
+
+
+    //---------------------------------------------------------------
+    /// @pre keys must be passed in ascending order
+    void push(const Key& x, const Value& y)
+    {
+        if(!hasAnchor_) {
+            start({x,y});
+            sink_(x,y);
+            return;
+        }
+        //duplicate key = discontinuity => keep both nodes
+        if(!((hasLast_ ? last_.first : anchor_.first) < x)) {
+            if(hasLast_) sink_(last_.first, last_.second);
+            start({x,y});
+            sink_(x,y);
+            return;
+        }
+
+        const double u = double(interpolator::segment_coordinate(ipl_, x));
+        double du = u - anchorU_;
+        double dy = double(y) - double(anchor_.second);
+
+        if(hasLast_ && (dy < lo_ * du || dy > hi_ * du)) {
+            //segment anchor->(x,y) would violate tolerance of dropped nodes
+            sink_(last_.first, last_.second);
+            start(last_);
+            du = u - anchorU_;
+            dy = double(y) - double(anchor_.second);
+        }
+
+        const double t = tol_(y);
+        lo_ = std::max(lo_, (dy - t) / du);
+        hi_ = std::min(hi_, (dy + t) / du);
+
+        last_ = {x,y};
+        hasLast_ = true;
+    }
+
+    //---------------------------------------------------------------
+    ///@brief emits all pending nodes
+    void finish() {
+        if(hasLast_) sink_(last_.first, last_.second);
+        hasAnchor_ = false;
+        hasLast_ = false;
+    }
+
+
+private:
+    //---------------------------------------------------------------
+    void start(const std::pair<Key,Value>& anchor) {
+        anchor_ = anchor;
+        anchorU_ = double(interpolator::segment_coordinate(ipl_, anchor.first));
+        lo_ = -std::numeric_limits<double>::infinity();
+        hi_ =  std::numeric_limits<double>::infinity();
+        hasAnchor_ = true;
+        hasLast_ = false;
+    }
+
+    //---------------------------------------------------------------
+    Interpolator ipl_;
+    tolerance tol_;
+    Sink sink_;
+    bool hasAnchor_;
+    bool hasLast_;
+    std::pair<Key,Value> anchor_;
+    std::pair<Key,Value> last_;
+    double anchorU_;
+    double lo_;
+    double hi_;
+};
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief merges runs of nodes of a step function whose values can be
+ *        replaced by a single value within tolerance; O(1) per node
+ *
+ * @details The last node of the final run is kept as well, so the node
+ *          key range (and thus extrapolation) stays the same.
+ *
+ *****************************************************************************/
+template<class Key, class Value, class Sink>
+class piecewise_constant_simplifier
+{
+public:
+    //---------------------------------------------------------------
+    template<class Interpolator>
+    piecewise_constant_simplifier(const Interpolator&,
+                                  const tolerance& tol, Sink sink)
+    :
+        tol_(tol), sink_(std::move(sink)),
+        hasRun_{false}, key_{}, last_{}, value_{}, lo_{0}, hi_{0}
+    {}
+
+
+    //---------------------------------------------------------------
+    /// @pre keys must be passed in ascending order
+    void push(const Key& x, const Value& y)
+    {
+        const double t = tol_(y);
+        const double lo = double(y) - t;
+        const double hi = double(y) + t;
+
+        if(hasRun_) {
+            const double l = std::max(lo_, lo);
+            const double h = std::min(hi_, hi);
+            if(l <= h) {
+                lo_ = l;
+                hi_ = h;
+                last_ = x;
+                if(!(value_ < y) && !(y < value_)) return;
+                value_ = Value(0.5 * (lo_ + hi_));
+                return;
+            }
+            sink_(key_, value_);
+        }
+        hasRun_ = true;
+        key_ = x;
+        last_ = x;
+        value_ = y;
+        lo_ = lo;
+        hi_ = hi;
+    }
+
+    //---------------------------------------------------------------
+    ///@brief emits all pending nodes
+    void finish() {
+        if(hasRun_) {
+            sink_(key_, value_);
+            if(key_ < last_) sink_(last_, value_);
+        }
+        hasRun_ = false;
+    }
+
+
+private:
+    tolerance tol_;
+    Sink sink_;
+    bool hasRun_;
+    Key key_;
+    Key last_;
+    Value value_;
+    double lo_;
+    double hi_;
+};
+
+
+
+
+//-------------------------------------------------------------------
+template<class Interpolator, class Key, class Value, class Sink,
+         bool = interpolator::is_segment_linear<Interpolator>::value>
+struct simplifier_selector
+{
+    static_assert(interpolator::is_piecewise_constant<Interpolator>::value,
+        "simplification is only supported for piecewise constant and "
+        "segment-linear interpolators");
+
+    using type = piecewise_constant_simplifier<Key,Value,Sink>;
+};
+
+template<class Interpolator, class Key, class Value, class Sink>
+struct simplifier_selector<Interpolator,Key,Value,Sink,true>
+{
+    using type = segment_linear_simplifier<Interpolator,Key,Value,Sink>;
+};
+
+} //namespace detail
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief streaming node simplification stage:
+ *        push nodes in ascending key order, simplified nodes are passed to
+ *        sink(key,value) as soon as they are final; call finish() at the end
+ *
+ * @details The nodes emitted for a segment-linear interpolator are a subset
+ *          of the input nodes and the deviation from the input is within
+ *          tolerance at every input node (and thus everywhere within
+ *          the input node key range for an absolute tolerance).
+ *          For piecewise constant interpolation runs of nodes are merged
+ *          if their values can be replaced by a single value within
+ *          tolerance (equal runs with zero tolerance).
+ *
+ * @tparam Interpolator  interpolator of the nodes
+ * @tparam Sink          callable with signature (const Key&, const Value&)
+ *
+ *****************************************************************************/
+template<class Interpolator, class Key, class Value, class Sink>
+using simplifier =
+    typename detail::simplifier_selector<Interpolator,Key,Value,Sink>::type;
+
+
+//-------------------------------------------------------------------
+template<class Key, class Value, class Interpolator, class Sink>
+inline simplifier<Interpolator,Key,Value,Sink>
+make_simplifier(const Interpolator& ipl, const tolerance& tol, Sink sink)
+{
+    return simplifier<Interpolator,Key,Value,Sink>{ipl, tol, std::move(sink)};
+}
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief returns a map with (usually far) fewer nodes that deviates
+ *        at most by 'tol' from the input under the map's own interpolator
+ *        in O(n)
+ *
+ *****************************************************************************/
+template<class K, class T, class I, class C, class A, class P>
+interpolating_map<K,T,I,C,A,P>
+simplify(const interpolating_map<K,T,I,C,A,P>& in, const tolerance& tol)
+{
+    using map_t = interpolating_map<K,T,I,C,A,P>;
+
+    typename map_t::container_type nodes(in.get_allocator());
+
+    auto s = make_simplifier<K,T>(in.interpolator(), tol,
+        [&](const K& x, const T& y) { nodes.emplace_back(x,y); });
+
+    for(const auto& n : in) s.push(n.first, n.second);
+    s.finish();
+
+    nodes.shrink_to_fit();
+
+    return map_t{sorted_range, std::move(nodes), in.interpolator(),
+                 in.key_comp()};
+}
+
+
+} //namespace am
+
+
+#endif
@@ -0,0 +1,277 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_STATIC_TABLE_MAP_H_
+#define AMLIB_STATIC_TABLE_MAP_H_
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "interpolators.h"
+
+
+namespace am {
+
+
+namespace detail {
+
+/*************************************************************************//***
+ *
+ * @brief true, if static tables store precomputed per-segment slopes
+ *        for an interpolator (piecewise linear, computed in double)
+ *
+ *****************************************************************************/
+template<class Interpolator, class Key, class Value>
+struct has_table_slopes : std::false_type {};
+
+template<class E, class Key, class Value>
+struct has_table_slopes<
+    interpolator::basic_piecewise_linear<E,precision::promote<double>>,Key,Value>
+:
+    std::integral_constant<bool,
+        std::is_arithmetic<Key>::value && std::is_arithmetic<Value>::value &&
+        std::is_same<std::common_type_t<double,Key,Value>,double>::value>
+{};
+
+} //namespace detail
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief Read-only interpolation function over a fixed-size node table
+ *        that can be initialized at compile time (constexpr);
+ *        usually emitted by tools/make_table.
+ *
+ * @details The optional bucket index splits the key range [lo,hi] into
+ *          Buckets equally sized buckets:
+ *            bucket(x) = clamp(floor((x - lo) * bucket_scale), 0, Buckets-1)
+ *            index[b]  = first node with bucket(key) >= b;  index[Buckets] = N
+ *          A query only searches the nodes index[b]-1 ... index[b+1].
+ *
+ *          Tables for piecewise linear interpolation (computed in double)
+ *          also hold the slope of each segment:
+ *            slopes[i] = (value[i+1] - value[i]) / (key[i+1] - key[i])
+ *          (0 for segments with equal keys). They are evaluated without
+ *          division and can be used in constant expressions; results are
+ *          identical to the interpolator's.
+ *          Other interpolators are called on the searched node range.
+ *
+ * @tparam Key           domain value type
+ * @tparam Value         co-domain value type
+ * @tparam N             number of nodes
+ * @tparam Interpolator  function class that interpolates in-between nodes
+ * @tparam Buckets       number of index buckets (0: no index)
+ *
+ * @pre nodes must be sorted in ascending key order
+ *
+ *****************************************************************************/
+template<
+    class Key,
+    class Value,
+    std::size_t N,
+    class Interpolator,
+    std::size_t Buckets = 0
+>
+class static_table_map
+{
+    static_assert(N > 0, "table must contain at least one node");
+
+    using has_slopes_ = detail::has_table_slopes<Interpolator,Key,Value>;
+
+public:
+    //---------------------------------------------------------------
+    // TYPES
+    //---------------------------------------------------------------
+    using key_type     = Key;
+    using mapped_type  = Value;
+    using value_type   = std::pair<Key,Value>;
+    using size_type    = std::size_t;
+    using interpolator_type = Interpolator;
+    using const_iterator = typename std::array<value_type,N>::const_iterator;
+
+    static constexpr size_type bucket_count = Buckets;
+    static constexpr size_type slope_count = has_slopes_::value ? N-1 : 0;
+
+    using node_array  = std::array<value_type,N>;
+    using slope_array = std::array<double,slope_count>;
+    using index_array = std::array<std::uint32_t,(Buckets > 0 ? Buckets+1 : 0)>;
+
+
+    //---------------------------------------------------------------
+    // CONSTRUCTION
+    //---------------------------------------------------------------
+    template<size_type S = slope_count, size_type B = Buckets,
+             class = std::enable_if_t<S == 0 && B == 0>>
+    constexpr explicit
+    static_table_map(const node_array& nodes):
+        nodes_(nodes), slopes_{}, index_{}, bucketScale_{0}
+    {}
+    //-----------------------------------------------------
+    template<size_type S = slope_count, size_type B = Buckets,
+             class = std::enable_if_t<(S > 0) && B == 0>>
+    constexpr
+    static_table_map(const node_array& nodes, const slope_array& slopes):
+        nodes_(nodes), slopes_(slopes), index_{}, bucketScale_{0}
+    {}
+    //-----------------------------------------------------
+    template<size_type S = slope_count, size_type B = Buckets,
+             class = std::enable_if_t<S == 0 && (B > 0)>>
+    constexpr
+    static_table_map(const node_array& nodes,
+                     const index_array& index, double bucketScale)
+    :
+        nodes_(nodes), slopes_{}, index_(index), bucketScale_{bucketScale}
+    {}
+    //-----------------------------------------------------
+    template<size_type S = slope_count, size_type B = Buckets,
+             class = std::enable_if_t<(S > 0) && (B > 0)>>
+    constexpr
+    static_table_map(const node_array& nodes, const slope_array& slopes,
+                     const index_array& index, double bucketScale)
+    :
+        nodes_(nodes), slopes_(slopes), index_(index),
+        bucketScale_{bucketScale}
+    {}
+
+
+    //---------------------------------------------------------------
+    // INTERPOLATION
+    //---------------------------------------------------------------
+    constexpr auto
+    operator () (const key_type& x) const {
+        return evaluate_at(x, has_slopes_{});
+    }
+
+    //-----------------------------------------------------
+    /**
+     * @brief batch evaluation: writes the values for all keys
+     *        in [first,last) to out
+     */
+    template<class InputIterator, class OutputIterator>
+    OutputIterator
+    evaluate(InputIterator first, InputIterator last, OutputIterator out) const
+    {
+        for(; first != last; ++first, ++out) *out = (*this)(*first);
+        return out;
+    }
+
+
+    //---------------------------------------------------------------
+    // ELEMENT ACCESS
+    //---------------------------------------------------------------
+    constexpr const value_type&
+    operator [] (size_type i) const noexcept { return nodes_[i]; }
+
+    static constexpr bool      empty() noexcept { return false; }
+    static constexpr size_type size() noexcept  { return N; }
+
+    //-----------------------------------------------------
+    const_iterator begin() const noexcept { return nodes_.begin(); }
+    const_iterator end() const noexcept   { return nodes_.end(); }
+
+    //-----------------------------------------------------
+    constexpr const slope_array& slopes() const noexcept { return slopes_; }
+    constexpr const index_array& index() const noexcept  { return index_; }
+    constexpr double bucket_scale() const noexcept { return bucketScale_; }
+
+    //-----------------------------------------------------
+    interpolator_type
+    interpolator() const { return interpolator_type{}; }
+
+
+private:
+    //---------------------------------------------------------------
+    /// interpolator on the searched node range
+    auto
+    evaluate_at(const key_type& x, std::false_type) const {
+        const auto r = range(x);
+        return interpolator_type{}(nodes_.begin() + r.first,
+                                   nodes_.begin() + r.second, x);
+    }
+
+    //-----------------------------------------------------
+    /// precomputed slopes; same arithmetic as basic_piecewise_linear
+    constexpr double
+    evaluate_at(const key_type& x, std::true_type) const {
+        using extrapolation_t = typename interpolator_type::extrapolation_type;
+
+        const auto& lo = nodes_[0];
+        const auto& hi = nodes_[N-1];
+
+        if(N == 1) {
+            return extrapolation_t{}(x < lo.first, lo.first < x,
+                                     lo, lo, double(lo.second));
+        }
+
+        //first node with key not smaller than x
+        const auto r = range(x);
+        auto i = r.first;
+        auto n = r.second - r.first;
+        while(n > 0) {
+            const auto half = n / 2;
+            if(nodes_[i + half].first < x) {
+                i += half + 1;
+                n -= half + 1;
+            } else {
+                n = half;
+            }
+        }
+        //=> valid segment
+        i = i < 1 ? 1 : (i < N ? i : N-1);
+
+        const auto& p0 = nodes_[i-1];
+        const double v = double(p0.second) + slopes_[i-1] * double(x - p0.first);
+
+        return extrapolation_t{}(x < lo.first, hi.first < x, lo, hi, v);
+    }
+
+
+    //---------------------------------------------------------------
+    /// node index range that contains the segment for key x
+    constexpr std::pair<size_type,size_type>
+    range(const key_type& x) const noexcept {
+        return range(x, std::integral_constant<bool,(Buckets > 0)>{});
+    }
+    //-----------------------------------------------------
+    constexpr std::pair<size_type,size_type>
+    range(const key_type&, std::false_type) const noexcept {
+        return {0, N};
+    }
+    //-----------------------------------------------------
+    constexpr std::pair<size_type,size_type>
+    range(const key_type& x, std::true_type) const noexcept {
+        const double u = (double(x) - double(nodes_[0].first)) * bucketScale_;
+        const auto b = u > 0
+            ? (u < double(Buckets) ? size_type(u) : Buckets - 1) : size_type(0);
+
+        const size_type first = index_[b];
+        const size_type last = size_type(index_[b+1]) + 1;
+        return {first > 0 ? first - 1 : 0, last < N ? last : N};
+    }
+
+
+    //---------------------------------------------------------------
+    node_array nodes_;
+    slope_array slopes_;
+    index_array index_;
+    double bucketScale_;
+};
+
+
+} //namespace am
+
+
+#endif
@@ -0,0 +1,522 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_TIME_SERIES_MAP_H_
+#define AMLIB_TIME_SERIES_MAP_H_
+
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "interpolators.h"
+#include "memory_footprint.h"
+#include "search.h"
+
+
+namespace am {
+
+
+namespace eviction {
+
+/*************************************************************************//***
+ *
+ * @brief never evicts nodes automatically
+ *
+ *****************************************************************************/
+struct none
+{
+    template<class Size, class Key>
+    constexpr bool
+    expired(Size, const Key&, const Key&) const noexcept {
+        return false;
+    }
+};
+
+
+
+/*************************************************************************//***
+ *
+ * @brief evicts oldest nodes as soon as the number of nodes
+ *        exceeds a maximum capacity
+ *
+ *****************************************************************************/
+class capacity
+{
+public:
+    using size_type = std::size_t;
+
+    explicit constexpr
+    capacity(size_type maxSize = size_type(~0)) noexcept:
+        max_{maxSize}
+    {}
+
+    template<class Key>
+    constexpr bool
+    expired(size_type size, const Key&, const Key&) const noexcept {
+        return size > max_;
+    }
+
+    constexpr size_type max_size() const noexcept { return max_; }
+
+private:
+    size_type max_;
+};
+
+
+
+/*************************************************************************//***
+ *
+ * @brief evicts oldest nodes as soon as the key distance between
+ *        the newest and the oldest node exceeds a time window
+ *
+ * @tparam Span  type of key differences (e.g. a std::chrono::duration
+ *               for std::chrono::time_point keys)
+ *
+ *****************************************************************************/
+template<class Span = double>
+class time_window
+{
+public:
+    using span_type = Span;
+
+    explicit constexpr
+    time_window(const span_type& window = span_type{}):
+        window_(window)
+    {}
+
+    template<class Size, class Key>
+    constexpr bool
+    expired(Size, const Key& oldest, const Key& newest) const {
+        return window_ < (newest - oldest);
+    }
+
+    constexpr const span_type& window() const noexcept { return window_; }
+
+private:
+    span_type window_;
+};
+
+
+
+/*************************************************************************//***
+ *
+ * @brief evicts nodes if any of two policies demands it
+ *
+ *****************************************************************************/
+template<class Policy1, class Policy2>
+class combined :
+    private Policy1, private Policy2
+{
+public:
+    explicit constexpr
+    combined(const Policy1& p1 = Policy1{}, const Policy2& p2 = Policy2{}):
+        Policy1(p1), Policy2(p2)
+    {}
+
+    template<class Size, class Key>
+    constexpr bool
+    expired(Size size, const Key& oldest, const Key& newest) const {
+        return Policy1::expired(size, oldest, newest) ||
+               Policy2::expired(size, oldest, newest);
+    }
+
+    const Policy1& first() const noexcept  { return *this; }
+    const Policy2& second() const noexcept { return *this; }
+};
+
+} //namespace eviction
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief Interpolation function over a sliding window of nodes;
+ *        meant for streaming ingestion of samples with increasing keys.
+ *
+ * @details All nodes are held in one contiguous chunk of memory, so the
+ *          node range can be handed to any interpolator.
+ *          Evicted nodes at the front are only marked as dead; the buffer
+ *          is compacted when its capacity is exhausted and at least
+ *          half of it is dead, so that
+ *
+ *     append at back    in amortized O(1)   (keys not smaller than back key)
+ *     evict from front  in O(1)
+ *     out-of-order insert in O(n)
+ *     element search    in O(log(n))
+ *
+ * @tparam KeyT            domain value type
+ * @tparam MappedT         co-domain value type
+ * @tparam Interpolator    function class that interpolates in-between nodes
+ * @tparam EvictionPolicy  decides which of the oldest nodes are evicted
+ *                         after each insertion
+ * @tparam Allocator       node allocator
+ *
+ *****************************************************************************/
+template<
+    class KeyT,
+    class MappedT,
+    class Interpolator,
+    class EvictionPolicy = eviction::none,
+    class Allocator = std::allocator<std::pair<KeyT,MappedT> >
+>
+class time_series_map
+{
+    using mem_t_ = std::vector<std::pair<KeyT,MappedT>,Allocator>;
+
+public:
+    //---------------------------------------------------------------
+    // TYPES
+    //---------------------------------------------------------------
+    using key_type     = KeyT;
+    using mapped_type  = MappedT;
+    //-----------------------------------------------------
+    using interpolator_type = Interpolator;
+    using eviction_policy   = EvictionPolicy;
+    //-----------------------------------------------------
+    using value_type   = typename mem_t_::value_type;
+    using allocator_type = typename mem_t_::allocator_type;
+    //-----------------------------------------------------
+    using reference       = typename mem_t_::reference;
+    using const_reference = typename mem_t_::const_reference;
+    using pointer       = typename mem_t_::pointer;
+    using const_pointer = typename mem_t_::const_pointer;
+    //-----------------------------------------------------
+    using size_type = typename mem_t_::size_type;
+    using difference_type = typename mem_t_::difference_type;
+    //-----------------------------------------------------
+    using const_iterator = typename mem_t_::const_iterator;
+    using const_reverse_iterator = typename mem_t_::const_reverse_iterator;
+
+
+    //---------------------------------------------------------------
+    // CONSTRUCTION / DESTRUCTION
+    //---------------------------------------------------------------
+    explicit
+    time_series_map(
+        const eviction_policy& evict = eviction_policy(),
+        const interpolator_type& ipl = interpolator_type(),
+        const allocator_type& alloc = allocator_type())
+    :
+        ipl_(ipl), evict_(evict), head_(0), mem_(alloc)
+    {}
+
+
+    //---------------------------------------------------------------
+    // INTERPOLATION
+    //---------------------------------------------------------------
+    mapped_type
+    operator () (const key_type& x) const {
+        return ipl_(begin(), end(), x);
+    }
+
+
+    //---------------------------------------------------------------
+    // ELEMENT ACCESS
+    //---------------------------------------------------------------
+    const value_type&
+    operator [] (size_type index) const noexcept {
+        return mem_[head_ + index];
+    }
+    //-----------------------------------------------------
+    const value_type&
+    at(size_type index) const {
+        if(index >= size()) {
+            throw std::out_of_range{"time_series_map::at"};
+        }
+        return mem_[head_ + index];
+    }
+    //-----------------------------------------------------
+    const value_type&
+    front() const noexcept {
+        return mem_[head_];
+    }
+    //-----------------------------------------------------
+    const value_type&
+    back() const noexcept {
+        return mem_.back();
+    }
+
+
+    //---------------------------------------------------------------
+    bool
+    empty() const noexcept {
+        return head_ == mem_.size();
+    }
+    //-----------------------------------------------------
+    size_type
+    size() const noexcept {
+        return mem_.size() - head_;
+    }
+    //-----------------------------------------------------
+    size_type
+    max_size() const noexcept {
+        return mem_.max_size();
+    }
+    //-----------------------------------------------------
+    ///@brief number of nodes that fit into the buffer without reallocation
+    size_type
+    capacity() const noexcept {
+        return mem_.capacity();
+    }
+
+    //-----------------------------------------------------
+    void
+    reserve(size_type size) {
+        compact();
+        mem_.reserve(size);
+    }
+
+
+    //---------------------------------------------------------------
+    // INSERTION
+    //---------------------------------------------------------------
+    /**
+     * @brief inserts a node and evicts expired nodes afterwards
+     *        amortized O(1) if the key is not smaller than the last key,
+     *        O(n) otherwise
+     */
+    void
+    insert(const value_type& val) {
+        emplace(val);
+    }
+    //-----------------------------------------------------
+    void
+    insert(value_type&& val) {
+        emplace(std::move(val));
+    }
+    //-----------------------------------------------------
+    template<class InputIterator>
+    void
+    insert(InputIterator first, InputIterator last) {
+        for(; first != last; ++first) emplace(*first);
+    }
+    //-----------------------------------------------------
+    template<class... Args>
+    void
+    emplace(Args&&... args) {
+        make_room();
+        mem_.emplace_back(std::forward<Args>(args)...);
+        if(size() > 1) {
+            const auto& k = mem_.back().first;
+            const auto& l = mem_[mem_.size()-2].first;
+            if(k < l) restore_order();
+        }
+        evict();
+    }
+
+
+    //---------------------------------------------------------------
+    // EVICTION
+    //---------------------------------------------------------------
+    ///@brief removes the oldest node in O(1)
+    void
+    pop_front() noexcept {
+        if(empty()) return;
+        ++head_;
+        if(empty()) clear();
+    }
+
+    //-----------------------------------------------------
+    /**
+     * @brief removes all nodes with keys smaller than k in O(log(n))
+     * @return number of removed nodes
+     */
+    size_type
+    erase_before(const key_type& k) {
+        const auto n = size_type(std::distance(begin(), lower_bound(k)));
+        head_ += n;
+        if(empty()) clear();
+        return n;
+    }
+
+    //-----------------------------------------------------
+    void
+    clear() noexcept {
+        mem_.clear();
+        head_ = 0;
+    }
+
+    //-----------------------------------------------------
+    /**
+     * @brief moves live nodes to the front of the buffer
+     *        and optionally releases unused memory
+     */
+    void
+    shrink_to_fit() {
+        compact();
+        mem_.shrink_to_fit();
+    }
+
+    //-----------------------------------------------------
+    ///@brief heap memory held by the node buffer (evicted nodes = slack)
+    memory_footprint
+    footprint() const noexcept {
+        memory_footprint f;
+        f.nodes = size() * sizeof(value_type);
+        f.slack = (mem_.capacity() - size()) * sizeof(value_type);
+        return f;
+    }
+
+
+    //---------------------------------------------------------------
+    // SEARCH
+    //---------------------------------------------------------------
+    const_iterator
+    lower_bound(const key_type& k) const {
+        return search::lower_bound(begin(), end(), k);
+    }
+    //-----------------------------------------------------
+    const_iterator
+    upper_bound(const key_type& k) const {
+        return search::upper_bound(begin(), end(), k);
+    }
+    //-----------------------------------------------------
+    const_iterator
+    find(const key_type& k) const {
+        const auto it = lower_bound(k);
+        return (it != end() && !(k < it->first)) ? it : end();
+    }
+
+
+    //---------------------------------------------------------------
+    const interpolator_type&
+    interpolator() const noexcept {
+        return ipl_;
+    }
+    //-----------------------------------------------------
+    const eviction_policy&
+    eviction() const noexcept {
+        return evict_;
+    }
+    //-----------------------------------------------------
+    allocator_type
+    get_allocator() const noexcept {
+        return mem_.get_allocator();
+    }
+
+
+    //---------------------------------------------------------------
+    void
+    swap(time_series_map& other) {
+        using std::swap;
+        swap(ipl_, other.ipl_);
+        swap(evict_, other.evict_);
+        swap(head_, other.head_);
+        mem_.swap(other.mem_);
+    }
+
+
+    //---------------------------------------------------------------
+    // ITERATORS
+    //---------------------------------------------------------------
+    const_iterator begin() const noexcept  {return mem_.begin() + head_; }
+    const_iterator cbegin() const noexcept {return mem_.begin() + head_; }
+    const_iterator end() const noexcept    {return mem_.end(); }
+    const_iterator cend() const noexcept   {return mem_.end(); }
+    //-----------------------------------------------------
+    const_reverse_iterator rbegin() const noexcept  {return mem_.rbegin(); }
+    const_reverse_iterator crbegin() const noexcept {return mem_.rbegin(); }
+    const_reverse_iterator rend() const noexcept {
+        return const_reverse_iterator(begin());
+    }
+    const_reverse_iterator crend() const noexcept {
+        return const_reverse_iterator(begin());
+    }
+
+
+private:
+    //---------------------------------------------------------------
+    void
+    compact() {
+        if(head_ < 1) return;
+        mem_.erase(mem_.begin(), mem_.begin() + head_);
+        head_ = 0;
+    }
+
+    //-----------------------------------------------------
+    /// reclaims dead front slots instead of growing the buffer,
+    /// but only if that amortizes (at least half of the buffer is dead)
+    void
+    make_room() {
+        if(mem_.size() == mem_.capacity() && head_ > 0 && head_ >= size()) {
+            compact();
+        }
+    }
+
+    //-----------------------------------------------------
+    /// moves a freshly appended out-of-order node to its sorted position
+    void
+    restore_order() {
+        const auto last = mem_.end() - 1;
+        const auto pos = std::upper_bound(mem_.begin() + head_, last,
+            last->first,
+            [](const key_type& a, const value_type& b) { return a < b.first; });
+        std::rotate(pos, last, mem_.end());
+    }
+
+    //-----------------------------------------------------
+    void
+    evict() {
+        while(!empty() && evict_.expired(size(), front().first, back().first)) {
+            ++head_;
+        }
+        if(empty()) clear();
+    }
+
+
+    //---------------------------------------------------------------
+    interpolator_type ipl_;
+    eviction_policy evict_;
+    size_type head_;
+    mem_t_ mem_;
+};
+
+
+
+
+/*****************************************************************************
+ *
+ *
+ *****************************************************************************/
+template<class K, class T, class I, class E, class A>
+inline void
+swap(time_series_map<K,T,I,E,A>& a, time_series_map<K,T,I,E,A>& b)
+{
+    a.swap(b);
+}
+
+
+
+
+//-------------------------------------------------------------------
+template<class K, class T, class I, class E, class A>
+inline decltype(auto)
+begin(const time_series_map<K,T,I,E,A>& m)
+{
+    return m.begin();
+}
+
+//---------------------------------------------------------
+template<class K, class T, class I, class E, class A>
+inline decltype(auto)
+end(const time_series_map<K,T,I,E,A>& m)
+{
+    return m.end();
+}
+
+
+} //namespace am
+
+
+#endif
@@ -0,0 +1,450 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+#ifndef AMLIB_TRANSFORMS_H_
+#define AMLIB_TRANSFORMS_H_
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fast_math.h"
+#include "interpolating_map.h"
+
+
+namespace am {
+
+
+/*****************************************************************************
+ *
+ * COORDINATE TRANSFORMS
+ *
+ * strictly monotone functions with
+ *   static double forward(double);
+ *   static double inverse(double);
+ *   static constexpr bool increasing;
+ *
+ *****************************************************************************/
+namespace transform {
+
+//-------------------------------------------------------------------
+struct identity
+{
+    static constexpr bool increasing = true;
+    static double forward(double x) noexcept { return x; }
+    static double inverse(double u) noexcept { return u; }
+};
+
+//-------------------------------------------------------------------
+///@brief natural logarithm; domain: x > 0
+struct log
+{
+    static constexpr bool increasing = true;
+    static double forward(double x) noexcept { return std::log(x); }
+    static double inverse(double u) noexcept { return std::exp(u); }
+};
+
+//-------------------------------------------------------------------
+///@brief logarithm with fast_log/fast_exp kernels (see fast_math.h)
+template<int Terms = 5, int ExpTerms = 9>
+struct fast_log
+{
+    static constexpr bool increasing = true;
+    static double forward(double x) noexcept { return am::fast_log<Terms>(x); }
+    static double inverse(double u) noexcept { return am::fast_exp<ExpTerms>(u); }
+};
+
+//-------------------------------------------------------------------
+///@brief square root; domain: x >= 0
+struct sqrt
+{
+    static constexpr bool increasing = true;
+    static double forward(double x) noexcept { return std::sqrt(x); }
+    static double inverse(double u) noexcept { return u * u; }
+};
+
+//-------------------------------------------------------------------
+///@brief 1/x; domain: x > 0 (or x < 0 for all keys)
+struct reciprocal
+{
+    static constexpr bool increasing = false;
+    static double forward(double x) noexcept { return 1.0 / x; }
+    static double inverse(double u) noexcept { return 1.0 / u; }
+};
+
+//-------------------------------------------------------------------
+///@brief log(p/(1-p)); domain: 0 < p < 1
+struct logit
+{
+    static constexpr bool increasing = true;
+    static double forward(double p) noexcept { return std::log(p / (1.0 - p)); }
+    static double inverse(double u) noexcept { return 1.0 / (1.0 + std::exp(-u)); }
+};
+
+} //namespace transform
+
+
+
+
+namespace interpolator {
+
+
+/*************************************************************************//***
+ *
+ * @brief piece-wise linear interpolation in transformed coordinates:
+ *        u = KeyTransform(x), w = ValueTransform(y), result = inverse(w)
+ *        (e.g. log-log: power law segments; linear-log: exponential segments)
+ *
+ * @details interpolating_map stores the transformed nodes once (see
+ *          node_cache) and searches them with the transformed query key,
+ *          so each query costs one forward key transform and one inverse
+ *          value transform.
+ *          Without cache (e.g. in compressed_map) only the 2 nodes of the hit
+ *          segment are transformed.
+ *
+ *          Keys outside of the key transform's domain are treated like keys
+ *          outside of the node range whose boundary segment can't be
+ *          extended (=> 'linear' yields the boundary node value).
+ *
+ * @tparam KeyTransform    see namespace transform
+ * @tparam ValueTransform  see namespace transform
+ * @tparam Extrapolation   policy for keys outside of the node key range;
+ *                         'linear' extends the boundary segments in
+ *                         transformed coordinates
+ *
+ * @pre all node keys and values must be within the transforms' domains
+ *
+ *****************************************************************************/
+template<
+    class KeyTransform,
+    class ValueTransform = transform::identity,
+    class Extrapolation = extrapolation::linear
+>
+class transformed :
+    private Extrapolation
+{
+    template<class Key, class Value>
+    struct cache_ {
+        std::vector<std::pair<double,double>> nodes;
+        std::pair<Key,Value> lo;
+        std::pair<Key,Value> hi;
+    };
+
+public:
+    using key_transform = KeyTransform;
+    using value_transform = ValueTransform;
+    using extrapolation_type = Extrapolation;
+
+    ///@brief transformed nodes in ascending order of transformed keys
+    template<class Key, class Value>
+    using cache_type = cache_<Key,Value>;
+
+
+    constexpr
+    transformed(const Extrapolation& e = Extrapolation{}):
+        Extrapolation(e)
+    {}
+
+    const extrapolation_type&
+    extrapolation() const noexcept { return *this; }
+
+
+    //---------------------------------------------------------------
+    template<class Iterator, class Key, class Value>
+    void prepare(Iterator begin, Iterator end, cache_<Key,Value>& c) const
+    {
+        c.nodes.clear();
+        if(begin == end) return;
+
+        c.nodes.reserve(std::distance(begin,end));
+        c.lo = *begin;
+        for(; begin != end; ++begin) {
+            c.nodes.emplace_back(KeyTransform::forward(double(begin->first)),
+                                 ValueTransform::forward(double(begin->second)));
+            c.hi = *begin;
+        }
+        if(!KeyTransform::increasing) {
+            std::reverse(c.nodes.begin(), c.nodes.end());
+        }
+    }
+
+    //-----------------------------------------------------
+    ///@brief heap bytes occupied by the transformed nodes
+    template<class Key, class Value>
+    std::size_t
+    memory_usage(const cache_<Key,Value>& c) const noexcept {
+        return c.nodes.capacity() * sizeof(std::pair<double,double>);
+    }
+
+    //-----------------------------------------------------
+    /// re-transforms the values of nodes [first,last) (keys unchanged)
+    template<class Iterator, class Key, class Value>
+    void refresh_values(Iterator begin, Iterator end, cache_<Key,Value>& c,
+                        std::size_t first, std::size_t last) const
+    {
+        const auto n = c.nodes.size();
+        last = std::min(last, n);
+        if(first >= last) return;
+
+        auto it = std::next(begin, first);
+        for(auto i = first; i < last; ++i, ++it) {
+            const auto j = KeyTransform::increasing ? i : n - 1 - i;
+            c.nodes[j].second = ValueTransform::forward(double(it->second));
+        }
+        if(first == 0) c.lo = *begin;
+        if(last == n)  c.hi = *std::prev(end);
+    }
+
+    //-----------------------------------------------------
+    /**
+     * @brief replaces the transformed versions of 'erased' nodes at
+     *        index pos with those of the nodes [pos,pos+inserted)
+     */
+    template<class Iterator, class Key, class Value>
+    void splice_nodes(Iterator begin, Iterator end, cache_<Key,Value>& c,
+                      std::size_t pos, std::size_t erased,
+                      std::size_t inserted) const
+    {
+        using diff_t = typename decltype(c.nodes)::difference_type;
+
+        std::vector<std::pair<double,double>> ins;
+        ins.reserve(inserted);
+        auto it = std::next(begin, pos);
+        for(std::size_t i = 0; i < inserted; ++i, ++it) {
+            ins.emplace_back(KeyTransform::forward(double(it->first)),
+                             ValueTransform::forward(double(it->second)));
+        }
+
+        //cache order is reversed for decreasing key transforms
+        const auto n = c.nodes.size();
+        const auto at = KeyTransform::increasing ? pos : n - pos - erased;
+        if(!KeyTransform::increasing) std::reverse(ins.begin(), ins.end());
+
+        const auto p = c.nodes.erase(std::next(c.nodes.begin(), diff_t(at)),
+                                     std::next(c.nodes.begin(), diff_t(at + erased)));
+        c.nodes.insert(p, ins.begin(), ins.end());
+
+        if(begin != end) {
+            c.lo = *begin;
+            c.hi = *std::prev(end);
+        }
+    }
+
+
+    //---------------------------------------------------------------
+    /**
+     * @brief interpolation based on transformed nodes
+     * @param probe  instrumentation policy that receives search events
+     */
+    template<class Key, class Value, class Probe = instrumentation::none>
+    auto interpolate(const cache_<Key,Value>& c, const Key& x,
+                     Probe = Probe{}) const
+    {
+        using res_t = decltype(detail::make_fp(std::declval<Value>()));
+
+        const auto n = std::distance(c.nodes.begin(), c.nodes.end());
+        if(n <  1) return res_t{};
+        if(n == 1) {
+            return extrapolation()(x < c.lo.first, c.lo.first < x,
+                                   c.lo, c.lo, detail::make_fp(c.lo.second));
+        }
+
+        const double u = KeyTransform::forward(double(x));
+        if(!std::isfinite(u)) return boundary<res_t>(c.lo, c.hi, x);
+
+        const auto i = detail::upper_segment_node<Probe>(
+                           c.nodes.begin(), c.nodes.end(), u, n);
+
+        const auto& p0 = c.nodes[i-1];
+        const auto& p1 = c.nodes[i];
+
+        return extrapolation()(x < c.lo.first, c.hi.first < x, c.lo, c.hi,
+                               res_t(segment(p0.first, p0.second,
+                                             p1.first, p1.second, u)));
+    }
+
+
+    //---------------------------------------------------------------
+    /**
+     * @brief interpolation based on untransformed nodes
+     *
+     * @tparam Iterator  RandomAccessIterator (at least ForwardIterator)
+     *                   to pairs of keys and mapped values (= nodes)
+     *
+     * @param begin  lower bound of node range
+     * @param end    exclusive upper bound of node range
+     * @param x      key for which to return the interpolated value
+     * @param probe  instrumentation policy that receives search events
+     *
+     * @pre keys in range [begin,end) have to be sorted in ascending order
+     */
+    template<class Iterator, class EndSentinel, class Key,
+             class Probe = instrumentation::none>
+    auto operator () (const Iterator begin, const EndSentinel end,
+                      const Key& x, Probe = Probe{}) const
+    {
+        using std::distance;
+        using std::next;
+
+        using res_t = decltype(detail::make_fp(begin->second));
+
+        const auto n = distance(begin,end);
+        if(n <  1) return res_t{};
+        if(n == 1) {
+            return extrapolation()(x < begin->first, begin->first < x,
+                                   *begin, *begin,
+                                   detail::make_fp(begin->second));
+        }
+
+        const auto& lo = *begin;
+        const auto& hi = *next(begin, n-1);
+
+        const double u = KeyTransform::forward(double(x));
+        if(!std::isfinite(u)) return boundary<res_t>(lo, hi, x);
+
+        const auto i = detail::upper_segment_node<Probe>(begin, end, x, n);
+
+        const auto& p0 = *next(begin, i-1);
+        const auto& p1 = *next(begin, i);
+
+        return extrapolation()(x < lo.first, hi.first < x, lo, hi,
+            res_t(segment(KeyTransform::forward(double(p0.first)),
+                          ValueTransform::forward(double(p0.second)),
+                          KeyTransform::forward(double(p1.first)),
+                          ValueTransform::forward(double(p1.second)), u)));
+    }
+
+
+private:
+    //---------------------------------------------------------------
+    static double
+    segment(double u0, double w0, double u1, double w1, double u) noexcept {
+        return ValueTransform::inverse(w0 + (w1 - w0) / (u1 - u0) * (u - u0));
+    }
+
+    //---------------------------------------------------------------
+    template<class Result, class Node, class Key>
+    Result boundary(const Node& lo, const Node& hi, const Key& x) const {
+        const bool above = hi.first < x;
+        return extrapolation()(!above, above, lo, hi,
+            detail::make_fp(above ? hi.second : lo.second));
+    }
+};
+
+
+
+//-------------------------------------------------------------------
+using piecewise_log_log = transformed<transform::log, transform::log>;
+
+using piecewise_linear_log = transformed<transform::identity, transform::log>;
+
+
+
+
+/*************************************************************************//***
+ *
+ * @brief transformed interpolators with untransformed values are linear
+ *        within each segment in transformed key coordinates
+ *
+ *****************************************************************************/
+template<class KT, class E>
+struct is_segment_linear<transformed<KT,transform::identity,E>> :
+    std::true_type
+{};
+
+
+//-------------------------------------------------------------------
+template<class KT, class E, class Key>
+inline double
+segment_coordinate(const transformed<KT,transform::identity,E>&, const Key& x)
+{
+    return KT::forward(double(x));
+}
+
+
+//-------------------------------------------------------------------
+template<class KT, class E, class Key>
+inline Key
+segment_key(const transformed<KT,transform::identity,E>&,
+            const Key& x0, const Key& x1, double t)
+{
+    const double u0 = KT::forward(double(x0));
+    const double u1 = KT::forward(double(x1));
+    return Key(KT::inverse(u0 + t * (u1 - u0)));
+}
+
+
+} //namespace interpolator
+
+
+
+
+/*****************************************************************************
+ *
+ *
+ *****************************************************************************/
+template<
+    class Key,
+    class Value,
+    class KeyTransform,
+    class ValueTransform = transform::identity,
+    class KeyCompare = std::less<Key>,
+    class Allocator = std::allocator<std::pair<const Key,Value>>,
+    class Instrumentation = instrumentation::none
+>
+using transformed_map =
+        interpolating_map<Key,Value,
+                          interpolator::transformed<KeyTransform,ValueTransform>,
+                          KeyCompare,Allocator,Instrumentation>;
+
+
+
+/*****************************************************************************
+ *
+ *
+ *****************************************************************************/
+template<
+    class Key,
+    class Value,
+    class KeyCompare = std::less<Key>,
+    class Allocator = std::allocator<std::pair<const Key,Value>>,
+    class Instrumentation = instrumentation::none
+>
+using piecewise_log_log_map =
+        interpolating_map<Key,Value,interpolator::piecewise_log_log,
+                          KeyCompare,Allocator,Instrumentation>;
+
+
+
+/*****************************************************************************
+ *
+ *
+ *****************************************************************************/
+template<
+    class Key,
+    class Value,
+    class KeyCompare = std::less<Key>,
+    class Allocator = std::allocator<std::pair<const Key,Value>>,
+    class Instrumentation = instrumentation::none
+>
+using piecewise_linear_log_map =
+        interpolating_map<Key,Value,interpolator::piecewise_linear_log,
+                          KeyCompare,Allocator,Instrumentation>;
+
+
+} //namespace am
+
+
+#endif
@@ -15,12 +15,31 @@
 #include <algorithm>
 #include <utility>
 #include <functional>
+#include <iterator>
+#include <memory>
 #include <vector>
 
+#include "instrumentation.h"
+#include "memory_footprint.h"
+#include "search.h"
+
 
 namespace am {
 
 
+/*************************************************************************//***
+ *
+ * @brief tag that marks a node sequence as already sorted by key
+ *        (skips sorting/searching during construction)
+ *
+ *****************************************************************************/
+struct sorted_range_t { explicit sorted_range_t() = default; };
+
+constexpr sorted_range_t sorted_range {};
+
+
+
+
 /*************************************************************************//***
  *
  * @brief key -> value (multi)map
@@ -33,17 +52,25 @@ namespace am {
  *     insert in O(n)
  *     erase  in O(n)
  *
+ * @tparam Instrumentation  hot-path event counting policy
+ *                          (see instrumentation.h);
+ *                          default: none (compiled out)
  *
  *****************************************************************************/
 template<
     class KeyT,
     class MappedT,
     class KeyCompare = std::less<KeyT>,
-    class Allocator = std::allocator<std::pair<KeyT,MappedT> >
+    class Allocator = std::allocator<std::pair<KeyT,MappedT> >,
+    class Instrumentation = instrumentation::none
 >
 class vector_map
 {
-    using mem_t_ = std::vector<typename std::pair<KeyT,MappedT>,Allocator>;
+    //allocators for std::pair<const KeyT,MappedT> (as for std::map)
+    //are rebound to the stored node type
+    using mem_t_ = std::vector<std::pair<KeyT,MappedT>,
+        typename std::allocator_traits<Allocator>::template
+            rebind_alloc<std::pair<KeyT,MappedT>>>;
 
 public:
     //---------------------------------------------------------------
@@ -52,7 +79,9 @@ public:
     using key_type     = KeyT;
     using mapped_type  = MappedT;
     using key_compare  = KeyCompare;
+    using instrumentation_type = Instrumentation;
     //-----------------------------------------------------
+    using container_type = mem_t_;
     using value_type   = typename mem_t_::value_type;
     using allocator_type = typename mem_t_::allocator_type;
     //-----------------------------------------------------
@@ -131,6 +160,37 @@ public:
     {
         insert(first,last);
     }
+    //-----------------------------------------------------
+    /**
+     * @brief adopts nodes that are already sorted by key in O(n)
+     * @pre   [first,last) is sorted in ascending key order
+     */
+    template<class InputIterator>
+    vector_map(
+        sorted_range_t,
+        InputIterator first, InputIterator last,
+        const key_compare& comp = key_compare(),
+        const allocator_type& alloc = allocator_type())
+    :
+        comp_(comp), mem_(first, last, alloc)
+    {
+        Instrumentation::rebuild();
+    }
+    //-----------------------------------------------------
+    /**
+     * @brief takes over a node container that is already sorted by key
+     *        in O(1)
+     * @pre   nodes are sorted in ascending key order
+     */
+    vector_map(
+        sorted_range_t,
+        container_type&& nodes,
+        const key_compare& comp = key_compare())
+    :
+        comp_(comp), mem_(std::move(nodes))
+    {
+        Instrumentation::rebuild();
+    }
 
 
     //---------------------------------------------------------------
@@ -192,6 +252,16 @@ public:
         return mem_.at(index);
     }
 
+    //-----------------------------------------------------
+    /**
+     * @brief writable mapped value of a node;
+     *        keys stay immutable => the sort order can't be broken
+     */
+    mapped_type&
+    mapped(size_type index) noexcept {
+        return mem_[index].second;
+    }
+
     //-----------------------------------------------------
     const value_type&
     front() const noexcept {
@@ -227,6 +297,27 @@ public:
     reserve(size_type size) {
         mem_.reserve(size);
     }
+    //-----------------------------------------------------
+    ///@brief number of nodes that fit into the buffer without reallocation
+    size_type
+    capacity() const noexcept {
+        return mem_.capacity();
+    }
+    //-----------------------------------------------------
+    ///@brief releases unused capacity (non-binding, as for std::vector)
+    void
+    shrink_to_fit() {
+        mem_.shrink_to_fit();
+    }
+
+    //-----------------------------------------------------
+    memory_footprint
+    footprint() const noexcept {
+        memory_footprint f;
+        f.nodes = mem_.size() * sizeof(value_type);
+        f.slack = (mem_.capacity() - mem_.size()) * sizeof(value_type);
+        return f;
+    }
 
 
     //---------------------------------------------------------------
@@ -241,6 +332,7 @@ public:
     const_iterator
     insert(const value_type& val) {
         const auto pos = lower_bound(val.first);
+        Instrumentation::rebuild();
         return mem_.insert(pos, val);
     }
 
@@ -248,23 +340,44 @@ public:
     const_iterator
     insert(value_type&& val) {
         const auto pos = lower_bound(val.first);
+        Instrumentation::rebuild();
         return mem_.insert(pos, std::move(val));
     }
 
     //-----------------------------------------------------
+    /**
+     * @brief inserts all nodes in [first,last) in O((n+m) + m log(m));
+     *        the result is the same as with single inserts in input order
+     * @return position of the last node of the input range
+     */
     template <class InputIterator>
     const_iterator
     insert(InputIterator first, InputIterator last) {
-        using std::distance;
-
-        mem_.reserve(mem_.size() + distance(first,last));
-
-        auto it = mem_.cend();
-        for(; first != last; ++first) {
-            it = insert(*first);
+        const auto n = mem_.size();
+        mem_.insert(mem_.end(), first, last);
+        if(mem_.size() == n) return mem_.cend();
+
+        const auto mid = std::next(mem_.begin(), difference_type(n));
+        const auto lastKey = mem_.back().first;
+
+        const auto less = [](const value_type& a, const value_type& b) {
+            return a.first < b.first;
+        };
+        //single inserts put new nodes before all nodes with equal keys
+        std::reverse(mid, mem_.end());
+        std::stable_sort(mid, mem_.end(), less);
+
+        if(n > 0 && !(mem_[n-1].first < mid->first)) {
+            //merge is stable => new nodes first
+            const auto m = mem_.size() - n;
+            std::rotate(mem_.begin(), mid, mem_.end());
+            std::inplace_merge(mem_.begin(),
+                               std::next(mem_.begin(), difference_type(m)),
+                               mem_.end(), less);
         }
+        Instrumentation::rebuild();
 
-        return it;
+        return lower_bound(lastKey);
     }
     //-----------------------------------------------------
     const_iterator
@@ -281,8 +394,10 @@ public:
         const auto er = equal_range(key);
 
         if(er.first < mem_.cend()) {
+            const auto n = distance(er.first, er.second);
+            Instrumentation::rebuild();
             mem_.erase(er.first, er.second);
-            return distance(er.first, er.second);
+            return n;
         } else {
             return 0;
         }
@@ -290,11 +405,13 @@ public:
     //-----------------------------------------------------
     const_iterator
     erase(const_iterator pos) {
+        Instrumentation::rebuild();
         return mem_.erase(pos);
     }
     //-----------------------------------------------------
     const_iterator
     erase(const_iterator first, const_iterator last) {
+        Instrumentation::rebuild();
         return mem_.erase(first,last);
     }
 
@@ -305,6 +422,15 @@ public:
         mem_.clear();
     }
 
+    //-----------------------------------------------------
+    ///@brief moves the node container out; leaves the map empty
+    container_type
+    extract() {
+        container_type nodes {std::move(mem_)};
+        mem_.clear();
+        return nodes;
+    }
+
 
     //---------------------------------------------------------------
     const_iterator
@@ -326,6 +452,44 @@ public:
         return upper_bound(mem_.begin(), mem_.end(), k);
     }
 
+    //-----------------------------------------------------
+    /**
+     * @brief lower_bound for all keys in [first,last);
+     *        writes one const_iterator per key to out
+     *
+     * @details The searches run interleaved in groups of Group queries
+     *          with prefetching (search::partition_points), which hides
+     *          memory latency for maps that exceed the caches.
+     */
+    template<std::size_t Group = search::default_group_size,
+             class InputIterator, class OutputIterator>
+    OutputIterator
+    lower_bounds(InputIterator first, InputIterator last,
+                 OutputIterator out) const
+    {
+        return search::partition_points<Group>(mem_.begin(), mem_.size(),
+            first, last, out,
+            [](const value_type& a, const key_type& k) {
+                Instrumentation::comparison();
+                return a.first < k;
+            });
+    }
+
+    //-----------------------------------------------------
+    template<std::size_t Group = search::default_group_size,
+             class InputIterator, class OutputIterator>
+    OutputIterator
+    upper_bounds(InputIterator first, InputIterator last,
+                 OutputIterator out) const
+    {
+        return search::partition_points<Group>(mem_.begin(), mem_.size(),
+            first, last, out,
+            [](const value_type& a, const key_type& k) {
+                Instrumentation::comparison();
+                return !(k < a.first);
+            });
+    }
+
     //-----------------------------------------------------
     std::pair<const_iterator,const_iterator>
     equal_range(const key_type& k) const {
@@ -383,50 +547,35 @@ private:
     //---------------------------------------------------------------
     //we need our own versions of upper_bound lower_bound etc.
     //we can't use the std:: algorithms because this would lead to
-    //the requirement that the mapped type had to be default constructible
+    //the requirement that the mapped type had to be default constructible;
+    //the branchless kernels keep the order of equal keys (multimap)
     template <class Iter>
     static Iter
     lower_bound(Iter first, Iter last, const key_type& key)
     {
-        difference_type count = distance(first,last);
-        difference_type step = 0;
-
-        Iter it;
-        while(count > 0) {
-          it = first;
-          step = count / 2;
-          it += step;
-          if(it->first < key) {
-              first = ++it;
-              count -= step + 1;
-          }
-          else count = step;
-        }
-        return first;
+        Instrumentation::search();
+
+        return search::partition_point(first, last,
+            [&](const value_type& a) {
+                Instrumentation::comparison();
+                return a.first < key;
+            });
     }
     //-----------------------------------------------------
-    template <class Iter, class T>
+    template <class Iter>
     static Iter
     upper_bound (Iter first, Iter last, const key_type& key)
     {
-        difference_type count = distance(first,last);
-        difference_type step = 0;
-
-        Iter it;
-        while(count > 0) {
-            it = first;
-            step = count / 2;
-            it += step;
-            if(!(key < it->first)) {
-                first = ++it;
-                count -= step + 1;
-            }
-            else count = step;
-        }
-        return first;
+        Instrumentation::search();
+
+        return search::partition_point(first, last,
+            [&](const value_type& a) {
+                Instrumentation::comparison();
+                return !(key < a.first);
+            });
     }
     //-----------------------------------------------------
-    template <class Iter, class T>
+    template <class Iter>
     static std::pair<Iter,Iter>
     equal_range(Iter first, Iter last, const key_type& key)
     {
@@ -450,9 +599,9 @@ private:
  * MODIFICATION
  *
  *****************************************************************************/
-template<class K, class T, class C, class A>
+template<class K, class T, class C, class A, class P>
 inline void
-swap(vector_map<K,T,C,A>& a, vector_map<K,T,C,A>& b) noexcept
+swap(vector_map<K,T,C,A,P>& a, vector_map<K,T,C,A,P>& b) noexcept
 {
     a.swap(b);
 }
@@ -467,46 +616,46 @@ swap(vector_map<K,T,C,A>& a, vector_map<K,T,C,A>& b) noexcept
  * RELATIONAL OPERATORS
  *
  *****************************************************************************/
-template<class K, class T, class C, class A>
+template<class K, class T, class C, class A, class P>
 inline bool
-operator == (const vector_map<K,T,C,A>& a, const vector_map<K,T,C,A>& b) noexcept
+operator == (const vector_map<K,T,C,A,P>& a, const vector_map<K,T,C,A,P>& b) noexcept
 {
     return std::equal(a.begin(), a.end(), b.begin());
 }
 
-template<class K, class T, class C, class A>
+template<class K, class T, class C, class A, class P>
 inline bool
-operator != (const vector_map<K,T,C,A>& a, const vector_map<K,T,C,A>& b) noexcept
+operator != (const vector_map<K,T,C,A,P>& a, const vector_map<K,T,C,A,P>& b) noexcept
 {
     return !operator==(a,b);
 }
 
 
 
-template<class K, class T, class C, class A>
+template<class K, class T, class C, class A, class P>
 inline bool
-operator < (const vector_map<K,T,C,A>& a, const vector_map<K,T,C,A>& b) noexcept
+operator < (const vector_map<K,T,C,A,P>& a, const vector_map<K,T,C,A,P>& b) noexcept
 {
     return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
 }
 
-template<class K, class T, class C, class A>
+template<class K, class T, class C, class A, class P>
 inline bool
-operator <= (const vector_map<K,T,C,A>& a, const vector_map<K,T,C,A>& b) noexcept
+operator <= (const vector_map<K,T,C,A,P>& a, const vector_map<K,T,C,A,P>& b) noexcept
 {
     return operator==(a,b) || operator<(a,b);
 }
 
-template<class K, class T, class C, class A>
+template<class K, class T, class C, class A, class P>
 inline bool
-operator > (const vector_map<K,T,C,A>& a, const vector_map<K,T,C,A>& b) noexcept
+operator > (const vector_map<K,T,C,A,P>& a, const vector_map<K,T,C,A,P>& b) noexcept
 {
     return !operator<(a,b);
 }
 
-template<class K, class T, class C, class A>
+template<class K, class T, class C, class A, class P>
 inline bool
-operator >= (const vector_map<K,T,C,A>& a, const vector_map<K,T,C,A>& b) noexcept
+operator >= (const vector_map<K,T,C,A,P>& a, const vector_map<K,T,C,A,P>& b) noexcept
 {
     return operator==(a,b) || operator>(a,b);
 }
@@ -521,42 +670,42 @@ operator >= (const vector_map<K,T,C,A>& a, const vector_map<K,T,C,A>& b) noexcep
  * NON-MEMBER BEGIN/END
  *
  *****************************************************************************/
-template<class K, class T, class C, class A>
+template<class K, class T, class C, class A, class P>
 inline auto
-begin(vector_map<K,T,C,A>& m) noexcept {
+begin(vector_map<K,T,C,A,P>& m) noexcept {
     return m.begin();
 }
 
-template<class K, class T, class C, class A>
+template<class K, class T, class C, class A, class P>
 inline auto
-begin(const vector_map<K,T,C,A>& m) noexcept {
+begin(const vector_map<K,T,C,A,P>& m) noexcept {
     return m.begin();
 }
 
-template<class K, class T, class C, class A>
+template<class K, class T, class C, class A, class P>
 inline auto
-cbegin(const vector_map<K,T,C,A>& m) noexcept {
+cbegin(const vector_map<K,T,C,A,P>& m) noexcept {
     return m.cbegin();
 }
 
 
 
 //-------------------------------------------------------------------
-template<class K, class T, class C, class A>
+template<class K, class T, class C, class A, class P>
 inline auto
-end(vector_map<K,T,C,A>& m) noexcept {
+end(vector_map<K,T,C,A,P>& m) noexcept {
     return m.end();
 }
 
-template<class K, class T, class C, class A>
+template<class K, class T, class C, class A, class P>
 inline auto
-end(const vector_map<K,T,C,A>& m) noexcept {
+end(const vector_map<K,T,C,A,P>& m) noexcept {
     return m.end();
 }
 
-template<class K, class T, class C, class A>
+template<class K, class T, class C, class A, class P>
 inline auto
-cend(const vector_map<K,T,C,A>& m) noexcept {
+cend(const vector_map<K,T,C,A,P>& m) noexcept {
     return m.cend();
 }
 
@@ -0,0 +1,142 @@
+/*****************************************************************************
+ *
+ * AM utilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "allocators.h"
+#include "interpolating_map.h"
+
+
+using namespace am;
+
+
+//-------------------------------------------------------------------
+void require(bool ok, const char* what)
+{
+    if(!ok) throw std::runtime_error{what};
+}
+
+//-------------------------------------------------------------------
+template<class T>
+bool aligned_to(const T* p, std::size_t alignment) {
+    return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+}
+
+
+
+//-------------------------------------------------------------------
+void alignment_test()
+{
+    aligned_allocator<char,256> a;
+    for(std::size_t n : {1, 3, 100, 4097}) {
+        char* p = a.allocate(n);
+        require(aligned_to(p, 256), "aligned_allocator: alignment");
+        p[0] = p[n-1] = 'x';
+        a.deallocate(p, n);
+    }
+
+    //alignments below sizeof(void*)
+    std::vector<int,aligned_allocator<int,4>> v4(10);
+    std::vector<char,aligned_allocator<char,2>> v2(10);
+    std::vector<char,aligned_allocator<char,1>> v1(10);
+    require(aligned_to(v4.data(), 4) && aligned_to(v2.data(), 2) &&
+            v1.size() == 10, "aligned_allocator: small alignment");
+
+    //rebind, as used by vector_map for std::pair<const K,V> allocators
+    using map_t = vector_map<float,float,std::less<float>,
+        aligned_allocator<std::pair<const float,float>>>;
+    map_t m;
+    for(int i = 0; i < 1000; ++i) {
+        m.insert({float(i), float(i)});
+        require(aligned_to(&*m.begin(), 64), "vector_map: alignment");
+    }
+    m.shrink_to_fit();
+    require(aligned_to(&*m.begin(), 64), "vector_map: shrink_to_fit");
+}
+
+
+
+//-------------------------------------------------------------------
+void huge_page_test()
+{
+    using alloc_t = huge_page_allocator<std::pair<const double,double>>;
+    using map_t = interpolating_map<double,double,interpolator::piecewise_linear,
+                                    std::less<double>,alloc_t>;
+
+    //large enough for huge pages
+    const std::size_t n = 3 * huge_page_size / sizeof(std::pair<double,double>);
+    map_t::container_type nodes {alloc_t{}};
+    nodes.reserve(n);
+    for(std::size_t i = 0; i < n; ++i) nodes.emplace_back(double(i), 2.0 * i);
+
+    const auto bytes = nodes.capacity() * sizeof(std::pair<double,double>);
+    require(alloc_t::uses_huge_pages(bytes) ==
+            aligned_allocator<int,64,huge_pages::transparent>::uses_huge_pages(bytes),
+            "huge pages: policy");
+    if(alloc_t::uses_huge_pages(bytes)) {
+        require(aligned_to(nodes.data(), huge_page_size), "huge pages: alignment");
+    }
+
+    const map_t m {sorted_range, std::move(nodes)};
+    require(m.size() == n && m(1000.5) == 2001.0 && m(double(n - 1)) == 2.0 * (n - 1),
+            "huge pages: values");
+
+    //small allocations don't use huge pages
+    require(!alloc_t::uses_huge_pages(1000) &&
+            !aligned_allocator<int>::uses_huge_pages(huge_page_size),
+            "huge pages: threshold");
+
+    //explicit huge pages fall back if the system has none reserved
+    using tlb_t = aligned_allocator<char,64,huge_pages::hugetlb>;
+    tlb_t t;
+    char* p = t.allocate(huge_page_size + 1);
+    p[0] = p[huge_page_size] = 'x';
+    require(aligned_to(p, 64), "hugetlb: alignment");
+    t.deallocate(p, huge_page_size + 1);
+}
+
+
+
+//-------------------------------------------------------------------
+void tracking_test()
+{
+    struct tag {};
+    using alloc_t = tracking_allocator<std::pair<const int,int>,tag,
+                                       aligned_allocator<std::pair<const int,int>>>;
+    {
+        vector_map<int,int,std::less<int>,alloc_t> m;
+        m.reserve(100);
+        m.insert({1, 2});
+        require(aligned_to(&*m.begin(), 64), "tracking: alignment");
+        require(allocation_counter<tag>::snapshot().live_bytes ==
+                100 * sizeof(std::pair<int,int>), "tracking: bytes");
+    }
+    require(allocation_counter<tag>::snapshot().live_bytes == 0, "tracking: released");
+}
+
+
+
+//-------------------------------------------------------------------
+int main()
+{
+    try {
+        alignment_test();
+        huge_page_test();
+        tracking_test();
+    }
+    catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,160 @@
+/*****************************************************************************
+ *
+ * AM utilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "color_mapping.h"
+#include "gradients.h"
+
+
+using namespace am;
+
+
+//-------------------------------------------------------------------
+void require(bool ok, const char* what)
+{
+    if(!ok) throw std::runtime_error{what};
+}
+
+
+
+//-------------------------------------------------------------------
+struct rgb
+{
+    double r = 0, g = 0, b = 0;
+
+    friend rgb operator + (const rgb& x, const rgb& y) {
+        return {x.r + y.r, x.g + y.g, x.b + y.b};
+    }
+    friend rgb operator - (const rgb& x, const rgb& y) {
+        return {x.r - y.r, x.g - y.g, x.b - y.b};
+    }
+    friend rgb operator * (const rgb& x, double s) {
+        return {x.r * s, x.g * s, x.b * s};
+    }
+    friend rgb operator * (double s, const rgb& x) { return x * s; }
+    friend rgb operator / (const rgb& x, double s) { return x * (1.0 / s); }
+};
+
+
+
+//-------------------------------------------------------------------
+void rgba8_test()
+{
+    //black -> red -> white
+    const auto nodes = piecewise_linear_map<double,rgb>{
+        {0.0, rgb{0,0,0}}, {0.5, rgb{1,0,0}}, {1.0, rgb{1,1,1}} };
+    const auto grad = linear_gradient<double,rgb>{nodes.begin(), nodes.end()};
+
+    color_lut_options opt;
+    opt.size = 257;
+    const auto lut = make_color_lut<pixel_format::rgba8>(grad, opt);
+    require(lut.size() == 257, "rgba8: size");
+
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const std::vector<float> v {10, 20, 30, -5, 100, nan, 15};
+    std::vector<std::uint8_t> px(v.size() * 4);
+    lut.map(v, 10.0f, 30.0f, px.data());
+
+    const auto is = [&](std::size_t i, int r, int g, int b, int a) {
+        return px[4*i] == r && px[4*i+1] == g && px[4*i+2] == b && px[4*i+3] == a;
+    };
+    require(is(0, 0,0,0,255) && is(1, 255,0,0,255) && is(2, 255,255,255,255),
+            "rgba8: nodes");
+    require(is(3, 0,0,0,255) && is(4, 255,255,255,255), "rgba8: clamping");
+    require(is(5, 0,0,0,0), "rgba8: NaN");
+    require(is(6, 128,0,0,255), "rgba8: interpolation");
+
+    //gamma
+    opt.gamma = 2.0;
+    const auto glut = make_color_lut<pixel_format::rgba8>(grad, opt);
+    glut.map(v, 10.0f, 30.0f, px.data());
+    require(is(6, 180,0,0,255), "rgba8: gamma");
+}
+
+
+
+//-------------------------------------------------------------------
+void rgba16f_test()
+{
+    //gray values; HDR values are not clamped
+    const auto nodes = piecewise_linear_map<double,double>{ {0.0, 0.0}, {1.0, 4.0} };
+    const auto grad = linear_gradient<double,double>{nodes.begin(), nodes.end()};
+    const auto lut = make_color_lut<pixel_format::rgba16f>(grad);
+
+    const std::vector<double> v {0.0, 0.25, 1.0};
+    std::vector<std::uint16_t> px(v.size() * 4);
+    lut.map(v, 0.0, 1.0, px.data());
+
+    using quantization::half_to_float;
+    require(half_to_float(px[0]) == 0.0f && half_to_float(px[3]) == 1.0f,
+            "rgba16f: first");
+    require(std::abs(half_to_float(px[4]) - 1.0f) < 1e-3f &&
+            half_to_float(px[5]) == half_to_float(px[6]), "rgba16f: gray");
+    require(half_to_float(px[8]) == 4.0f, "rgba16f: HDR");
+}
+
+
+
+//-------------------------------------------------------------------
+void image_test()
+{
+    const auto nodes = piecewise_constant_map<float,float>{
+        {0.0f, 0.0f}, {0.5f, 0.5f}, {1.0f, 1.0f} };
+    const auto grad = step_gradient<float,float>{nodes.begin(), nodes.end()};
+    const auto lut = make_color_lut<pixel_format::rgba8>(grad);
+
+    const std::size_t w = 1000, h = 300;
+    std::vector<float> field(w * h);
+    for(std::size_t i = 0; i < field.size(); ++i) {
+        field[i] = std::sin(0.001f * float(i));
+    }
+
+    std::vector<std::uint8_t> serial(w * h * 4), parallel(w * h * 4);
+    lut.map_image(field.data(), w, h, -1.0f, 1.0f, serial.data(), 1);
+    lut.map_image(field.data(), w, h, -1.0f, 1.0f, parallel.data(), 4);
+    require(serial == parallel, "image: parallel");
+
+    std::vector<std::uint8_t> flat(w * h * 4);
+    lut.map(field.data(), field.data() + field.size(), -1.0f, 1.0f, flat.data());
+    require(serial == flat, "image: rows");
+
+    //strided: left half of each row into a padded buffer
+    const std::size_t pad = 8;
+    std::vector<std::uint8_t> sub((w/2 * 4 + pad) * h);
+    lut.map_image(field.data(), w/2, h, w, -1.0f, 1.0f,
+                  sub.data(), w/2 * 4 + pad, 2);
+    for(std::size_t r = 0; r < h; ++r) {
+        require(std::equal(serial.begin() + r*w*4, serial.begin() + r*w*4 + w/2*4,
+                           sub.begin() + r*(w/2*4 + pad)), "image: strides");
+    }
+}
+
+
+
+//-------------------------------------------------------------------
+int main()
+{
+    try {
+        rgba8_test();
+        rgba16f_test();
+        image_test();
+    }
+    catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
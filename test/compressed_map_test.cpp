@@ -0,0 +1,118 @@
+/*****************************************************************************
+ *
+ * AM utilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+
+#include <stdexcept>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+#include "compressed_map.h"
+
+
+using namespace am;
+
+
+//-------------------------------------------------------------------
+template<class Compressed, class Map>
+void verify(int line, const Compressed& c, const Map& m,
+            double lo, double hi, double tol, std::size_t n = 10007)
+{
+    using std::abs;
+    using std::to_string;
+
+    for(std::size_t i = 0; i <= n; ++i) {
+        const double x = lo + (hi - lo) * double(i) / double(n);
+        if(abs(c(x) - m(x)) > tol) {
+            throw std::runtime_error{"line " + to_string(line) +
+                ": c(" + to_string(x) + ") = " + to_string(c(x)) +
+                " != " + to_string(m(x))};
+        }
+    }
+}
+
+
+
+
+//-------------------------------------------------------------------
+int main()
+{
+    using std::sin;
+
+    try {
+        using map_t = piecewise_linear_map<double,double>;
+
+        auto nodes = map_t::container_type{};
+        for(int i = 0; i < 100000; ++i) {
+            const double x = 0.01 * i + 0.001 * sin(double(i));
+            nodes.emplace_back(x, 100 * sin(0.05 * x));
+        }
+        const auto m = map_t{sorted_range, std::move(nodes)};
+
+        //16 bit keys & values
+        const auto c16 = compressed_map<double,double,
+                                        interpolator::piecewise_linear>{m};
+
+        if(c16.size() != m.size()) {
+            throw std::runtime_error{"compressed_map: wrong size"};
+        }
+        if(c16.memory_usage() * 3 > m.size() * sizeof(map_t::value_type)) {
+            throw std::runtime_error{"compressed_map: insufficient compression"};
+        }
+        if(c16.value_error() > 1e-2 || c16.key_error() > 1e-4) {
+            throw std::runtime_error{"compressed_map: error bound exceeded"};
+        }
+        verify(__LINE__, c16, m, 0, 999, 0.02);
+
+        //half precision values
+        const auto ch = compressed_map<double,double,
+                                       interpolator::piecewise_linear,
+                                       quantization::fixed<std::uint32_t>,
+                                       quantization::half>{m};
+        verify(__LINE__, ch, m, 0, 999, 0.1);
+
+        //integer keys within range are stored exactly
+        using imap_t = piecewise_constant_map<int,int>;
+        const auto im = imap_t{ {1,10}, {5,20}, {9,-3}, {200,7}, {70000,1} };
+        const auto ic = compressed_map<int,int,
+                                       interpolator::piecewise_constant,
+                                       quantization::fixed<std::uint16_t>,
+                                       quantization::fixed<std::uint16_t>,
+                                       2>{im};
+        if(ic.key_error() != 0 || ic.value_error() != 0) {
+            throw std::runtime_error{"compressed_map: integers not exact"};
+        }
+        for(int x = -5; x < 70010; x += 7) {
+            if(ic(x) != im(x)) {
+                throw std::runtime_error{"compressed_map: integer lookup failed"};
+            }
+        }
+
+        //close keys in a wide block must not collapse
+        const auto cm = map_t{ {0,0}, {1e-6,1}, {2e-6,2}, {1e6,3} };
+        const auto cc = compressed_map<double,double,
+                                       interpolator::piecewise_linear>{cm};
+        if(std::abs(cc(0.5e-6) - 0.5) > 1e-9 || std::abs(cc(1.5e-6) - 1.5) > 1e-9) {
+            throw std::runtime_error{"compressed_map: colliding keys"};
+        }
+        if(cc.exact_key_blocks() != 1 || cc.key_error() != 0) {
+            throw std::runtime_error{"compressed_map: exact key block"};
+        }
+        verify(__LINE__, cc, cm, -1, 2e6, 1e-6);
+        verify(__LINE__, cc, cm, 0, 3e-6, 1e-9, 997);
+        if(c16.exact_key_blocks() != 0) {
+            throw std::runtime_error{"compressed_map: unnecessary exact keys"};
+        }
+    }
+    catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,114 @@
+/*****************************************************************************
+ *
+ * AM utilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "copy_on_write.h"
+#include "gradients.h"
+#include "transforms.h"
+
+
+using namespace am;
+
+
+//-------------------------------------------------------------------
+void require(bool ok, const char* what)
+{
+    if(!ok) throw std::runtime_error{what};
+}
+
+
+
+//-------------------------------------------------------------------
+int main()
+{
+    try {
+        using map_t = copy_on_write<piecewise_linear_map<double,double>>;
+
+        //empty instances don't allocate
+        map_t e;
+        require(e.empty() && e.use_count() == 0, "empty");
+        require(e(1.0) == 0, "empty evaluation");
+
+        map_t a { {0,0}, {1,10}, {2,40} };
+        auto b = a;
+        require(a.shares_with(b) && a.use_count() == 2, "copies share");
+        require(&a.get() == &b.get(), "same map");
+
+        //first modification => private copy
+        b.insert({3,90});
+        require(!a.shares_with(b), "modified copy shares");
+        require(a.size() == 3 && b.size() == 4, "sizes after insert");
+        require(a(1.5) == 25 && b(2.5) == 65, "values after insert");
+
+        //sole owner => modified in place
+        const auto* before = &b.get();
+        b.erase(b.begin());
+        require(&b.get() == before && b.size() == 3, "in-place erase");
+
+        //iterators into the shared map
+        auto c = a;
+        c.erase(std::next(c.begin()), c.end());
+        require(c.size() == 1 && a.size() == 3, "range erase of shared map");
+
+        auto d = a;
+        d.clear();
+        require(d.empty() && a.size() == 3, "clear of shared map");
+        d.assign({ {5,5}, {6,6} });
+        require(d(5.5) == 5.5, "assign");
+
+        //shared derived node data
+        using llmap_t = copy_on_write<piecewise_log_log_map<double,double>>;
+        llmap_t ll { {1,1}, {10,100}, {100,10000} };
+        auto ll2 = ll;
+        ll2.insert({1000, 1e6});
+        require(std::abs(ll(50) - 2500) < 1e-9, "log-log original");
+        require(std::abs(ll2(500) - 250000) < 1e-6, "log-log copy");
+
+        //gradients
+        const auto g = shared_linear_gradient<double,double>{
+                           a.begin(), a.end()};
+        std::vector<shared_linear_gradient<double,double>> gs(1000, g);
+        for(const auto& x : gs) {
+            require(x.shares_nodes_with(g), "gradient copies share");
+        }
+        require(g(1.5) == 25 && g.min() == 0 && g.max() == 40, "gradient");
+
+        const auto u = linear_gradient<double,double>{a.begin(), a.end()};
+        const auto u2 = u;
+        require(!u.shares_nodes_with(u2), "unique gradient copies share");
+
+        //concurrent copies, reads and private modifications
+        std::atomic<bool> failed{false};
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 8; ++t) {
+            threads.emplace_back([&a,&failed,t] {
+                for(int i = 0; i < 1000; ++i) {
+                    auto x = a;
+                    if(x(1.5) != 25) failed = true;
+                    x.insert({2.0 + t, 0.0});
+                    if(x.size() != 4 || a.size() != 3) failed = true;
+                }
+            });
+        }
+        for(auto& t : threads) t.join();
+        require(!failed && a.use_count() == 1, "concurrent copies");
+    }
+    catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,193 @@
+/*****************************************************************************
+ *
+ * AM utilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "fixed_point.h"
+
+
+using namespace am;
+
+
+//-------------------------------------------------------------------
+void require(bool ok, const std::string& what)
+{
+    if(!ok) throw std::runtime_error{what};
+}
+
+
+
+//-------------------------------------------------------------------
+/// exact linear interpolant (x in [k0,k1])
+long double exact(std::int64_t k0, std::int64_t v0,
+                  std::int64_t k1, std::int64_t v1, std::int64_t x)
+{
+    const long double t = (long double)(x - k0) / (long double)(k1 - k0);
+    return (long double)v0 + t * (long double)(v1 - v0);
+}
+
+
+//-------------------------------------------------------------------
+/// exact linear interpolant rounded to nearest (ties up)
+std::int64_t rounded(std::int64_t k0, std::int64_t v0,
+                     std::int64_t k1, std::int64_t v1, std::int64_t x)
+{
+#ifdef AMLIB_HAS_INT128
+    __extension__ typedef __int128 i128;
+    const i128 num = 2 * i128(v1 - v0) * i128(x - k0) + i128(k1 - k0);
+    const i128 den = 2 * i128(k1 - k0);
+    i128 q = num / den;
+    if(num % den != 0 && num < 0) --q;  //floor
+    return std::int64_t(v0 + q);
+#else
+    return std::int64_t(std::floor(exact(k0, v0, k1, v1, x) + 0.5L));
+#endif
+}
+
+
+
+//-------------------------------------------------------------------
+int main()
+{
+    try {
+        using map_t = fixed_point_linear_map<std::int64_t,std::int32_t>;
+
+        //rounding to nearest
+        const auto m = map_t{ {0,0}, {3,10}, {6,-10} };
+        require(m(1) == 3 && m(2) == 7 && m(3) == 10, "rounding up");
+        require(m(4) == 3 && m(5) == -3 && m(6) == -10, "rounding down");
+        //clamp extrapolation (default)
+        require(m(-5) == 0 && m(100) == -10, "clamp");
+
+        //linear extrapolation
+        using lin_t = interpolating_map<std::int64_t,std::int32_t,
+            interpolator::basic_fixed_point_linear<extrapolation::linear>>;
+        const auto l = lin_t{ {0,0}, {3,10} };
+        require(l(-3) == -10 && l(6) == 20, "linear extrapolation");
+
+        //ns timestamp keys, ADC-like values
+        std::mt19937_64 urng{42};
+        std::uniform_int_distribution<std::int64_t> dk{1, 4000000000LL};
+        std::uniform_int_distribution<std::int32_t> dv{-50000, 50000};
+
+        std::vector<std::pair<std::int64_t,std::int32_t>> nodes;
+        std::int64_t k = 1500000000000000000LL;
+        std::int32_t v = 0;
+        for(int i = 0; i < 1000; ++i) {
+            nodes.emplace_back(k, v);
+            k += dk(urng);
+            v += dv(urng);
+        }
+        const auto big = map_t(nodes.begin(), nodes.end());
+        const auto ipl = big.interpolator();
+
+        for(std::size_t i = 1; i < nodes.size(); ++i) {
+            const auto& p0 = nodes[i-1];
+            const auto& p1 = nodes[i];
+            for(int j = 0; j <= 16; ++j) {
+                const auto x = p0.first + (p1.first - p0.first) * j / 16;
+                const auto e = rounded(p0.first, p0.second, p1.first, p1.second, x);
+                const auto r = big(x);
+                require(r == e,
+                    "exactness at " + std::to_string(x) + ": " +
+                    std::to_string(r) + " != " + std::to_string(e));
+                require(ipl(nodes.begin(), nodes.end(), x) == r,
+                        "cached != uncached");
+            }
+        }
+
+        //value updates only recompute adjacent segments
+        {
+            auto u = big;
+            const auto shared = u;
+            const auto vals = std::vector<std::int32_t>{7, -7, 70000};
+            u.assign_values(500, vals.begin(), vals.end());
+            u.transform_values(0, 2, [](std::int64_t, std::int32_t v) {
+                return v / 2; });
+            u.assign_values(u.size() - 1, {123});
+            const auto fresh = map_t(u.begin(), u.end());
+            for(std::size_t i = 1; i < u.size(); ++i) {
+                const auto x = (u[i-1].first + u[i].first) / 2;
+                require(u(x) == fresh(x), "refreshed segments");
+                require(shared(x) == big(x), "shared cache modified");
+            }
+        }
+
+        //single node insert/erase only recompute adjacent segments
+        {
+            auto u = big;
+            u.erase(u.begin());
+            u.erase(std::prev(u.end()));
+            u.erase(std::next(u.begin(), 100), std::next(u.begin(), 110));
+            u.insert({nodes[300].first + 1, 12345});
+            u.insert(nodes.front());
+            const auto fresh = map_t(u.begin(), u.end());
+            for(std::size_t i = 1; i < u.size(); ++i) {
+                const auto x = (u[i-1].first + u[i].first) / 2;
+                require(u(x) == fresh(x), "spliced segments");
+            }
+        }
+
+        //std::chrono keys and values
+        using namespace std::chrono;
+        using tp_t = time_point<system_clock,nanoseconds>;
+        using tmap_t = fixed_point_linear_map<tp_t,milliseconds>;
+
+        const auto t0 = tp_t{seconds{1700000000}};
+        const auto tm = tmap_t{ {t0, milliseconds{0}},
+                                {t0 + seconds{10}, milliseconds{1000}} };
+        require(tm(t0 + seconds{5}) == milliseconds{500}, "chrono midpoint");
+        require(tm(t0 + nanoseconds{1}) == milliseconds{0}, "chrono start");
+        require(tm(t0 - hours{1}) == milliseconds{0}, "chrono clamp");
+
+        //too large differences
+        bool thrown = false;
+        try {
+            fixed_point_linear_map<int,std::int64_t>{
+                {0,0}, {1, std::numeric_limits<std::int64_t>::max()} };
+        }
+        catch(std::overflow_error&) { thrown = true; }
+        require(thrown, "no overflow_error");
+
+        //large value differences
+        const auto w = fixed_point_linear_map<std::int64_t,std::int64_t>{
+                           {0,0}, {1000, 1LL << 50} };
+        require(w(500) == (1LL << 49), "wide values");
+
+        //wide, non-power-of-two segments: exactly rounded
+        using wide_t = fixed_point_linear_map<long long,long long>;
+        const auto h = wide_t{ {0,0}, {3600000000000LL, 3000000000LL} };
+        require(h(3599999999999LL) == 3000000000LL, "wide segment end");
+        const long long hk = 3600000000000LL;
+        const long long hv = (1LL << 58) + 12345;
+        const auto hn = wide_t{ {-7, hv}, {hk - 7, -hv} };
+        for(long long x = -7; x <= hk - 7; x += 999999999937LL / 1000) {
+            for(long long d : {0LL, 1LL, 2LL}) {
+                require(h(x + d) == rounded(0, 0, hk, 3000000000LL, x + d),
+                        "wide segment at " + std::to_string(x + d));
+                require(hn(x + d) == rounded(-7, hv, hk - 7, -hv, x + d),
+                        "wide falling segment at " + std::to_string(x + d));
+            }
+        }
+    }
+    catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,109 @@
+/*****************************************************************************
+ *
+ * AM utilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "interning.h"
+
+
+using namespace am;
+
+
+//-------------------------------------------------------------------
+void require(bool ok, const char* what)
+{
+    if(!ok) throw std::runtime_error{what};
+}
+
+
+
+//-------------------------------------------------------------------
+int main()
+{
+    try {
+        using map_t = piecewise_linear_map<double,double>;
+        using registry_t = interning_registry<map_t>;
+
+        registry_t reg;
+
+        const auto a = reg.intern(map_t{ {0,0}, {1,10}, {2,40} });
+        const auto b = reg.intern(map_t{ {0,0}, {1,10}, {2,40} });
+        const auto c = reg.intern(map_t{ {0,0}, {1,10}, {2,41} });
+        const auto d = reg.intern(map_t{ {0,0}, {1,10} });
+
+        require(a.shares_with(b), "identical nodes not shared");
+        require(!a.shares_with(c) && !a.shares_with(d), "different nodes");
+        require(a(1.5) == 25 && c(1.5) == 25.5, "values");
+
+        auto s = reg.stats();
+        const auto node = sizeof(map_t::value_type);
+        require(s.requests == 4 && s.hits == 1 && s.tables == 3, "counts");
+        require(s.references == 4, "references");
+        require(s.bytes_saved() == 3 * node, "bytes saved");
+
+        //modifying an interned map never changes the canonical storage
+        {
+            auto e = reg.intern(map_t{ {0,0}, {1,10}, {2,40} });
+            require(e.shares_with(a), "intern hit");
+            e.insert({3,0});
+            require(!e.shares_with(a) && a.size() == 3, "modified interned");
+
+            auto f = reg.intern(map_t{ {5,5} });
+            f.insert({6,6});
+            require(reg.intern(map_t{ {5,5} }).size() == 1, "sole owner");
+        }
+
+        //expired entries
+        {
+            const auto tmp = reg.intern(map_t{ {7,7}, {8,8} });
+            require(reg.stats().tables == 4, "tables before expiry");
+        }
+        reg.purge();
+        require(reg.stats().tables == 3, "tables after purge");
+
+        //gradients
+        const auto g1 = linear_gradient<double,double>{a.begin(), a.end()};
+        const auto g2 = reg.intern(g1);
+        const auto g3 = reg.intern(g1);
+        require(g2.shares_nodes_with(g3), "gradients not shared");
+        require(&g2.map() == &a.get(), "gradient and map not shared");
+        require(g2(0.5) == 5, "gradient value");
+
+        //concurrent interning
+        auto& global = registry_t::global();
+        std::vector<map_t::value_type> nodes;
+        for(int i = 0; i < 1000; ++i) nodes.emplace_back(i, i * i);
+
+        std::vector<registry_t::value_type> interned(8);
+        std::vector<std::thread> threads;
+        for(std::size_t t = 0; t < interned.size(); ++t) {
+            threads.emplace_back([&,t] {
+                for(int i = 0; i < 100; ++i) {
+                    interned[t] = global.intern(map_t(nodes.begin(), nodes.end()));
+                }
+            });
+        }
+        for(auto& t : threads) t.join();
+        for(const auto& m : interned) {
+            require(m.shares_with(interned.front()), "concurrent interning");
+        }
+        s = global.stats();
+        require(s.tables == 1 && s.bytes_saved() == 7 * 1000 * node,
+                "global registry stats");
+    }
+    catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -13,6 +13,8 @@
 #include <cmath>
 #include <iostream>
 #include <string>
+#include <limits>
+#include <vector>
 
 #include "interpolating_map.h"
 
@@ -55,6 +57,194 @@ void verify(int line, const Nodes& nodes, const Expected& expected)
 
 
 
+//-------------------------------------------------------------------
+void instrumentation_test()
+{
+    struct tag {};
+    using counters = instrumentation::counting<tag,4>;
+    using map_t = interpolating_map<double,double,interpolator::piecewise_linear,
+                                    std::less<double>,
+                                    std::allocator<std::pair<double,double>>,
+                                    counters>;
+
+    counters::reset();
+
+    auto map = map_t{ {0.0,0.0}, {1.0,1.0}, {2.0,4.0} };
+    map(-1.0);
+    map(0.5);
+    map(1.5);
+    map(3.0);
+
+    const auto s = counters::snapshot();
+
+    if(s.evaluations != 4 || s.extrapolations_left != 1 ||
+       s.extrapolations_right != 1 || s.rebuilds != 1 ||
+       s.searches < 4 || s.comparisons < s.searches ||
+       s.histogram[0] != 1 || s.histogram[2] != 1 ||
+       s.histogram[4] != 1 || s.histogram[5] != 1)
+    {
+        throw std::runtime_error{"instrumentation: unexpected counter values"};
+    }
+
+    counters::reset();
+    if(counters::snapshot().evaluations != 0) {
+        throw std::runtime_error{"instrumentation: reset failed"};
+    }
+}
+
+
+
+
+//-------------------------------------------------------------------
+void extrapolation_test()
+{
+    using namespace am::interpolator;
+
+    using nodes_t = std::vector<std::pair<double,double>>;
+    const auto nodes = nodes_t{ {1,1}, {2,4}, {4,0} };
+
+    const auto keys = std::vector<double>{ -1, 0.5, 1, 1.5, 3, 4, 5 };
+
+    auto check = [&](int line, auto ipl, const std::vector<double>& expected) {
+        using ipl_t = decltype(ipl);
+        auto map = interpolating_map<double,double,ipl_t>{
+                       nodes.begin(), nodes.end(), ipl};
+
+        auto batch = std::vector<double>(keys.size());
+        map.evaluate(keys.begin(), keys.end(), batch.begin());
+
+        for(std::size_t i = 0; i < keys.size(); ++i) {
+            const auto v = map(keys[i]);
+            const bool same = (std::isnan(v) && std::isnan(expected[i])) ||
+                              std::abs(v - expected[i]) < eps<double>;
+            const bool sameBatch = (std::isnan(v) && std::isnan(batch[i])) ||
+                                   std::abs(v - batch[i]) < eps<double>;
+            if(!same || !sameBatch) {
+                throw std::runtime_error{"line " + std::to_string(line) +
+                    ": extrapolation mismatch at key #" + std::to_string(i)};
+            }
+        }
+    };
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    check(__LINE__, piecewise_linear{},
+          {-5, -0.5, 1, 2.5, 2, 0, -2});
+    check(__LINE__, basic_piecewise_linear<extrapolation::clamp>{},
+          {1, 1, 1, 2.5, 2, 0, 0});
+    check(__LINE__, basic_piecewise_linear<extrapolation::nan>{},
+          {nan, nan, 1, 2.5, 2, 0, nan});
+    check(__LINE__, basic_piecewise_linear<extrapolation::constant<double>>{
+                        extrapolation::constant<double>{7}},
+          {7, 7, 1, 2.5, 2, 0, 7});
+    check(__LINE__, piecewise_constant{},
+          {1, 1, 1, 1, 4, 0, 0});
+    check(__LINE__, basic_piecewise_constant<extrapolation::nan>{},
+          {nan, nan, 1, 1, 4, 0, nan});
+
+    auto checked = interpolating_map<double,double,
+        basic_piecewise_linear<extrapolation::checked>>{nodes.begin(), nodes.end()};
+    bool thrown = false;
+    try { checked(0.5); } catch(std::out_of_range&) { thrown = true; }
+    if(!thrown || checked(1.5) != 2.5) {
+        throw std::runtime_error{"checked extrapolation failed"};
+    }
+}
+
+
+
+
+//-------------------------------------------------------------------
+void precision_test()
+{
+    using namespace am::interpolator;
+
+    const auto nodes = std::vector<std::pair<float,float>>{
+                           {1.f,1.f}, {2.f,4.f}, {4.f,16.f} };
+    const auto b = nodes.begin();
+    const auto e = nodes.end();
+
+    //default: float data computed in double
+    static_assert(std::is_same<double,
+        decltype(piecewise_linear{}(b, e, 3.f))>::value, "promote");
+
+    //float stays float
+    using flin = basic_piecewise_linear<extrapolation::linear,precision::storage>;
+    using flog = basic_piecewise_log_linear<extrapolation::linear,precision::storage>;
+    static_assert(std::is_same<float, decltype(flin{}(b, e, 3.f))>::value,
+                  "storage precision (linear)");
+    static_assert(std::is_same<float, decltype(flog{}(b, e, 3.f))>::value,
+                  "storage precision (log-linear)");
+
+    //explicit compute type
+    using llin = basic_piecewise_linear<extrapolation::linear,
+                                        precision::fixed<long double>>;
+    static_assert(std::is_same<long double,
+        decltype(llin{}(b, e, 3.f))>::value, "fixed precision");
+
+    if(flin{}(b, e, 3.f) != 10.f || llin{}(b, e, 3.f) != 10.0L ||
+       std::abs(flog{}(b, e, 3.f) - 11.019550f) > eps<float>)
+    {
+        throw std::runtime_error{"precision policies: wrong values"};
+    }
+
+    //maps and batch evaluation
+    const auto m = interpolating_map<float,float,flin>{b, e};
+    const auto keys = std::vector<float>{0.5f, 1.5f, 3.f, 5.f};
+    std::vector<float> batch(keys.size());
+    m.evaluate(keys.begin(), keys.end(), batch.begin());
+    for(std::size_t i = 0; i < keys.size(); ++i) {
+        if(batch[i] != m(keys[i]) || batch[i] != flin{}(b, e, keys[i])) {
+            throw std::runtime_error{"precision policies: batch mismatch"};
+        }
+    }
+}
+
+
+
+//-------------------------------------------------------------------
+void value_update_test()
+{
+    struct tag {};
+    using counters = instrumentation::counting<tag>;
+    using map_t = interpolating_map<double,double,interpolator::piecewise_linear,
+                                    std::less<double>,
+                                    std::allocator<std::pair<double,double>>,
+                                    counters>;
+
+    auto map = map_t{ {0.0,0.0}, {1.0,1.0}, {2.0,4.0}, {3.0,9.0} };
+    const auto copy = map;
+    const auto v0 = map.version();
+
+    const auto vals = std::vector<double>{10, 20};
+    map.assign_values(1, vals.begin(), vals.end());
+    if(map[1].second != 10 || map[2].second != 20 || map(1.5) != 15 ||
+       map.version() == v0 || copy(1.5) != 2.5)
+    {
+        throw std::runtime_error{"assign_values: wrong values"};
+    }
+
+    map.transform_values([](double k, double v) { return v + k; });
+    if(map[0].second != 0 || map[3].second != 12 || map(2.5) != 17) {
+        throw std::runtime_error{"transform_values: wrong values"};
+    }
+
+    map.assign_values(3, {-1.0});
+    if(map(3.0) != -1 || map.size() != 4) {
+        throw std::runtime_error{"assign_values: single value"};
+    }
+
+    bool thrown = false;
+    try { map.assign_values(3, {1.0, 2.0}); }
+    catch(std::out_of_range&) { thrown = true; }
+    if(!thrown || map(3.0) != -1) {
+        throw std::runtime_error{"assign_values: range not checked"};
+    }
+}
+
+
+
+
 //-------------------------------------------------------------------
 int main()
 {
@@ -107,6 +297,11 @@ int main()
         verify<piecewise_log_linear>(__LINE__, nodes2dbl, dblvec{
             {-1000.123,1}, {-1.4,1}, {0,1},
             {1,1}, {1.5, 2.584821}, {1123.54,28.455297} });
+
+        instrumentation_test();
+        extrapolation_test();
+        precision_test();
+        value_update_test();
     }
     catch(std::exception& e) {
         std::cerr << e.what() << std::endl;
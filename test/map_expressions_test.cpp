@@ -0,0 +1,173 @@
+/*****************************************************************************
+ *
+ * AM utilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+
+#include <stdexcept>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "map_expressions.h"
+
+
+using namespace am;
+
+
+//-------------------------------------------------------------------
+template<class Expr, class Expected>
+void verify(int line, const Expr& e, Expected&& expected,
+            const std::vector<double>& xs)
+{
+    using std::abs;
+
+    auto ys = std::vector<double>(xs.size());
+    e.evaluate(xs.begin(), xs.end(), ys.begin());
+
+    for(std::size_t i = 0; i < xs.size(); ++i) {
+        const double x = xs[i];
+        const double ex = expected(x);
+        if(abs(e(x) - ex) > 1e-12 || abs(ys[i] - ex) > 1e-12) {
+            throw std::runtime_error{"line " + std::to_string(line) +
+                ": e(" + std::to_string(x) + ") = " + std::to_string(ys[i]) +
+                " != " + std::to_string(ex)};
+        }
+    }
+}
+
+
+
+
+//-------------------------------------------------------------------
+/// key type that counts comparisons
+int key_comparisons = 0;
+
+struct counted_key {
+    double v;
+    friend bool operator < (counted_key a, counted_key b) {
+        ++key_comparisons;
+        return a.v < b.v;
+    }
+};
+
+
+//-------------------------------------------------------------------
+/// the key axes are only compared after a map was modified
+void key_axis_recheck_test()
+{
+    using map_t = piecewise_constant_map<counted_key,double>;
+
+    auto a = map_t{};
+    auto b = map_t{};
+    for(int i = 0; i < 1000; ++i) {
+        a.insert({counted_key{double(i)}, double(i)});
+        b.insert({counted_key{double(i)}, double(-i)});
+    }
+    const auto e = 2.0 * a + b - a * b;
+
+    auto xs = std::vector<counted_key>{};
+    for(int i = 0; i < 100; ++i) xs.push_back(counted_key{i * 9.5});
+    auto ys = std::vector<double>(xs.size());
+
+    b.erase(counted_key{500.0});
+    b.insert({counted_key{500.0}, 1.0});
+
+    auto batch = [&] {
+        key_comparisons = 0;
+        e.evaluate(xs.begin(), xs.end(), ys.begin());
+        return key_comparisons;
+    };
+    const int first = batch();
+    const int second = batch();
+    if(second >= first || batch() != second) {
+        throw std::runtime_error{"expression: key axes compared per batch"};
+    }
+    for(std::size_t i = 0; i < xs.size(); ++i) {
+        const auto x = xs[i];
+        if(ys[i] != 2 * a(x) + b(x) - a(x) * b(x)) {
+            throw std::runtime_error{"expression: modified map"};
+        }
+    }
+}
+
+
+
+//-------------------------------------------------------------------
+int main()
+{
+    using lin_map = piecewise_linear_map<double,double>;
+    using const_map = piecewise_constant_map<double,double>;
+
+    try {
+        auto xs = std::vector<double>{};
+        for(int i = -30; i <= 130; ++i) xs.push_back(0.1 * i);
+        auto shuffled = xs;
+        for(std::size_t i = 0; i < shuffled.size(); ++i) {
+            std::swap(shuffled[i], shuffled[(i * 104729) % shuffled.size()]);
+        }
+
+        //different key axes
+        const auto f = lin_map{ {0,1}, {1,3}, {2,2}, {4,0}, {5,1}, {7,7} };
+        const auto g = lin_map{ {-1,2}, {0.5,0}, {3,3}, {9,1} };
+        const auto h = const_map{ {0,1}, {2,5}, {2,-1}, {6,2} };
+
+        const auto e1 = 0.5 * f + 2 * g - h;
+        auto ex1 = [&](double x) { return 0.5 * f(x) + 2 * g(x) - h(x); };
+        verify(__LINE__, e1, ex1, xs);
+        verify(__LINE__, e1, ex1, shuffled);
+
+        const auto e2 = -(f * g) / (lazy(h) + 10.0);
+        auto ex2 = [&](double x) { return -(f(x) * g(x)) / (h(x) + 10.0); };
+        verify(__LINE__, e2, ex2, xs);
+
+        //shared key axis (incl. duplicate keys)
+        const auto a = lin_map{ {0,1}, {1,3}, {2,2}, {2,6}, {4,0} };
+        const auto b = lin_map{ {0,5}, {1,-3}, {2,1}, {2,0}, {4,2} };
+        const auto c = const_map{ {0,5}, {1,-3}, {2,1}, {2,0}, {4,2} };
+        if(!(a + b + c).shared_key_axis() || !(2.0 * (a - b)).shared_key_axis()) {
+            throw std::runtime_error{"expression: key axis not shared"};
+        }
+        if((a + f).shared_key_axis() || (2.0 * a).shared_key_axis()) {
+            throw std::runtime_error{"expression: key axis wrongly shared"};
+        }
+
+        //modified maps are re-checked
+        auto d = b;
+        const auto ad = a + d;
+        if(!ad.shared_key_axis()) {
+            throw std::runtime_error{"expression: copies not shared"};
+        }
+        d.insert({3.0, 1.0});
+        if(ad.shared_key_axis()) {
+            throw std::runtime_error{"expression: modified map still shared"};
+        }
+        verify(__LINE__, ad, [&](double x) { return a(x) + d(x); }, xs);
+        auto ex3 = [&](double x) { return a(x) - 3 * b(x) * c(x); };
+        verify(__LINE__, a - 3 * b * c, ex3, xs);
+        verify(__LINE__, a - 3 * b * c, ex3, shuffled);
+        auto keys = std::vector<double>{0, 1, 2, 4, 2, 1, 0};
+        verify(__LINE__, a - 3 * b * c, ex3, keys);
+
+        //callables and gradients
+        const auto gnodes = std::vector<std::pair<double,double>>{
+                                {0.0,0.0}, {1.0,2.0} };
+        const auto grad = linear_gradient<double,double>{
+                              gnodes.begin(), gnodes.end()};
+        const auto sq = [](double x) { return x * x; };
+        auto ex4 = [&](double x) { return grad(x) * sq(x) + f(x); };
+        verify(__LINE__, lazy(grad) * lazy(sq) + f, ex4, xs);
+
+        key_axis_recheck_test();
+    }
+    catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,115 @@
+/*****************************************************************************
+ *
+ * AM utilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+
+#include <stdexcept>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <type_traits>
+
+#include "allocators.h"
+#include "map_operations.h"
+
+
+using namespace am;
+
+using lin_map = piecewise_linear_map<double,double>;
+using const_map = piecewise_constant_map<double,double>;
+
+
+//-------------------------------------------------------------------
+template<class Map, class Expected>
+void verify(int line, const Map& map, Expected&& expected,
+            double lo, double hi, std::size_t n = 997)
+{
+    using std::abs;
+    using std::to_string;
+
+    for(std::size_t i = 0; i <= n; ++i) {
+        const double x = lo + (hi - lo) * double(i) / double(n);
+        const double e = expected(x);
+        if(abs(map(x) - e) > 1e-9) {
+            throw std::runtime_error{"line " + to_string(line) +
+                ": h(" + to_string(x) + ") = " + to_string(map(x)) +
+                " != " + to_string(e)};
+        }
+    }
+}
+
+
+
+
+//-------------------------------------------------------------------
+int main()
+{
+    try {
+        const auto f = lin_map{ {0,0}, {1,2}, {3,-1}, {4,5}, {7,0} };
+        const auto g = lin_map{ {-1,1}, {0.5,3}, {2,2}, {2.5,-2}, {6,1} };
+
+        //linear combinations are exact everywhere
+        const auto h1 = linear_combination(2.0, f, -0.5, g);
+        verify(__LINE__, h1, [&](double x) { return 2*f(x) - 0.5*g(x); }, -3, 9);
+        if(h1.size() != f.size() + g.size()) {
+            throw std::runtime_error{"linear combination: wrong node count"};
+        }
+
+        const auto h2 = sum(f, g);
+        verify(__LINE__, h2, [&](double x) { return f(x) + g(x); }, -3, 9);
+
+        const auto h3 = difference(f, g);
+        verify(__LINE__, h3, [&](double x) { return f(x) - g(x); }, -3, 9);
+
+        //product: exact at nodes
+        const auto h4 = product(f, g);
+        for(const auto& n : h4) {
+            if(std::abs(n.second - f(n.first) * g(n.first)) > 1e-9) {
+                throw std::runtime_error{"product: wrong node value"};
+            }
+        }
+
+        //min/max: exact within node range due to crossing points
+        const auto h5 = pointwise_min(f, g);
+        verify(__LINE__, h5, [&](double x) { return std::min(f(x), g(x)); }, -1, 7);
+
+        const auto h6 = pointwise_max(f, g);
+        verify(__LINE__, h6, [&](double x) { return std::max(f(x), g(x)); }, -1, 7);
+
+        //step functions
+        const auto s1 = const_map{ {0,1}, {2,3}, {5,0} };
+        const auto s2 = const_map{ {1,1}, {2,1}, {4,2} };
+        const auto s3 = sum(s1, s2);
+        verify(__LINE__, s3, [&](double x) { return s1(x) + s2(x); }, -2, 7);
+
+        //composition: exact within g's node range
+        const auto c = compose(f, g);
+        verify(__LINE__, c, [&](double x) { return f(g(x)); }, -1, 6);
+
+        //composition keeps g's allocator
+        struct compose_tag {};
+        using alloc_t = tracking_allocator<std::pair<const double,double>,compose_tag>;
+        using tracked_map = interpolating_map<double,double,interpolator::piecewise_linear,
+                                              std::less<double>,alloc_t>;
+        const auto tg = tracked_map(g.begin(), g.end());
+        const auto before = allocation_counter<compose_tag>::snapshot().live_bytes;
+        const auto tc = compose(f, tg);
+        static_assert(std::is_same<decltype(tc),const tracked_map>::value,
+                      "compose: result must use g's allocator");
+        if(allocation_counter<compose_tag>::snapshot().live_bytes <= before) {
+            throw std::runtime_error{"compose: allocator not used"};
+        }
+        verify(__LINE__, tc, [&](double x) { return f(g(x)); }, -1, 6);
+
+    }
+    catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,111 @@
+/*****************************************************************************
+ *
+ * AM utilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "copy_on_write.h"
+#include "gradients.h"
+#include "memoization.h"
+
+
+using namespace am;
+
+
+//-------------------------------------------------------------------
+void require(bool ok, const char* what)
+{
+    if(!ok) throw std::runtime_error{what};
+}
+
+
+
+//-------------------------------------------------------------------
+int main()
+{
+    try {
+        struct tag {};
+        using probe_t = instrumentation::counting<tag>;
+        using map_t = piecewise_linear_map<double,double,std::less<double>,
+                std::allocator<std::pair<const double,double>>, probe_t>;
+        using memo_t = memoized<map_t>;
+
+        map_t m { {0,0}, {1,10}, {2,40} };
+        const auto f = memoize(m);
+
+        probe_t::reset();
+        memo_t::reset_thread_stats();
+
+        require(f(0.5) == 5 && f(1.5) == 25, "values");
+        require(f(0.5) == 5 && f(1.5) == 25 && f(0.5) == 5, "memoized values");
+        auto s = memo_t::thread_stats();
+        require(s.misses == 2 && s.hits == 3, "thread stats");
+        const auto c0 = probe_t::thread_snapshot();
+        require(c0.cache_misses == 2 && c0.cache_hits == 3, "instrumentation");
+        require(c0.evaluations == 2, "evaluations");
+
+        //modifications invalidate memoized results
+        m.insert({0.5, 0});
+        require(f(0.5) == 0, "stale value after insert");
+        m.erase(m.begin());
+        require(f(0.5) == 0 && f(1.5) == 25, "stale value after erase");
+
+        //copies share results, modified copies don't
+        auto m2 = m;
+        require(m2.version() == m.version(), "copy version");
+        m2.insert({1.5, -1});
+        require(m2.version() != m.version(), "modified copy version");
+        require(memoize(m2)(1.5) == -1 && f(1.5) == 25, "modified copy");
+
+        //copy_on_write storage
+        const auto c = copy_on_write<map_t>{ {0,0}, {4,4} };
+        const auto fc = memoize(c);
+        require(fc(1) == 1 && fc(1) == 1, "copy_on_write");
+
+        //gradients
+        const auto gn = piecewise_linear_map<float,double>{ {0.f,0.0}, {1.f,1.0} };
+        const auto g = linear_gradient<float,double>{gn.begin(), gn.end()};
+        const auto fg = memoize(g);
+        using gmemo_t = memoized<linear_gradient<float,double>>;
+        gmemo_t::reset_thread_stats();
+        require(fg(0.25f) == 0.25 && fg(0.25f) == 0.25, "gradient");
+        require(gmemo_t::thread_stats().hits == 1 &&
+                gmemo_t::thread_stats().misses == 1, "gradient stats");
+
+        const auto h = shared_linear_gradient<float,double>{gn.begin(), gn.end()};
+        require(memoize(h)(0.5f) == 0.5, "shared gradient");
+
+        //per-thread tables
+        const auto cm = m;
+        std::vector<std::thread> threads;
+        std::vector<int> ok(4, 0);
+        for(std::size_t t = 0; t < ok.size(); ++t) {
+            threads.emplace_back([&,t] {
+                const auto ft = memoize<16>(cm);
+                bool good = true;
+                for(int i = 0; i < 10000; ++i) {
+                    const double x = (i % 32) * 0.0625;
+                    good = good && ft(x) == cm(x);
+                }
+                const auto st = memoized<map_t,16>::thread_stats();
+                ok[t] = good && (st.hits + st.misses == 10000);
+            });
+        }
+        for(auto& t : threads) t.join();
+        for(auto x : ok) require(x != 0, "concurrent memoization");
+    }
+    catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,126 @@
+/*****************************************************************************
+ *
+ * AM utilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "allocators.h"
+#include "copy_on_write.h"
+#include "time_series_map.h"
+#include "transforms.h"
+
+
+using namespace am;
+
+
+//-------------------------------------------------------------------
+void require(bool ok, const char* what)
+{
+    if(!ok) throw std::runtime_error{what};
+}
+
+
+
+//-------------------------------------------------------------------
+int main()
+{
+    try {
+        using node_t = std::pair<double,double>;
+        constexpr auto node = sizeof(node_t);
+
+        //vector_map
+        vector_map<double,double> vm;
+        vm.reserve(100);
+        require(vm.capacity() >= 100, "vector_map: reserve");
+        vm.insert({1.0, 2.0});
+        auto f = vm.footprint();
+        require(f.nodes == node && f.slack == (vm.capacity() - 1) * node &&
+                f.total() == vm.capacity() * node, "vector_map: footprint");
+        vm.shrink_to_fit();
+        require(vm.footprint().slack == 0, "vector_map: shrink_to_fit");
+
+        //interpolating_map without derived data
+        auto lin = piecewise_linear_map<double,double>{};
+        lin.reserve(1000);
+        for(int i = 0; i < 10; ++i) lin.insert({double(i), double(i)});
+        require(lin.capacity() >= 1000 && lin.footprint().cache == 0,
+                "linear: reserve");
+        lin.shrink_to_fit();
+        require(lin.footprint().nodes == 10 * node &&
+                lin.footprint().slack == 0 && lin(2.5) == 2.5,
+                "linear: shrink_to_fit");
+
+        //derived node data
+        auto ll = piecewise_log_log_map<double,double>{};
+        for(int i = 1; i <= 1000; ++i) ll.insert({double(i), double(i * i)});
+        for(int i = 1; i <= 900; ++i) ll.erase(double(i));
+        f = ll.footprint();
+        require(f.nodes == 100 * node && f.slack > 0 && f.cache >= 100 * node,
+                "log-log: footprint");
+        ll.shrink_to_fit();
+        f = ll.footprint();
+        require(f.slack == 0 && f.cache == 100 * node, "log-log: shrink_to_fit");
+        require(std::abs(ll(950.5) - 950.5 * 950.5) < 1e-6, "log-log: values");
+
+        //copy_on_write reports the shared map
+        const auto c1 = copy_on_write<piecewise_linear_map<double,double>>{lin};
+        const auto c2 = c1;
+        require(c2.footprint().total() == lin.footprint().total() &&
+                c2.capacity() == 10, "copy_on_write: footprint");
+
+        //time series: evicted nodes are slack
+        auto ts = time_series_map<int,double,interpolator::piecewise_linear,
+                                  eviction::capacity>{eviction::capacity{10}};
+        for(int i = 0; i < 100; ++i) ts.insert({i, double(i)});
+        f = ts.footprint();
+        require(f.nodes == 10 * sizeof(std::pair<int,double>) &&
+                f.total() == ts.capacity() * sizeof(std::pair<int,double>),
+                "time series: footprint");
+
+        //process-wide aggregation
+        struct tag {};
+        using counter_t = allocation_counter<tag>;
+        using alloc_t = tracking_allocator<std::pair<const double,double>,tag>;
+        using tracked_t = interpolating_map<double,double,
+            interpolator::piecewise_linear,std::less<double>,alloc_t>;
+        {
+            auto t = tracked_t{};
+            t.reserve(64);
+            require(counter_t::snapshot().live_bytes == 64 * node,
+                    "tracking: reserve");
+
+            std::vector<std::thread> threads;
+            for(int k = 0; k < 4; ++k) {
+                threads.emplace_back([] {
+                    for(int j = 0; j < 100; ++j) {
+                        auto m = tracked_t{ {0.0,1.0}, {1.0,2.0} };
+                        m.insert({2.0, 3.0});
+                    }
+                });
+            }
+            for(auto& th : threads) th.join();
+
+            const auto s = counter_t::snapshot();
+            require(s.live_bytes == 64 * node && s.peak_bytes >= 64 * node &&
+                    s.allocations == s.deallocations + 1, "tracking: threads");
+        }
+        require(counter_t::snapshot().live_bytes == 0, "tracking: released");
+        counter_t::reset_peak();
+        require(counter_t::snapshot().peak_bytes == 0, "tracking: reset_peak");
+    }
+    catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,277 @@
+/*****************************************************************************
+ *
+ * AM utilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "transforms.h"
+
+
+using namespace am;
+
+using map_t = piecewise_log_log_map<double,double>;
+
+
+//-------------------------------------------------------------------
+std::vector<std::pair<double,double>>
+power_law(double a, double b, std::size_t n)
+{
+    std::vector<std::pair<double,double>> nodes;
+    nodes.reserve(n);
+    for(std::size_t i = 0; i < n; ++i) {
+        const double x = 0.1 + double(i);
+        nodes.emplace_back(x, a * std::pow(x, b));
+    }
+    return nodes;
+}
+
+
+//-------------------------------------------------------------------
+void check(int line, const map_t& m, const map_t& reference)
+{
+    for(double x = 0.05; x < 2.0 * double(m.size()); x *= 1.37) {
+        const double e = reference(x);
+        if(!(std::abs(m(x) - e) <= 1e-12 * std::abs(e))) {
+            throw std::runtime_error{"line " + std::to_string(line) +
+                ": f(" + std::to_string(x) + ") = " + std::to_string(m(x)) +
+                " != " + std::to_string(e)};
+        }
+    }
+}
+
+
+
+//-------------------------------------------------------------------
+/// log-log interpolator whose rebuilds wait until they are released
+std::atomic<bool> rebuilds_released{true};
+std::atomic<int> rebuilds{0};
+
+struct gated_log_log : interpolator::piecewise_log_log
+{
+    template<class Iterator, class Key, class Value>
+    void prepare(Iterator begin, Iterator end, cache_type<Key,Value>& c) const {
+        ++rebuilds;
+        while(!rebuilds_released) std::this_thread::yield();
+        interpolator::piecewise_log_log::prepare(begin, end, c);
+    }
+};
+
+using gated_map_t = interpolating_map<double,double,gated_log_log>;
+
+
+//-------------------------------------------------------------------
+/// writers don't wait for running rebuilds; rebuilds are coalesced
+void non_blocking_writer_test(const std::vector<std::pair<double,double>>& nodes,
+                              const std::vector<std::pair<double,double>>& other,
+                              const map_t& otherReference)
+{
+    auto m = gated_map_t{};
+    m.set_rebuild_mode(rebuild_mode::background);
+
+    rebuilds_released = false;
+    rebuilds = 0;
+    m.assign(nodes.begin(), nodes.end());
+    while(rebuilds == 0) std::this_thread::yield();
+
+    //first rebuild is blocked => further modifications must not wait
+    auto writer = std::async(std::launch::async, [&] {
+        m.insert({0.7, 1.0});
+        m.assign(nodes.begin(), nodes.end());
+        m.assign(other.begin(), other.end());
+    });
+    const bool done = writer.wait_for(std::chrono::seconds(20)) ==
+                      std::future_status::ready;
+    rebuilds_released = true;
+    writer.get();
+    if(!done) throw std::runtime_error{"writer waited for rebuild"};
+
+    m.rebuilt().get();
+    //blocked rebuild + newest version; intermediate versions skipped
+    if(rebuilds != 2) {
+        throw std::runtime_error{"rebuilds not coalesced: " +
+                                 std::to_string(rebuilds)};
+    }
+    for(double x = 0.05; x < 2.0 * double(m.size()); x *= 1.37) {
+        if(m(x) != otherReference(x)) {
+            throw std::runtime_error{"coalesced rebuild: wrong value"};
+        }
+    }
+
+    //no rebuild in flight => single node updates are local
+    m.erase(other[10].first);
+    m.insert(other[10]);
+    if(rebuilds != 2) throw std::runtime_error{"local update rebuilt all"};
+    if(m.rebuilt().wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        throw std::runtime_error{"local update not ready"};
+    }
+    for(double x = 0.05; x < 2.0 * double(m.size()); x *= 1.37) {
+        if(m(x) != otherReference(x)) {
+            throw std::runtime_error{"local update: wrong value"};
+        }
+    }
+}
+
+
+
+//-------------------------------------------------------------------
+/// copies made during a rebuild get their own derived data
+void copy_during_rebuild_test(const std::vector<std::pair<double,double>>& nodes,
+                              const map_t& reference)
+{
+    auto m = gated_map_t{};
+    m.set_rebuild_mode(rebuild_mode::background);
+
+    rebuilds_released = false;
+    rebuilds = 0;
+    m.assign(nodes.begin(), nodes.end());
+    while(rebuilds == 0) std::this_thread::yield();
+
+    const auto c = m;
+    rebuilds_released = true;
+    m.rebuilt().get();
+    c.rebuilt().get();
+
+    const auto cache = m.footprint().cache;
+    if(cache == 0 || c.footprint().cache != cache) {
+        throw std::runtime_error{"copy during rebuild: no derived data"};
+    }
+    for(double x = 0.05; x < 2.0 * double(c.size()); x *= 1.37) {
+        if(c(x) != reference(x)) {
+            throw std::runtime_error{"copy during rebuild: wrong value"};
+        }
+    }
+}
+
+
+
+//-------------------------------------------------------------------
+int main()
+{
+    try {
+        const auto nodes = power_law(3, 1.5, 20000);
+        const auto other = power_law(0.5, -0.7, 30000);
+
+        const auto reference = map_t(nodes.begin(), nodes.end());
+        const auto otherReference = map_t(other.begin(), other.end());
+
+        auto m = map_t{};
+        if(m.get_rebuild_mode() != rebuild_mode::synchronous) {
+            throw std::runtime_error{"default rebuild mode"};
+        }
+        m.set_rebuild_mode(rebuild_mode::background);
+
+        //results are the same before and after publication
+        m.assign(nodes.begin(), nodes.end());
+        check(__LINE__, m, reference);
+        m.rebuilt().get();
+        check(__LINE__, m, reference);
+
+        //readers during a rebuild
+        m.assign(other.begin(), other.end());
+        {
+            std::atomic<bool> failed{false};
+            std::vector<std::thread> readers;
+            for(int t = 0; t < 4; ++t) {
+                readers.emplace_back([&] {
+                    try { check(__LINE__, m, otherReference); }
+                    catch(std::exception&) { failed = true; }
+                });
+            }
+            for(auto& r : readers) r.join();
+            if(failed) throw std::runtime_error{"concurrent readers"};
+        }
+
+        //a newer modification supersedes a pending rebuild
+        m.assign(nodes.begin(), nodes.end());
+        m.assign(other.begin(), other.end());
+        m.erase(other.back().first);
+        m.insert(other.back());
+        m.rebuilt().get();
+        check(__LINE__, m, otherReference);
+
+        //copies and moves of maps with pending rebuilds
+        m.assign(nodes.begin(), nodes.end());
+        auto c = m;
+        check(__LINE__, c, reference);
+        auto mv = std::move(c);
+        check(__LINE__, mv, reference);
+        if(mv.get_rebuild_mode() != rebuild_mode::background) {
+            throw std::runtime_error{"rebuild mode not copied"};
+        }
+        mv.insert({0.6, 3 * std::pow(0.6, 1.5)});
+        mv.rebuilt().get();
+        check(__LINE__, mv, reference);
+
+        //switching back
+        m.set_rebuild_mode(rebuild_mode::synchronous);
+        m.assign(other.begin(), other.end());
+        check(__LINE__, m, otherReference);
+
+        //single node insert/erase only update the affected window
+        {
+            auto loc = reference;
+            const auto shared = loc;
+            for(std::size_t i = 0; i < 100; ++i) {
+                loc.erase(nodes[i * 97].first);
+            }
+            loc.erase(loc.begin());             //node 1
+            loc.erase(std::prev(loc.end()));    //last node
+            //nodes 52...61
+            loc.erase(std::next(loc.begin(), 50), std::next(loc.begin(), 60));
+            for(std::size_t i = 0; i < 100; ++i) {
+                loc.insert(nodes[i * 97]);
+            }
+            loc.insert(nodes[1]);
+            loc.insert(nodes.back());
+            for(std::size_t i = 0; i < 10; ++i) loc.insert(nodes[52 + i]);
+            if(loc.size() != nodes.size()) {
+                throw std::runtime_error{"local updates: node count"};
+            }
+            check(__LINE__, loc, reference);
+            check(__LINE__, shared, reference);
+
+            //sparse node set; fresh map as reference
+            loc.erase(std::next(loc.begin(), 5), std::prev(loc.end(), 5));
+            loc.emplace(7.5, 1.0);
+            const auto fresh = map_t(loc.begin(), loc.end());
+            check(__LINE__, loc, fresh);
+        }
+
+        //maps that are destroyed while rebuilding
+        for(int i = 0; i < 8; ++i) {
+            auto tmp = map_t{};
+            tmp.set_rebuild_mode(rebuild_mode::background);
+            tmp.assign(nodes.begin(), nodes.end());
+        }
+
+        non_blocking_writer_test(nodes, other, otherReference);
+        copy_during_rebuild_test(nodes, reference);
+
+        //interpolators without derived data: always ready
+        auto lin = piecewise_linear_map<double,double>{{0,0}, {1,2}};
+        lin.set_rebuild_mode(rebuild_mode::background);
+        lin.insert({2,4});
+        lin.rebuilt().get();
+        if(lin(1.5) != 3) throw std::runtime_error{"linear map"};
+    }
+    catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,209 @@
+/*****************************************************************************
+ *
+ * AM utilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "node_table_io.h"
+#include "interpolating_map.h"
+
+
+using namespace am;
+
+
+//-------------------------------------------------------------------
+void require(bool ok, const char* what)
+{
+    if(!ok) throw std::runtime_error{what};
+}
+
+
+
+//-------------------------------------------------------------------
+template<class Key, class Value>
+std::vector<std::pair<Key,Value>>
+parse(const std::string& s, const text_format& fmt = text_format{},
+      parse_report* report = nullptr)
+{
+    return parse_nodes<Key,Value>(s.data(), s.data() + s.size(), fmt, report);
+}
+
+
+
+//-------------------------------------------------------------------
+void formats_test()
+{
+    using nodes_t = std::vector<std::pair<double,double>>;
+
+    //csv with header, comments, blanks and CRLF
+    {
+        text_format fmt;
+        fmt.header_lines = 1;
+        parse_report r;
+        const auto n = parse<double,double>(
+            "x,y\r\n# comment\r\n 1.5 , 2\r\n\r\n+3,-4e2\r\n5,6", fmt, &r);
+        require(n == nodes_t{{1.5,2.0}, {3.0,-400.0}, {5.0,6.0}},
+                "csv: nodes");
+        require(r.lines == 6 && r.nodes == 3 && r.rejected == 0 && r.sorted,
+                "csv: report");
+    }
+    //whitespace separated, column selection
+    {
+        text_format fmt;
+        fmt.delimiter = ' ';
+        fmt.key_column = 2;
+        fmt.value_column = 0;
+        const auto n = parse<int,float>("10 x 1\n\t20   y\t2  \n", fmt);
+        require(n.size() == 2 && n[0] == std::make_pair(1, 10.0f) &&
+                n[1] == std::make_pair(2, 20.0f), "whitespace: nodes");
+    }
+    //tab separated
+    {
+        text_format fmt;
+        fmt.delimiter = '\t';
+        const auto n = parse<long,double>("1\t0.5\n2\t0.25\n", fmt);
+        require(n.size() == 2 && n[1].second == 0.25, "tsv: nodes");
+    }
+}
+
+
+
+//-------------------------------------------------------------------
+void error_test()
+{
+    const std::string text = "1,1\n2,x\n3\n4,4\n5.5,5\n";
+
+    //fail
+    try {
+        parse<int,double>(text);
+        require(false, "fail: no exception");
+    }
+    catch(parse_error& e) {
+        require(e.issue().line == 2 && e.issue().field == 1, "fail: location");
+    }
+
+    //skip
+    text_format fmt;
+    fmt.errors = on_parse_error::skip;
+    fmt.max_reported = 2;
+    parse_report r;
+    const auto n = parse<int,double>(text, fmt, &r);
+    require(n.size() == 2 && n[1].first == 4, "skip: nodes");
+    require(r.rejected == 3 && r.issues.size() == 2 &&
+            r.issues[0].line == 2 && r.issues[1].line == 3 &&
+            r.issues[1].field == 1, "skip: report");
+}
+
+
+
+//-------------------------------------------------------------------
+void parallel_test()
+{
+    //large enough for multiple chunks
+    std::string text = "key,value\n";
+    std::size_t expected = 0;
+    for(int i = 0; text.size() < (std::size_t(5) << 20); ++i) {
+        if(i % 100000 == 777) {
+            text += "bad line\n";
+        } else {
+            text += std::to_string(i) + "," + std::to_string(0.5 * i) + "\n";
+            ++expected;
+        }
+    }
+
+    text_format fmt;
+    fmt.header_lines = 1;
+    fmt.errors = on_parse_error::skip;
+
+    parse_report r1;
+    const auto n1 = parse<int,double>(text, fmt, &r1);
+
+    fmt.threads = 4;
+    parse_report r4;
+    const auto n4 = parse<int,double>(text, fmt, &r4);
+
+    require(n1.size() == expected && n1 == n4, "parallel: nodes");
+    require(r1.lines == r4.lines && r1.rejected == r4.rejected &&
+            r4.sorted && r4.issues.size() == r1.issues.size(),
+            "parallel: report");
+    for(std::size_t i = 0; i < r1.issues.size(); ++i) {
+        require(r1.issues[i].line == r4.issues[i].line, "parallel: lines");
+    }
+
+    //error in a later chunk
+    fmt.errors = on_parse_error::fail;
+    try {
+        parse<int,double>(text, fmt);
+        require(false, "parallel: no exception");
+    }
+    catch(parse_error& e) {
+        require(e.issue().line == r1.issues.front().line, "parallel: error line");
+    }
+}
+
+
+
+//-------------------------------------------------------------------
+void stream_and_file_test()
+{
+    std::string text;
+    for(int i = 0; i < 200000; ++i) {
+        text += std::to_string(i) + " " + std::to_string(2 * i) + "\n";
+    }
+    text_format fmt;
+    fmt.delimiter = ' ';
+
+    const auto expected = parse<int,int>(text, fmt);
+
+    std::istringstream is{text};
+    parse_report r;
+    require(read_nodes<int,int>(is, fmt, &r) == expected &&
+            r.lines == 200000, "stream: nodes");
+
+    const std::string filename = "node_table_io_test.txt";
+    {
+        std::ofstream os{filename, std::ios::binary};
+        os << text;
+    }
+    require(read_nodes<int,int>(filename, fmt) == expected, "file: nodes");
+
+    //unsorted input into maps
+    {
+        std::ofstream os{filename, std::ios::binary};
+        os << "3,9\n1,1\n2,4\n";
+    }
+    const auto m = read_map<piecewise_linear_map<double,double>>(filename);
+    require(m.size() == 3 && m.begin()->first == 1.0 && m(2.5) == 6.5,
+            "read_map: sorted");
+
+    std::remove(filename.c_str());
+}
+
+
+
+//-------------------------------------------------------------------
+int main()
+{
+    try {
+        formats_test();
+        error_test();
+        parallel_test();
+        stream_and_file_test();
+    }
+    catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,130 @@
+/*****************************************************************************
+ *
+ * AM utilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+
+#include <stdexcept>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "polynomial_approximation.h"
+
+
+using namespace am;
+
+
+//-------------------------------------------------------------------
+template<class Approx, class Expected>
+void verify(int line, const Approx& p, Expected&& expected,
+            double lo, double hi, double tol, std::size_t n = 10007)
+{
+    using std::abs;
+    using std::to_string;
+
+    for(std::size_t i = 0; i <= n; ++i) {
+        const double x = lo + (hi - lo) * double(i) / double(n);
+        if(!(abs(p(x) - expected(x)) <= tol)) {
+            throw std::runtime_error{"line " + to_string(line) +
+                ": p(" + to_string(x) + ") = " + to_string(p(x)) +
+                " != " + to_string(expected(x))};
+        }
+    }
+}
+
+
+
+
+//-------------------------------------------------------------------
+int main()
+{
+    using std::sin;
+    using std::exp;
+
+    try {
+        //polynomials up to the degree are reproduced with one segment
+        auto cubic = [](double x) { return 1 - 2*x + 0.5*x*x*x; };
+        const auto pc = polynomial_approximation<double,double,3>{
+                            cubic, -3.0, 5.0, tolerance{1e-12}};
+        if(pc.segments() != 1) {
+            throw std::runtime_error{"polynomial: cubic needs 1 segment"};
+        }
+        verify(__LINE__, pc, cubic, -3, 5, 1e-11);
+
+        const auto p0 = polynomial_approximation<double,double,0>{
+                            [](double) { return 2.5; }, 0.0, 1.0, tolerance{}};
+        verify(__LINE__, p0, [](double) { return 2.5; }, -1, 2, 0);
+
+        //smooth, densely sampled map
+        using map_t = piecewise_linear_map<double,double>;
+        auto nodes = map_t::container_type{};
+        for(int i = 0; i <= 20000; ++i) {
+            const double x = 1e-3 * i;
+            nodes.emplace_back(x, sin(x) * exp(-0.1 * x));
+        }
+        const auto m = map_t{sorted_range, std::move(nodes)};
+
+        const auto pm = approximate(m, tolerance{1e-6});
+        if(!pm.within_tolerance() || pm.max_error() > 1e-6) {
+            throw std::runtime_error{"polynomial: tolerance not met"};
+        }
+        if(pm.segments() > 64 ||
+           pm.memory_usage() * 50 > m.size() * sizeof(map_t::value_type))
+        {
+            throw std::runtime_error{"polynomial: too many segments: " +
+                                     std::to_string(pm.segments())};
+        }
+        verify(__LINE__, pm, m, 0, 20, 1e-6);
+
+        //outside of the node range: same as the map
+        verify(__LINE__, pm, m, -5, -1e-3, 1e-12, 997);
+        verify(__LINE__, pm, m, 20.001, 100, 1e-12, 997);
+
+        const auto sq = map_t{ {0,0}, {1,1}, {2,4}, {3,9} };
+        const auto psq = approximate<2>(sq, tolerance{1e-3});
+        if(psq(-1.0) != -1.0 || psq(5.0) != 19.0) {
+            throw std::runtime_error{"polynomial: linear extrapolation"};
+        }
+        using clamp_map = interpolating_map<double,double,
+            interpolator::basic_piecewise_linear<extrapolation::clamp>>;
+        const auto sqc = clamp_map{ {0,0}, {1,1}, {2,4}, {3,9} };
+        const auto psqc = approximate<2>(sqc, tolerance{1e-3});
+        if(psqc(-1.0) != 0.0 || psqc(5.0) != 9.0) {
+            throw std::runtime_error{"polynomial: clamping extrapolation"};
+        }
+
+        //callables: clamped outside of domain
+        if(pc(-4.0) != pc(-3.0) || pc(6.0) != pc(5.0)) {
+            throw std::runtime_error{"polynomial: domain clamping"};
+        }
+
+        //batch == scalar
+        auto xs = std::vector<double>{};
+        for(double x = -1; x < 21; x += 0.0137) xs.push_back(x);
+        auto ys = std::vector<double>(xs.size());
+        pm.evaluate(xs.begin(), xs.end(), ys.begin());
+        for(std::size_t i = 0; i < xs.size(); ++i) {
+            if(ys[i] != pm(xs[i])) {
+                throw std::runtime_error{"polynomial: batch != scalar"};
+            }
+        }
+
+        //unreachable tolerance => reported
+        const auto step = piecewise_constant_map<double,double>{{0,0}, {1,1}};
+        const auto ps = approximate<3>(step, tolerance{1e-3}, 16);
+        if(ps.within_tolerance() || ps.segments() != 16) {
+            throw std::runtime_error{"polynomial: unreachable tolerance"};
+        }
+    }
+    catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -23,7 +23,8 @@ from sets import Set
 
 #default settings
 builddir   = "../build_test"
-incpaths   = ["", "../include/", "../src/"]
+gendir     = builddir + "/generated/"
+incpaths   = ["", "../include/", "../src/", gendir]
 macros     = ["NO_DEBUG", "NDEBUG"]
 compiler   = "g++"
 compileopt = "-std=c++14 -O3 -Wall -Wextra -Wpedantic -Wno-unknown-pragmas"
@@ -37,6 +38,20 @@ deprxp = [re.compile('^\s*#pragma\s+test\s+needs\(\s*"(.+\..+)"\s*\)\s*$'),
 
 testrxp = re.compile('(.+)\.' + tuext)
 
+# [ (generator source, input file, arguments, generated file) ]
+# generators are built and run before the tests; generated files are placed
+# in 'gendir' which is part of the include paths
+generators = [
+    ("../tools/make_table.cpp", "data/lin_table.csv",
+     "--name lin --buckets 5", "lin_table.h"),
+    ("../tools/make_table.cpp", "data/steps_table.csv",
+     "--name steps --key-type int --value-type int "
+     "--interpolator piecewise_constant --buckets 4", "steps_table.h"),
+    ("../tools/make_table.cpp", "data/small_table.csv",
+     "--name small --buckets 0", "small_table.h"),
+    ("../tools/make_table.cpp", "data/wide_table.csv",
+     "--name wide", "wide_table.h")]
+
 def dependencies(source, searchpaths = [], sofar = Set()):
     """ return set of dependencies for a C++ source file
         the following dependency definitions are recocnized:
@@ -182,6 +197,57 @@ for ip in incpaths:
 
 #print compilecmd
 
+# build generators and generate files
+if not os.path.exists(gendir):
+    os.makedirs(gendir)
+
+for (gsource, ginput, gargs, goutput) in generators:
+    gname = testrxp.match(path.basename(gsource)).group(1)
+    gartifact = builddir + "/" + gname + artifactext
+    generated = gendir + goutput
+
+    stdout.write("generating " + goutput + " > ")
+    stdout.flush()
+
+    doCompile = recompile or not path.exists(gartifact)
+    if not doCompile:
+        for dep in dependencies(gsource, incpaths):
+            if path.exists(dep) and \
+               path.getmtime(gartifact) < path.getmtime(dep):
+                doCompile = True
+                break
+
+    if doCompile:
+        stdout.write("compiling > ")
+        stdout.flush()
+        if path.exists(gartifact):
+            os.remove(gartifact)
+        system(compilecmd + " " + gsource + " -o " + gartifact)
+        if not path.exists(gartifact):
+            print "FAILED!"
+            allpass = False
+            if haltOnFail: exit()
+            continue
+
+    if doCompile or not path.exists(generated) or \
+       path.getmtime(generated) < path.getmtime(ginput):
+        stdout.write("running > ")
+        stdout.flush()
+        if onwindows:
+            gartifact = gartifact.replace("/", "\\")
+        if system(gartifact + " " + gargs + " " + ginput +
+                  " -o " + generated) != 0:
+            if path.exists(generated):
+                os.remove(generated)
+            print "FAILED!"
+            allpass = False
+            if haltOnFail: exit()
+            continue
+
+    print "done."
+
+print separator
+
 for source in sources:
     res1 = testrxp.match(source)
     res2 = testrxp.match(path.basename(source))
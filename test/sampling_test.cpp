@@ -0,0 +1,192 @@
+/*****************************************************************************
+ *
+ * AM utilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+
+#include <stdexcept>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "interpolating_map.h"
+#include "transforms.h"
+
+
+using namespace am;
+
+
+//-------------------------------------------------------------------
+template<class Map, class Keys>
+void verify(int line, const Map& map, const Keys& keys)
+{
+    std::size_t i = 0;
+    for(auto v : map.sample(keys)) {
+        const auto e = map(keys[i]);
+        //NaN == NaN
+        if(!(v == e) && !(v != v && e != e)) {
+            throw std::runtime_error{"line " + std::to_string(line) +
+                ": sample(" + std::to_string(keys[i]) + ") = " +
+                std::to_string(v) + " != " + std::to_string(e)};
+        }
+        ++i;
+    }
+    if(i != keys.size()) {
+        throw std::runtime_error{"line " + std::to_string(line) +
+                                 ": wrong number of samples"};
+    }
+}
+
+
+//-------------------------------------------------------------------
+template<class Map>
+void verify_all(int line, const Map& map)
+{
+    auto sorted = std::vector<typename Map::key_type>{};
+    for(int i = -40; i <= 160; ++i) sorted.push_back(0.1 * i);
+    //node keys
+    for(const auto& n : map) sorted.push_back(n.first);
+    std::sort(sorted.begin(), sorted.end());
+    verify(line, map, sorted);
+
+    //arbitrary order
+    auto shuffled = sorted;
+    for(std::size_t i = 0; i < shuffled.size(); ++i) {
+        std::swap(shuffled[i], shuffled[(i * 7919) % shuffled.size()]);
+    }
+    verify(line, map, shuffled);
+
+    //descending
+    verify(line, map, std::vector<typename Map::key_type>(
+        sorted.rbegin(), sorted.rend()));
+}
+
+
+
+
+//-------------------------------------------------------------------
+int main()
+{
+    try {
+        using lin_t = piecewise_linear_map<double,double>;
+
+        const auto lin = lin_t{ {0,1}, {1,3}, {2,2}, {2,5}, {4,0},
+                                {5,1}, {7,7}, {8,2}, {12,4} };
+        verify_all(__LINE__, lin);
+
+        verify_all(__LINE__, piecewise_constant_map<double,double>{
+            {0,1}, {1,3}, {2,2}, {2,5}, {4,0}, {12,4} });
+
+        verify_all(__LINE__, piecewise_log_linear_map<double,double>{
+            {0.5,1}, {1,3}, {2,2}, {4,0}, {12,4} });
+
+        verify_all(__LINE__, interpolating_map<double,double,
+            interpolator::basic_piecewise_linear<extrapolation::nan>>{
+            {0,1}, {1,3}, {2,2}, {4,0}, {12,4} });
+
+        verify_all(__LINE__, piecewise_log_log_map<double,double>{
+            {0.5,1}, {1,3}, {2,2}, {4,0.5}, {12,4} });
+
+        verify_all(__LINE__, lin_t{});
+        verify_all(__LINE__, lin_t{ {1,2} });
+
+        //uniform sampling
+        const auto u = lin.sample_uniform(-1.0, 13.0, 57);
+        if(u.size() != 57 || u.key(0) != -1.0 || u.key(56) != 13.0) {
+            throw std::runtime_error{"sample_uniform: wrong keys"};
+        }
+        std::size_t i = 0;
+        for(auto v : u) {
+            if(v != lin(u.key(i))) {
+                throw std::runtime_error{"sample_uniform: wrong value"};
+            }
+            ++i;
+        }
+        if(i != 57) throw std::runtime_error{"sample_uniform: wrong size"};
+
+        //adaptor & standard algorithms
+        const auto keys = std::vector<double>{0.5, 1.5, 3.0};
+        const auto view = keys | sampled(lin);
+        const double sum = std::accumulate(view.begin(), view.end(), 0.0);
+        if(sum != lin(0.5) + lin(1.5) + lin(3.0)) {
+            throw std::runtime_error{"sampled adaptor: wrong sum"};
+        }
+
+        //ascending keys => no binary searches
+        struct tag {};
+        using counters = instrumentation::counting<tag>;
+        using counted_t = interpolating_map<double,double,
+            interpolator::piecewise_linear, std::less<double>,
+            std::allocator<std::pair<double,double>>, counters>;
+
+        auto nodes = counted_t::container_type{};
+        for(int k = 0; k < 1000; ++k) nodes.emplace_back(k, k % 7);
+        const auto big = counted_t{sorted_range, std::move(nodes)};
+
+        counters::reset();
+        double total = 0;
+        for(auto v : big.sample_uniform(0.0, 999.0, 4000)) total += v;
+        const auto s = counters::snapshot();
+        if(s.evaluations != 4000 || s.cursor_hits != 4000 || s.searches != 0) {
+            throw std::runtime_error{"sample: cursor not used"};
+        }
+        (void)total;
+
+#ifdef AMLIB_HAS_RANGES
+        static_assert(std::ranges::view<sample_view<lin_t,
+                      std::vector<double>::const_iterator>>);
+        static_assert(std::ranges::view<uniform_sample_view<lin_t>>);
+
+        auto positive = lin.sample_uniform(-1.0, 13.0, 57)
+                      | std::views::filter([](double v) { return v > 0; });
+        for(auto v : positive) {
+            if(!(v > 0)) throw std::runtime_error{"ranges: filter failed"};
+        }
+
+        //keys | filter | sampled | take
+        const auto ks = std::vector<double>{-2, 0.5, 1, 1.5, 2, 3, 7, 9, 11};
+        const auto even = [](double k) { return std::fmod(k, 2.0) == 0; };
+        std::vector<double> res;
+        for(auto v : ks | std::views::filter(even) | sampled(lin) | std::views::take(2)) {
+            res.push_back(v);
+        }
+        if(res != std::vector<double>{lin(-2.0), lin(2.0)}) {
+            throw std::runtime_error{"ranges: filter | sampled | take"};
+        }
+
+        //named view without const begin
+        auto evenKeys = ks | std::views::filter(even);
+        double fsum = 0;
+        for(auto v : evenKeys | sampled(lin)) fsum += v;
+        for(auto v : lin.sample(evenKeys)) fsum -= v;
+        if(fsum != 0) throw std::runtime_error{"ranges: named filter view"};
+
+        //end sentinel type != iterator type
+        auto below3 = ks | std::views::take_while([](double k) { return k < 3; });
+        static_assert(!std::ranges::common_range<decltype(below3)>);
+        std::size_t cnt = 0;
+        for(auto v : below3 | sampled(lin)) {
+            if(v != lin(ks[cnt])) throw std::runtime_error{"ranges: sentinel"};
+            ++cnt;
+        }
+        if(cnt != 5) throw std::runtime_error{"ranges: sentinel count"};
+
+        //temporary containers are moved into the view
+        const auto owned = std::vector<double>{0.5, 1.5} | sampled(lin);
+        if(std::ranges::size(owned) != 2 || *owned.begin() != lin(0.5)) {
+            throw std::runtime_error{"ranges: owning view"};
+        }
+#endif
+    }
+    catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,217 @@
+/*****************************************************************************
+ *
+ * AM utilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+
+#include <algorithm>
+#include <iostream>
+#include <list>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "interpolating_map.h"
+#include "search.h"
+
+
+using namespace am;
+
+
+//-------------------------------------------------------------------
+void require(bool ok, const char* what)
+{
+    if(!ok) throw std::runtime_error{what};
+}
+
+
+
+//-------------------------------------------------------------------
+using node_t = std::pair<int,int>;
+
+std::vector<node_t>
+sorted_nodes(std::size_t n, int maxKey, std::mt19937& urng)
+{
+    std::vector<node_t> v(n);
+    int i = 0;
+    for(auto& x : v) x = {int(urng() % unsigned(maxKey)), i++};
+    std::sort(v.begin(), v.end(),
+              [](const node_t& a, const node_t& b) { return a.first < b.first; });
+    return v;
+}
+
+//-------------------------------------------------------------------
+auto std_lower(const std::vector<node_t>& v, int x) {
+    return std::lower_bound(v.begin(), v.end(), x,
+        [](const node_t& a, int k) { return a.first < k; });
+}
+
+auto std_upper(const std::vector<node_t>& v, int x) {
+    return std::upper_bound(v.begin(), v.end(), x,
+        [](int k, const node_t& a) { return k < a.first; });
+}
+
+
+
+//-------------------------------------------------------------------
+/// all size classes; duplicate keys
+void runtime_size_test()
+{
+    std::mt19937 urng{17};
+    const std::vector<std::size_t> sizes {0, 1, 2, 3, 4, 5, 7, 8, 9, 16, 17,
+        100, 1000, search::prefetch_min - 1, search::prefetch_min + 3};
+
+    for(auto n : sizes)
+    {
+        const int maxKey = int(n / 3 + 1);
+        const auto v = sorted_nodes(n, maxKey, urng);
+        for(int x = -1; x <= maxKey + 1; ++x) {
+            require(search::lower_bound(v.begin(), v.end(), x) == std_lower(v,x),
+                    "lower_bound");
+            require(search::upper_bound(v.begin(), v.end(), x) == std_upper(v,x),
+                    "upper_bound");
+            require(search::halving_partition_point(v.begin(), n,
+                        [&](const node_t& a) { return a.first < x; }) == std_lower(v,x),
+                    "halving");
+            require(search::linear_partition_point(v.begin(), n,
+                        [&](const node_t& a) { return a.first < x; }) == std_lower(v,x),
+                    "linear");
+        }
+    }
+}
+
+
+
+//-------------------------------------------------------------------
+template<std::size_t N>
+void fixed_size_test(std::mt19937& urng)
+{
+    const auto v = sorted_nodes(N, int(N / 2 + 1), urng);
+    for(int x = -1; x <= int(N / 2) + 2; ++x) {
+        require(search::partition_point_fixed<N>(v.begin(),
+                    [&](const node_t& a) { return a.first < x; }) == std_lower(v,x),
+                "fixed size");
+    }
+}
+
+void fixed_size_test()
+{
+    std::mt19937 urng{3};
+    fixed_size_test<0>(urng);
+    fixed_size_test<1>(urng);
+    fixed_size_test<4>(urng);
+    fixed_size_test<5>(urng);
+    fixed_size_test<16>(urng);
+    fixed_size_test<63>(urng);
+    fixed_size_test<64>(urng);
+    fixed_size_test<1000>(urng);
+}
+
+
+
+//-------------------------------------------------------------------
+void forward_iterator_test()
+{
+    const std::list<node_t> l { {1,0}, {2,0}, {2,1}, {5,0} };
+    require(std::distance(l.begin(), search::lower_bound(l.begin(), l.end(), 2)) == 1 &&
+            std::distance(l.begin(), search::upper_bound(l.begin(), l.end(), 2)) == 3,
+            "forward iterators");
+}
+
+
+
+//-------------------------------------------------------------------
+/// vector_map is a multimap: single inserts go in front of equal keys
+void vector_map_test()
+{
+    vector_map<int,int> m;
+    for(int i = 0; i < 100; ++i) m.insert({i % 10, i});
+
+    const auto r = m.equal_range(3);
+    require(std::distance(r.first, r.second) == 10, "vector_map: equal_range");
+    int prev = 100;
+    for(auto i = r.first; i != r.second; ++i) {
+        require(i->first == 3 && i->second < prev, "vector_map: duplicate order");
+        prev = i->second;
+    }
+    require(m.lower_bound(-5) == m.begin() && m.upper_bound(9) == m.end(),
+            "vector_map: bounds");
+}
+
+
+
+//-------------------------------------------------------------------
+/// interleaved searches give the same results as single searches
+template<std::size_t Group>
+void batch_test(const std::vector<node_t>& v, const std::vector<int>& qs)
+{
+    using iter_t = std::vector<node_t>::const_iterator;
+    std::vector<iter_t> res(qs.size());
+
+    search::partition_points<Group>(v.cbegin(), v.size(),
+        qs.begin(), qs.end(), res.begin(),
+        [](const node_t& a, int x) { return a.first < x; });
+
+    for(std::size_t i = 0; i < qs.size(); ++i) {
+        require(res[i] == std_lower(v, qs[i]), "batch search");
+    }
+}
+
+void batch_test()
+{
+    std::mt19937 urng{11};
+    for(std::size_t n : {std::size_t(0), std::size_t(1), std::size_t(100),
+                         search::prefetch_min + 5})
+    {
+        const int maxKey = int(n / 2 + 1);
+        const auto v = sorted_nodes(n, maxKey, urng);
+        std::vector<int> qs(1000);
+        for(auto& q : qs) q = int(urng() % unsigned(maxKey + 2)) - 1;
+
+        batch_test<1>(v, qs);
+        batch_test<3>(v, qs);
+        batch_test<16>(v, qs);
+    }
+
+    //maps
+    auto m = piecewise_linear_map<double,double>{};
+    for(int i = 0; i < 1000; ++i) m.insert({double(i), double(i % 7)});
+
+    std::vector<double> xs;
+    for(int i = 0; i < 3000; ++i) xs.push_back(double(urng() % 12000) / 10.0 - 50.0);
+
+    std::vector<piecewise_linear_map<double,double>::const_iterator> its(xs.size());
+    m.lower_bounds(xs.begin(), xs.end(), its.begin());
+    std::vector<double> ys(xs.size()), ys5(xs.size());
+    m.evaluate(xs.begin(), xs.end(), ys.begin());
+    m.evaluate<5>(xs.begin(), xs.end(), ys5.begin());
+
+    for(std::size_t i = 0; i < xs.size(); ++i) {
+        require(its[i] == m.lower_bound(xs[i]), "map: lower_bounds");
+        require(ys[i] == m(xs[i]) && ys5[i] == ys[i], "map: batch evaluation");
+    }
+}
+
+
+
+//-------------------------------------------------------------------
+int main()
+{
+    try {
+        runtime_size_test();
+        fixed_size_test();
+        forward_iterator_test();
+        vector_map_test();
+        batch_test();
+    }
+    catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
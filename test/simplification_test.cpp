@@ -0,0 +1,114 @@
+/*****************************************************************************
+ *
+ * AM utilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+
+#include <stdexcept>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+#include "allocators.h"
+#include "simplification.h"
+
+
+using namespace am;
+
+using lin_map = piecewise_linear_map<double,double>;
+using const_map = piecewise_constant_map<double,double>;
+
+
+//-------------------------------------------------------------------
+template<class Map, class Expected>
+void verify(int line, const Map& map, Expected&& expected,
+            double lo, double hi, std::size_t n = 997)
+{
+    using std::abs;
+    using std::to_string;
+
+    for(std::size_t i = 0; i <= n; ++i) {
+        const double x = lo + (hi - lo) * double(i) / double(n);
+        const double e = expected(x);
+        if(abs(map(x) - e) > 1e-9) {
+            throw std::runtime_error{"line " + to_string(line) +
+                ": s(" + to_string(x) + ") = " + to_string(map(x)) +
+                " != " + to_string(e)};
+        }
+    }
+}
+
+
+
+
+//-------------------------------------------------------------------
+int main()
+{
+    using std::sin;
+    using std::abs;
+
+    try {
+        auto nodes = lin_map::container_type{};
+        for(int i = 0; i <= 100000; ++i) {
+            const double x = 1e-4 * i;
+            nodes.emplace_back(x, sin(x) + 0.3 * x * x);
+        }
+        const auto f = lin_map{sorted_range, std::move(nodes)};
+
+        const double tol = 1e-4;
+        const auto s = simplify(f, tolerance{tol});
+
+        if(s.size() >= f.size() / 100) {
+            throw std::runtime_error{"simplification: too many nodes left: " +
+                                     std::to_string(s.size())};
+        }
+        for(const auto& n : f) {
+            if(abs(s(n.first) - n.second) > tol * (1 + 1e-9)) {
+                throw std::runtime_error{"simplification: tolerance exceeded"};
+            }
+        }
+
+        //equal runs of step functions are merged
+        const auto c = const_map{ {0,1}, {1,1}, {2,1}, {3,2}, {4,2}, {5,1} };
+        const auto cs = simplify(c, tolerance{});
+        if(cs.size() != 3) {
+            throw std::runtime_error{"simplification: equal runs not merged"};
+        }
+        verify(__LINE__, cs, c, -1, 6);
+
+        //node key range is kept
+        using checked_map = interpolating_map<double,double,
+            interpolator::basic_piecewise_constant<extrapolation::checked>>;
+        const auto k = checked_map{ {0,1}, {1,1}, {2,1} };
+        const auto ks = simplify(k, tolerance{});
+        if(ks.size() != 2 || ks.begin()->first != 0 ||
+           std::prev(ks.end())->first != 2)
+        {
+            throw std::runtime_error{"simplification: key range not kept"};
+        }
+        verify(__LINE__, ks, k, 0, 2);
+
+        //allocator is kept
+        struct simplify_tag {};
+        using alloc_t = tracking_allocator<std::pair<const double,double>,
+                                           simplify_tag>;
+        using tracked_map = interpolating_map<double,double,
+            interpolator::piecewise_linear,std::less<double>,alloc_t>;
+        const auto t = tracked_map(f.begin(), f.end());
+        const auto before = allocation_counter<simplify_tag>::snapshot().live_bytes;
+        const auto ts = simplify(t, tolerance{tol});
+        if(allocation_counter<simplify_tag>::snapshot().live_bytes <= before) {
+            throw std::runtime_error{"simplification: allocator not used"};
+        }
+        verify(__LINE__, ts, s, 0, 10);
+    }
+    catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
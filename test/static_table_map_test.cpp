@@ -0,0 +1,96 @@
+/*****************************************************************************
+ *
+ * AM utilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+
+#include <stdexcept>
+#include <iostream>
+#include <string>
+#include <tuple>
+
+#include "static_table_map.h"
+#include "interpolating_map.h"
+
+
+using namespace am;
+
+
+//-------------------------------------------------------------------
+// tables generated by tools/make_table from data/*.csv (see run_tests.py)
+
+#include "lin_table.h"
+#include "steps_table.h"
+#include "small_table.h"
+#include "wide_table.h"
+
+
+static_assert(lin.size() == 8 && lin[3].first == 7.0,
+              "static table must be usable in constant expressions");
+
+static_assert(lin(3.5) == 1.0 && lin(-1.0) == 0.0 && small(3.0) == 2.0,
+              "interpolation must be usable in constant expressions");
+
+static_assert(lin_type::slope_count == 7 && steps_type::slope_count == 0,
+              "slopes only for piecewise linear tables");
+
+static_assert(std::tuple_size<small_type::index_array>::value == 0 &&
+              std::tuple_size<lin_type::index_array>::value == 6 &&
+              wide_type::bucket_count == 75,
+              "bucket index");
+
+
+
+//-------------------------------------------------------------------
+template<class Table, class Map>
+void verify(int line, const Table& table, const Map& map, double lo, double hi)
+{
+    using key_t = typename Table::key_type;
+
+    for(double x = lo; x <= hi; x += 0.125) {
+        const auto k = key_t(x);
+        if(table(k) != map(k)) {
+            throw std::runtime_error{"line " + std::to_string(line) +
+                ": table(" + std::to_string(k) + ") = " +
+                std::to_string(table(k)) + " != " + std::to_string(map(k))};
+        }
+    }
+}
+
+
+
+//-------------------------------------------------------------------
+int main()
+{
+    try {
+        //input is sorted
+        verify(__LINE__, lin, piecewise_linear_map<double,double>{
+                   {0,1}, {3,4}, {4,-2}, {7,0}, {8,8}, {12,3}, {13,1}, {20,6} },
+               -5, 25);
+
+        //order of equal keys is preserved
+        using steps_map = piecewise_constant_map<int,int>;
+        verify(__LINE__, steps, steps_map{sorted_range, steps_map::container_type{
+                   {0,1}, {3,4}, {3,5}, {4,-2}, {7,0}, {8,8}, {12,3}, {13,1},
+                   {20,6} }},
+               -5, 25);
+
+        verify(__LINE__, small, piecewise_linear_map<double,double>{
+                   {1,2}, {2,4}, {4,0} },
+               -2, 7);
+
+        //precomputed slopes give the interpolator's results
+        verify(__LINE__, wide, piecewise_linear_map<double,double>{
+                   sorted_range, wide.begin(), wide.end()},
+               -10, wide[wide.size()-1].first + 10);
+    }
+    catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,116 @@
+/*****************************************************************************
+ *
+ * AM utilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+
+#include <stdexcept>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+#include "time_series_map.h"
+
+
+using namespace am;
+
+
+//-------------------------------------------------------------------
+void check(int line, bool condition)
+{
+    if(!condition) {
+        throw std::runtime_error{"check failed in line " + std::to_string(line)};
+    }
+}
+
+
+
+
+//-------------------------------------------------------------------
+void capacity_test()
+{
+    auto ts = time_series_map<double,double,interpolator::piecewise_linear,
+                              eviction::capacity>{eviction::capacity{4}};
+
+    for(int i = 0; i < 1000; ++i) {
+        ts.insert({double(i), 2.0 * i});
+        check(__LINE__, ts.size() <= 4);
+        check(__LINE__, ts.back().first == double(i));
+    }
+    check(__LINE__, ts.size() == 4);
+    check(__LINE__, ts.front().first == 996.0);
+    //buffer must not grow without bounds
+    check(__LINE__, ts.capacity() <= 16);
+
+    check(__LINE__, std::abs(ts(997.5) - 1995.0) < 1e-9);
+    //linear extrapolation beyond the window
+    check(__LINE__, std::abs(ts(1000.0) - 2000.0) < 1e-9);
+}
+
+
+
+//-------------------------------------------------------------------
+void time_window_test()
+{
+    auto ts = time_series_map<double,double,interpolator::piecewise_constant,
+                              eviction::time_window<double>>{
+                                  eviction::time_window<double>{10.0}};
+
+    for(int i = 0; i <= 100; ++i) {
+        ts.insert({0.5 * i, double(i)});
+    }
+    check(__LINE__, ts.front().first == 40.0);
+    check(__LINE__, ts.back().first == 50.0);
+    check(__LINE__, ts(45.2) == 90.0);
+
+    check(__LINE__, ts.erase_before(48.0) == 16);
+    check(__LINE__, ts.front().first == 48.0);
+
+    ts.pop_front();
+    check(__LINE__, ts.front().first == 48.5);
+}
+
+
+
+//-------------------------------------------------------------------
+void out_of_order_test()
+{
+    auto ts = time_series_map<int,int,interpolator::piecewise_constant>{};
+
+    ts.insert({1,1});
+    ts.insert({5,5});
+    ts.insert({3,3});
+    ts.insert({0,0});
+    ts.insert({9,9});
+
+    check(__LINE__, ts.size() == 5);
+    int prev = -1;
+    for(const auto& n : ts) {
+        check(__LINE__, prev < n.first);
+        prev = n.first;
+    }
+    check(__LINE__, ts.find(3) != ts.end());
+    check(__LINE__, ts.find(4) == ts.end());
+}
+
+
+
+
+//-------------------------------------------------------------------
+int main()
+{
+    try {
+        capacity_test();
+        time_window_test();
+        out_of_order_test();
+    }
+    catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,184 @@
+/*****************************************************************************
+ *
+ * AM utilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+
+#include <stdexcept>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "transforms.h"
+
+
+using namespace am;
+
+
+//-------------------------------------------------------------------
+template<class Map, class Expected>
+void verify(int line, const Map& map, Expected&& expected,
+            double lo, double hi, double tol, std::size_t n = 997)
+{
+    using std::abs;
+    using std::to_string;
+
+    for(std::size_t i = 0; i <= n; ++i) {
+        const double x = lo + (hi - lo) * double(i) / double(n);
+        const double e = expected(x);
+        if(!(abs(map(x) - e) <= tol * (1 + abs(e)))) {
+            throw std::runtime_error{"line " + to_string(line) +
+                ": f(" + to_string(x) + ") = " + to_string(map(x)) +
+                " != " + to_string(e)};
+        }
+    }
+}
+
+
+
+
+//-------------------------------------------------------------------
+void fast_math_test()
+{
+    using std::abs;
+
+    for(double x = 1e-300; x < 1e300; x *= 1.37) {
+        if(abs(fast_log(x) - std::log(x)) > 1e-9 * (1 + abs(std::log(x)))) {
+            throw std::runtime_error{"fast_log: accuracy"};
+        }
+    }
+    for(double x = -700; x < 700; x += 0.731) {
+        if(abs(fast_exp(x) / std::exp(x) - 1) > 1e-9) {
+            throw std::runtime_error{"fast_exp: accuracy"};
+        }
+    }
+    if(fast_exp(1000.0) != HUGE_VAL || fast_exp(-1000.0) != 0 ||
+       fast_log(0.0) != -HUGE_VAL || !std::isnan(fast_log(-1.0)))
+    {
+        throw std::runtime_error{"fast_log/fast_exp: special values"};
+    }
+
+    const auto xs = std::vector<double>{0.5, 1.0, 2.0, 10.0};
+    auto ys = std::vector<double>(xs.size());
+    fast_log(xs.begin(), xs.end(), ys.begin());
+    fast_exp(ys.begin(), ys.end(), ys.begin());
+    for(std::size_t i = 0; i < xs.size(); ++i) {
+        if(abs(ys[i] - xs[i]) > 1e-8 * xs[i]) {
+            throw std::runtime_error{"fast_log/fast_exp: batch"};
+        }
+    }
+}
+
+
+
+
+//-------------------------------------------------------------------
+int main()
+{
+    using std::pow;
+    using std::exp;
+
+    try {
+        fast_math_test();
+
+        static_assert(interpolator::node_cache<
+            interpolator::piecewise_log_log,double,double>::value,
+            "transformed interpolators must provide a node cache");
+
+        //power laws are reproduced exactly by log-log interpolation
+        auto power = [](double x) { return 3.0 * pow(x, -1.7); };
+        auto ll = piecewise_log_log_map<double,double>{};
+        for(double x = 0.1; x < 1000; x *= 3.1) ll.insert({x, power(x)});
+        verify(__LINE__, ll, power, 0.01, 5000, 1e-12);
+
+        //key outside of log domain => boundary value
+        if(ll(-1.0) != ll.begin()->second || ll(0.0) != ll.begin()->second) {
+            throw std::runtime_error{"log-log: non-positive key"};
+        }
+
+        //cache follows modifications
+        ll.erase(ll.begin());
+        ll.insert({0.05, 0.0});
+        ll.erase(ll.begin());
+        verify(__LINE__, ll, power, 0.01, 5000, 1e-12);
+
+        //value updates only re-transform the affected nodes
+        {
+            auto lv = ll;
+            const auto shared = lv;
+            lv.transform_values([](double, double v) { return 2.0 * v; });
+            verify(__LINE__, lv, [&](double x) { return 2.0 * power(x); },
+                   0.01, 5000, 1e-12);
+            verify(__LINE__, shared, power, 0.01, 5000, 1e-12);
+
+            const auto n = lv.size();
+            const auto vals = std::vector<double>{
+                power(lv[n-2].first), power(lv[n-1].first)};
+            lv.assign_values(n-2, vals.begin(), vals.end());
+            const auto fresh = decltype(lv)(lv.begin(), lv.end());
+            for(double x = 0.01; x < 5000; x *= 1.1) {
+                if(lv(x) != fresh(x)) {
+                    throw std::runtime_error{"log-log: refreshed values"};
+                }
+            }
+        }
+
+        //fast log kernels
+        auto fll = transformed_map<double,double,
+                                   transform::fast_log<>,transform::fast_log<>>{
+                       ll.begin(), ll.end()};
+        verify(__LINE__, fll, power, 0.01, 5000, 1e-7);
+
+        //exponential segments
+        auto growth = [](double t) { return 100.0 * exp(0.05 * t); };
+        auto le = piecewise_linear_log_map<int,double>{
+                      {0,growth(0)}, {4,growth(4)}, {10,growth(10)} };
+        for(int t = -5; t < 15; ++t) {
+            if(std::abs(le(t) - growth(t)) > 1e-9) {
+                throw std::runtime_error{"linear-log: exponential growth"};
+            }
+        }
+
+        //decreasing key transform: f = a + b/x
+        auto hyp = [](double x) { return 2.0 + 5.0 / x; };
+        auto rm = transformed_map<double,double,transform::reciprocal>{
+                      {0.5,hyp(0.5)}, {1,hyp(1)}, {4,hyp(4)}, {20,hyp(20)} };
+        verify(__LINE__, rm, hyp, 0.1, 100, 1e-12);
+        rm.assign_values(0, {hyp(0.5) + 1});
+        verify(__LINE__, rm, hyp, 1, 100, 1e-12);
+        if(std::abs(rm(0.5) - hyp(0.5) - 1) > 1e-12) {
+            throw std::runtime_error{"reciprocal: refreshed values"};
+        }
+
+        //logistic curve in logit space is linear
+        auto logistic = [](double x) { return 1.0 / (1.0 + exp(-(0.3*x - 1))); };
+        auto lg = transformed_map<double,double,
+                                  transform::identity,transform::logit>{
+                      {-10,logistic(-10)}, {0,logistic(0)}, {25,logistic(25)} };
+        verify(__LINE__, lg, logistic, -20, 40, 1e-12);
+
+        //sqrt keys
+        auto root = [](double x) { return 1.0 + 2.0 * std::sqrt(x); };
+        auto sm = transformed_map<double,double,transform::sqrt>{
+                      {0,root(0)}, {9,root(9)}, {16,root(16)} };
+        verify(__LINE__, sm, root, 0, 30, 1e-12);
+
+        //uncached evaluation on plain node ranges agrees
+        const auto ipl = interpolator::piecewise_log_log{};
+        for(double x = 0.02; x < 3000; x *= 1.9) {
+            if(std::abs(ipl(ll.begin(), ll.end(), x) - ll(x)) > 1e-12 * ll(x)) {
+                throw std::runtime_error{"log-log: cached != uncached"};
+            }
+        }
+    }
+    catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
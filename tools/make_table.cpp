@@ -0,0 +1,370 @@
+/*****************************************************************************
+ *
+ * AM numeric facilities
+ *
+ * released under MIT license
+ *
+ * 2008-2017 André Müller
+ *
+ *****************************************************************************/
+
+/*****************************************************************************
+ *
+ * make_table: emits a C++ header with a sorted, pre-indexed constexpr node
+ *             table (see static_table_map.h) from a node list;
+ *             tables for piecewise linear interpolation also contain
+ *             the precomputed slope of each segment
+ *
+ * build:  g++ -std=c++14 -O2 -I../include make_table.cpp -o make_table
+ *
+ * usage:  make_table [options] [input file]   (reads stdin if no file given)
+ *
+ *   --name NAME           table variable name (default: table)
+ *   --namespace NS        enclosing namespace (default: none)
+ *   --key-type T          (default: double)
+ *   --value-type T        (default: double)
+ *   --interpolator I      class in namespace am::interpolator
+ *                         (default: piecewise_linear)
+ *   --buckets B           number of index buckets (default: nodes/4,
+ *                         no index for less than 64 nodes; 0: no index)
+ *   -o FILE               output file (default: stdout)
+ *
+ * input: one node per line: "key value" or "key,value" (CSV);
+ *        lines that don't start with 2 numbers (headers, comments)
+ *        are skipped
+ *
+ *****************************************************************************/
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace {
+
+
+//-------------------------------------------------------------------
+struct options
+{
+    std::string name = "table";
+    std::string ns;
+    std::string keyType = "double";
+    std::string valueType = "double";
+    std::string interpolator = "piecewise_linear";
+    long long buckets = -1;
+    std::string input;
+    std::string output;
+};
+
+
+using node_list = std::vector<std::pair<double,double>>;
+
+
+
+//-------------------------------------------------------------------
+bool is_floating_point_type(const std::string& type)
+{
+    return type.find("float") != std::string::npos ||
+           type.find("double") != std::string::npos;
+}
+
+
+
+//-------------------------------------------------------------------
+/// same condition as detail::has_table_slopes in static_table_map.h
+bool has_slopes(const options& opt)
+{
+    const auto& ipl = opt.interpolator;
+    const bool linear = ipl == "piecewise_linear" ||
+        (ipl.compare(0, 23, "basic_piecewise_linear<") == 0 &&
+         ipl.find(',') == std::string::npos);
+
+    return linear &&
+           opt.keyType.find("long double") == std::string::npos &&
+           opt.valueType.find("long double") == std::string::npos;
+}
+
+
+
+//-------------------------------------------------------------------
+/// nearest number that is representable in type
+double representable(double x, const std::string& type)
+{
+    if(type == "float") return double(float(x));
+    return x;
+}
+
+//-----------------------------------------------------
+/// a - b computed in type (as the interpolator does)
+double difference(double a, double b, const std::string& type)
+{
+    if(type == "float") return double(float(a) - float(b));
+    if(is_floating_point_type(type)) return a - b;
+    return double(static_cast<long long>(a) - static_cast<long long>(b));
+}
+
+
+
+//-------------------------------------------------------------------
+options parse_options(int argc, char* argv[])
+{
+    options opt;
+
+    for(int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+
+        auto next = [&]() -> std::string {
+            if(i + 1 >= argc) {
+                throw std::invalid_argument{"missing value for " + arg};
+            }
+            return argv[++i];
+        };
+
+        if(arg == "--name")              opt.name = next();
+        else if(arg == "--namespace")    opt.ns = next();
+        else if(arg == "--key-type")     opt.keyType = next();
+        else if(arg == "--value-type")   opt.valueType = next();
+        else if(arg == "--interpolator") opt.interpolator = next();
+        else if(arg == "--buckets")      opt.buckets = std::stoll(next());
+        else if(arg == "-o")             opt.output = next();
+        else if(!arg.empty() && arg[0] == '-' && arg != "-") {
+            throw std::invalid_argument{"unknown option " + arg};
+        }
+        else opt.input = arg;
+    }
+    return opt;
+}
+
+
+
+//-------------------------------------------------------------------
+node_list read_nodes(std::istream& is)
+{
+    node_list nodes;
+
+    std::string line;
+    while(std::getline(is, line)) {
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::replace(line.begin(), line.end(), ';', ' ');
+
+        const char* p = line.c_str();
+        char* end = nullptr;
+
+        errno = 0;
+        const double k = std::strtod(p, &end);
+        if(end == p || errno == ERANGE) continue;
+        p = end;
+        const double v = std::strtod(p, &end);
+        if(end == p || errno == ERANGE) continue;
+
+        nodes.emplace_back(k, v);
+    }
+
+    //stable => order of nodes with equal keys is preserved
+    std::stable_sort(nodes.begin(), nodes.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    return nodes;
+}
+
+
+
+//-------------------------------------------------------------------
+std::string literal(double x, const std::string& type)
+{
+    if(!std::isfinite(x)) {
+        throw std::invalid_argument{"non-finite number in input"};
+    }
+    std::ostringstream os;
+    if(is_floating_point_type(type)) {
+        os.precision(std::numeric_limits<double>::max_digits10);
+        os << x;
+        if(os.str().find_first_of(".en") == std::string::npos) os << ".0";
+        if(type == "float") os << 'f';
+    }
+    else {
+        if(std::floor(x) != x) {
+            throw std::invalid_argument{"non-integer number " +
+                std::to_string(x) + " for type " + type};
+        }
+        os << static_cast<long long>(x);
+    }
+    return os.str();
+}
+
+
+
+//-------------------------------------------------------------------
+/// same arithmetic as basic_piecewise_linear (0 for equal keys)
+std::vector<double>
+segment_slopes(const node_list& nodes, const options& opt)
+{
+    std::vector<double> slopes;
+    slopes.reserve(nodes.size());
+    for(std::size_t i = 1; i < nodes.size(); ++i) {
+        const double dk = difference(nodes[i].first, nodes[i-1].first,
+                                     opt.keyType);
+        const double dv = difference(nodes[i].second, nodes[i-1].second,
+                                     opt.valueType);
+        slopes.push_back(dk != 0 ? dv / dk : 0.0);
+    }
+    return slopes;
+}
+
+
+
+//-------------------------------------------------------------------
+/// same arithmetic as static_table_map::range
+std::vector<std::uint32_t>
+bucket_index(const node_list& nodes, std::size_t buckets, double scale)
+{
+    if(buckets == 0) return {};
+    std::vector<std::uint32_t> index(buckets + 1, std::uint32_t(nodes.size()));
+
+    const double lo = nodes.front().first;
+
+    std::size_t b = 0;
+    for(std::size_t i = 0; i < nodes.size(); ++i) {
+        const double u = (nodes[i].first - lo) * scale;
+        const auto bi = u > 0
+            ? (u < double(buckets) ? std::size_t(u) : buckets - 1)
+            : std::size_t(0);
+
+        for(; b <= bi; ++b) index[b] = std::uint32_t(i);
+    }
+    return index;
+}
+
+
+
+//-------------------------------------------------------------------
+void write_header(std::ostream& os, const node_list& nodes, const options& opt)
+{
+    const std::size_t n = nodes.size();
+
+    std::size_t buckets = opt.buckets >= 0
+        ? std::size_t(opt.buckets)
+        : (n < 64 ? 0 : n / 4);
+
+    const double range = nodes.back().first - nodes.front().first;
+    if(!(range > 0)) buckets = 0;
+
+    const double scale = buckets > 0 ? double(buckets) / range : 0.0;
+
+    const auto index = bucket_index(nodes, buckets, scale);
+
+    std::string guard = "AMLIB_TABLE_" + opt.ns + "_" + opt.name + "_H_";
+    for(auto& c : guard) {
+        c = std::isalnum(static_cast<unsigned char>(c))
+            ? char(std::toupper(static_cast<unsigned char>(c))) : '_';
+    }
+
+    const std::string type = opt.name + "_type";
+
+    os << "// generated by make_table - do not edit\n\n"
+       << "#ifndef " << guard << "\n"
+       << "#define " << guard << "\n\n"
+       << "#include \"static_table_map.h\"\n\n";
+
+    if(!opt.ns.empty()) os << "namespace " << opt.ns << " {\n\n";
+
+    os << "using " << type << " = am::static_table_map<"
+       << opt.keyType << ", " << opt.valueType << ", " << n << ",\n"
+       << "    am::interpolator::" << opt.interpolator << ", "
+       << buckets << ">;\n\n";
+
+    os << "constexpr " << type << " " << opt.name << " {\n"
+       << "    " << type << "::node_array{{\n";
+    for(const auto& x : nodes) {
+        os << "        {" << literal(x.first, opt.keyType) << ", "
+           << literal(x.second, opt.valueType) << "},\n";
+    }
+    os << "    }}";
+
+    //numbers, 8 per line
+    auto write_array = [&](const char* name, const auto& values) {
+        os << ",\n    " << type << "::" << name << "{{";
+        for(std::size_t i = 0; i < values.size(); ++i) {
+            if(i > 0) os << ',';
+            os << (i % 8 == 0 ? "\n        " : " ") << values[i];
+        }
+        os << "\n    }}";
+    };
+
+    if(has_slopes(opt)) {
+        std::vector<std::string> slopes;
+        for(double s : segment_slopes(nodes, opt)) {
+            slopes.push_back(literal(s, "double"));
+        }
+        write_array("slope_array", slopes);
+    }
+    if(buckets > 0) {
+        write_array("index_array", index);
+        os << ",\n    " << literal(scale, "double");
+    }
+    os << "\n};\n\n";
+
+    if(!opt.ns.empty()) os << "} // namespace " << opt.ns << "\n\n";
+
+    os << "#endif\n";
+}
+
+
+} // namespace
+
+
+
+
+//-------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    try {
+        const auto opt = parse_options(argc, argv);
+
+        node_list nodes;
+        if(opt.input.empty() || opt.input == "-") {
+            nodes = read_nodes(std::cin);
+        } else {
+            std::ifstream is{opt.input};
+            if(!is.good()) {
+                throw std::runtime_error{"can't open " + opt.input};
+            }
+            nodes = read_nodes(is);
+        }
+        if(nodes.empty()) {
+            throw std::runtime_error{"no nodes found in input"};
+        }
+        if(nodes.size() >= std::numeric_limits<std::uint32_t>::max()) {
+            throw std::runtime_error{"too many nodes"};
+        }
+        for(auto& x : nodes) {
+            x.first = representable(x.first, opt.keyType);
+            x.second = representable(x.second, opt.valueType);
+        }
+
+        if(opt.output.empty()) {
+            write_header(std::cout, nodes, opt);
+        } else {
+            std::ofstream os{opt.output};
+            write_header(os, nodes, opt);
+            if(!os.good()) {
+                throw std::runtime_error{"can't write " + opt.output};
+            }
+        }
+    }
+    catch(std::exception& e) {
+        std::cerr << "make_table: " << e.what() << std::endl;
+        return 1;
+    }
+}